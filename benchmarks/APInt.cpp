@@ -0,0 +1,82 @@
+//===- APInt.cpp - APInt benchmarks ---------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Benchmark.h"
+#include "Inputs.h"
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/ArrayRef.h"
+
+using namespace llvm;
+
+/// Returns 256 random values of \p BitWidth bits. Widths up to 64 bits are
+/// stored inline, wider ones on the heap.
+static std::vector<APInt> randomValues(unsigned BitWidth) {
+  std::vector<uint64_t> Words =
+      bench::randomIntegers(256 * APInt::getNumWords(BitWidth));
+  std::vector<APInt> Values;
+  for (size_t I = 0; I != 256; ++I) {
+    unsigned NumWords = APInt::getNumWords(BitWidth);
+    APInt V(BitWidth, makeArrayRef(&Words[I * NumWords], NumWords));
+    // Keep divisors non-zero.
+    V.setBit(0);
+    Values.push_back(V);
+  }
+  return Values;
+}
+
+static void BM_APIntAdd(benchmark::State &State) {
+  std::vector<APInt> Values = randomValues(State.range(0));
+  while (State.KeepRunning())
+    for (size_t I = 0, E = Values.size(); I + 1 < E; ++I)
+      benchmark::DoNotOptimize(Values[I] + Values[I + 1]);
+  State.SetItemsProcessed(State.iterations() * (Values.size() - 1));
+}
+BENCHMARK(BM_APIntAdd)->Arg(32)->Arg(64)->Arg(128)->Arg(1024);
+
+static void BM_APIntMul(benchmark::State &State) {
+  std::vector<APInt> Values = randomValues(State.range(0));
+  while (State.KeepRunning())
+    for (size_t I = 0, E = Values.size(); I + 1 < E; ++I)
+      benchmark::DoNotOptimize(Values[I] * Values[I + 1]);
+  State.SetItemsProcessed(State.iterations() * (Values.size() - 1));
+}
+BENCHMARK(BM_APIntMul)->Arg(32)->Arg(64)->Arg(128)->Arg(1024);
+
+static void BM_APIntUDiv(benchmark::State &State) {
+  std::vector<APInt> Values = randomValues(State.range(0));
+  // Divide by values with half the active bits so the quotient is non-trivial.
+  for (APInt &V : Values)
+    V.lshrInPlace(V.getBitWidth() / 2);
+  std::vector<APInt> Dividends = randomValues(State.range(0));
+  while (State.KeepRunning())
+    for (size_t I = 0, E = Values.size(); I != E; ++I)
+      benchmark::DoNotOptimize(Dividends[I].udiv(Values[I] | 1));
+  State.SetItemsProcessed(State.iterations() * Values.size());
+}
+BENCHMARK(BM_APIntUDiv)->Arg(32)->Arg(64)->Arg(128)->Arg(1024);
+
+static void BM_APIntShiftAndCompare(benchmark::State &State) {
+  std::vector<APInt> Values = randomValues(State.range(0));
+  unsigned BitWidth = State.range(0);
+  while (State.KeepRunning())
+    for (size_t I = 0, E = Values.size(); I + 1 < E; ++I)
+      benchmark::DoNotOptimize(
+          Values[I].shl(I % BitWidth).ult(Values[I + 1].lshr(3)));
+  State.SetItemsProcessed(State.iterations() * (Values.size() - 1));
+}
+BENCHMARK(BM_APIntShiftAndCompare)->Arg(32)->Arg(64)->Arg(128)->Arg(1024);
+
+static void BM_APIntToString(benchmark::State &State) {
+  std::vector<APInt> Values = randomValues(State.range(0));
+  while (State.KeepRunning())
+    for (const APInt &V : Values)
+      benchmark::DoNotOptimize(V.toString(10, /*Signed=*/false));
+  State.SetItemsProcessed(State.iterations() * Values.size());
+}
+BENCHMARK(BM_APIntToString)->Arg(64)->Arg(128)->Arg(1024);
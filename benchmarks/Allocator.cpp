@@ -0,0 +1,83 @@
+//===- Allocator.cpp - BumpPtrAllocator benchmarks ------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Benchmark.h"
+#include "Inputs.h"
+#include "llvm/Support/Allocator.h"
+#include <cstdlib>
+
+using namespace llvm;
+
+/// Returns \p N allocation sizes resembling IR and AST nodes: mostly between
+/// 16 and 128 bytes, with the occasional large array.
+static std::vector<size_t> allocationSizes(size_t N) {
+  std::mt19937_64 Engine = bench::makeEngine();
+  std::vector<size_t> Sizes;
+  for (size_t I = 0; I != N; ++I)
+    Sizes.push_back(Engine() % 64 == 0 ? 512 + Engine() % 4096
+                                       : 16 + 8 * (Engine() % 15));
+  return Sizes;
+}
+
+static void BM_BumpPtrAllocate(benchmark::State &State) {
+  std::vector<size_t> Sizes = allocationSizes(State.range(0));
+  BumpPtrAllocator Alloc;
+  while (State.KeepRunning()) {
+    for (size_t Size : Sizes)
+      benchmark::DoNotOptimize(Alloc.Allocate(Size, 8));
+    // Reset keeps the first slab, so the steady state does not call malloc
+    // for small inputs.
+    Alloc.Reset();
+  }
+  State.SetItemsProcessed(State.iterations() * Sizes.size());
+}
+BENCHMARK(BM_BumpPtrAllocate)->Range(64, 1 << 18);
+
+static void BM_BumpPtrAllocateFresh(benchmark::State &State) {
+  // Includes the cost of acquiring and releasing the slabs.
+  std::vector<size_t> Sizes = allocationSizes(State.range(0));
+  while (State.KeepRunning()) {
+    BumpPtrAllocator Alloc;
+    for (size_t Size : Sizes)
+      benchmark::DoNotOptimize(Alloc.Allocate(Size, 8));
+  }
+  State.SetItemsProcessed(State.iterations() * Sizes.size());
+}
+BENCHMARK(BM_BumpPtrAllocateFresh)->Range(64, 1 << 18);
+
+static void BM_MallocFree(benchmark::State &State) {
+  // The baseline the bump allocator is meant to beat.
+  std::vector<size_t> Sizes = allocationSizes(State.range(0));
+  std::vector<void *> Ptrs(Sizes.size());
+  while (State.KeepRunning()) {
+    for (size_t I = 0, E = Sizes.size(); I != E; ++I)
+      Ptrs[I] = malloc(Sizes[I]);
+    benchmark::ClobberMemory();
+    for (void *P : Ptrs)
+      free(P);
+  }
+  State.SetItemsProcessed(State.iterations() * Sizes.size());
+}
+BENCHMARK(BM_MallocFree)->Range(64, 1 << 18);
+
+static void BM_SpecificBumpPtrAllocator(benchmark::State &State) {
+  // SpecificBumpPtrAllocator runs destructors on Reset.
+  struct Object {
+    std::vector<int> Members;
+  };
+  int64_t N = State.range(0);
+  SpecificBumpPtrAllocator<Object> Alloc;
+  while (State.KeepRunning()) {
+    for (int64_t I = 0; I != N; ++I)
+      new (Alloc.Allocate()) Object();
+    Alloc.DestroyAll();
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_SpecificBumpPtrAllocator)->Range(64, 1 << 16);
@@ -0,0 +1,289 @@
+//===- Benchmark.cpp - Minimal microbenchmark framework -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the benchmark registry and the runner which calibrates
+// the iteration count of every benchmark and reports the results either as a
+// table or in the JSON format of Google Benchmark.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Benchmark.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Regex.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+using namespace llvm;
+using namespace benchmark;
+
+// The option names follow Google Benchmark so that existing scripts work.
+static cl::opt<std::string>
+    Filter("benchmark_filter", cl::init("."),
+           cl::desc("Only run the benchmarks whose name matches this regex"));
+
+static cl::opt<bool> ListTests("benchmark_list_tests",
+                               cl::desc("List the benchmarks and exit"));
+
+enum OutputFormat { OF_Console, OF_JSON };
+static cl::opt<OutputFormat> Format(
+    "benchmark_format", cl::init(OF_Console),
+    cl::desc("Format of the results printed to stdout"),
+    cl::values(clEnumValN(OF_Console, "console", "A human readable table"),
+               clEnumValN(OF_JSON, "json", "Google Benchmark JSON")));
+
+static cl::opt<std::string>
+    OutputFile("benchmark_out",
+               cl::desc("Also write the results as JSON to this file"));
+
+static cl::opt<double>
+    MinTime("benchmark_min_time", cl::init(0.5),
+            cl::desc("Minimum number of seconds to run each benchmark for"));
+
+static cl::opt<unsigned> Repetitions(
+    "benchmark_repetitions", cl::init(1),
+    cl::desc("Number of times to repeat each benchmark; with more than one "
+             "repetition the mean, median and standard deviation are reported "
+             "as well"));
+
+static ManagedStatic<std::vector<std::unique_ptr<Benchmark>>> Registry;
+
+Benchmark *benchmark::RegisterBenchmark(const char *Name,
+                                        Benchmark::Function Fn) {
+  Registry->emplace_back(new Benchmark(Name, Fn));
+  return Registry->back().get();
+}
+
+Benchmark *Benchmark::Arg(int64_t A) {
+  Args.push_back(A);
+  return this;
+}
+
+Benchmark *Benchmark::Range(int64_t Lo, int64_t Hi) {
+  Args.push_back(Lo);
+  for (int64_t I = 1; I < Hi; I *= 8)
+    if (I > Lo)
+      Args.push_back(I);
+  if (Hi > Lo)
+    Args.push_back(Hi);
+  return this;
+}
+
+State::State(uint64_t MaxIterations, std::vector<int64_t> Args)
+    : MaxIterations(MaxIterations), Args(std::move(Args)) {}
+
+namespace {
+/// The measurement of one benchmark instance, or an aggregate of several.
+struct Result {
+  std::string Name;
+  uint64_t Iterations;
+  /// Time per iteration in nanoseconds.
+  double RealTime;
+  double CPUTime;
+  double ItemsPerSecond;
+  double BytesPerSecond;
+};
+} // end anonymous namespace
+
+static Result runOnce(const Benchmark &B, const std::string &Name,
+                      std::vector<int64_t> Args) {
+  // Grow the iteration count until a run takes at least MinTime, like Google
+  // Benchmark does.
+  uint64_t Iterations = 1;
+  while (true) {
+    State S(Iterations, Args);
+    B.getFunction()(S);
+    double Seconds = S.getRealSeconds();
+    if (Seconds >= MinTime || Iterations >= 1000000000) {
+      Result R;
+      R.Name = Name;
+      R.Iterations = Iterations;
+      R.RealTime = Seconds * 1e9 / Iterations;
+      R.CPUTime = S.getCPUSeconds() * 1e9 / Iterations;
+      R.ItemsPerSecond = Seconds > 0 ? S.getItemsProcessed() / Seconds : 0;
+      R.BytesPerSecond = Seconds > 0 ? S.getBytesProcessed() / Seconds : 0;
+      return R;
+    }
+    // Aim a little past MinTime, but never grow by more than 10x at once.
+    double Multiplier = Seconds > 0 ? MinTime * 1.4 / Seconds : 10;
+    Multiplier = std::min(std::max(Multiplier, 2.0), 10.0);
+    Iterations = uint64_t(Iterations * Multiplier);
+  }
+}
+
+/// Appends the mean, median and standard deviation of \p Runs to \p Results.
+static void addAggregates(const std::string &Name, std::vector<Result> Runs,
+                          std::vector<Result> &Results) {
+  auto Aggregate = [&](StringRef Suffix, function_ref<double(double Result::*)>
+                                             Compute) {
+    Result R;
+    R.Name = Name + "_" + Suffix.str();
+    R.Iterations = Runs.front().Iterations;
+    R.RealTime = Compute(&Result::RealTime);
+    R.CPUTime = Compute(&Result::CPUTime);
+    R.ItemsPerSecond = Compute(&Result::ItemsPerSecond);
+    R.BytesPerSecond = Compute(&Result::BytesPerSecond);
+    Results.push_back(R);
+  };
+  auto Mean = [&](double Result::*Field) {
+    double Sum = 0;
+    for (const Result &R : Runs)
+      Sum += R.*Field;
+    return Sum / Runs.size();
+  };
+  Aggregate("mean", Mean);
+  Aggregate("median", [&](double Result::*Field) {
+    std::vector<double> Values;
+    for (const Result &R : Runs)
+      Values.push_back(R.*Field);
+    std::sort(Values.begin(), Values.end());
+    size_t Mid = Values.size() / 2;
+    return Values.size() % 2 ? Values[Mid]
+                             : (Values[Mid - 1] + Values[Mid]) / 2;
+  });
+  Aggregate("stddev", [&](double Result::*Field) {
+    double M = Mean(Field), Sum = 0;
+    for (const Result &R : Runs)
+      Sum += (R.*Field - M) * (R.*Field - M);
+    return Runs.size() > 1 ? std::sqrt(Sum / (Runs.size() - 1)) : 0.0;
+  });
+}
+
+static void printJSON(raw_ostream &OS, const std::vector<Result> &Results,
+                      StringRef Executable) {
+  OS << "{\n  \"context\": {\n"
+     << "    \"executable\": \"";
+  OS.write_escaped(Executable);
+  OS << "\",\n"
+     << "    \"num_cpus\": " << sys::getHostNumPhysicalCores() << ",\n"
+#ifdef NDEBUG
+     << "    \"library_build_type\": \"release\"\n"
+#else
+     << "    \"library_build_type\": \"debug\"\n"
+#endif
+     << "  },\n  \"benchmarks\": [";
+  for (size_t I = 0, E = Results.size(); I != E; ++I) {
+    const Result &R = Results[I];
+    OS << (I ? ",\n" : "\n") << "    {\n"
+       << "      \"name\": \"" << R.Name << "\",\n"
+       << "      \"iterations\": " << R.Iterations << ",\n"
+       << "      \"real_time\": " << format("%.2f", R.RealTime) << ",\n"
+       << "      \"cpu_time\": " << format("%.2f", R.CPUTime) << ",\n"
+       << "      \"time_unit\": \"ns\"";
+    if (R.ItemsPerSecond)
+      OS << ",\n      \"items_per_second\": "
+         << format("%.2f", R.ItemsPerSecond);
+    if (R.BytesPerSecond)
+      OS << ",\n      \"bytes_per_second\": "
+         << format("%.2f", R.BytesPerSecond);
+    OS << "\n    }";
+  }
+  OS << "\n  ]\n}\n";
+}
+
+static void printConsoleHeader(raw_ostream &OS) {
+  OS << left_justify("Benchmark", 48) << right_justify("Time", 15)
+     << right_justify("CPU", 15) << right_justify("Iterations", 13) << "\n";
+  OS << std::string(91, '-') << "\n";
+}
+
+static void printConsole(raw_ostream &OS, const Result &R) {
+  OS << format("%-48s %11.0f ns %11.0f ns %12llu", R.Name.c_str(), R.RealTime,
+               R.CPUTime, (unsigned long long)R.Iterations);
+  if (R.ItemsPerSecond)
+    OS << format(" %10.3fM items/s", R.ItemsPerSecond / 1e6);
+  if (R.BytesPerSecond)
+    OS << format(" %10.3fMB/s", R.BytesPerSecond / (1 << 20));
+  OS << "\n";
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal(argv[0]);
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y;
+  cl::ParseCommandLineOptions(argc, argv, "LLVM ADT and Support benchmarks\n");
+
+  std::string RegexError;
+  Regex FilterRegex(Filter);
+  if (!FilterRegex.isValid(RegexError)) {
+    errs() << argv[0] << ": invalid -benchmark_filter: " << RegexError << "\n";
+    return 1;
+  }
+
+  // Expand every benchmark into one instance per argument.
+  std::vector<std::pair<const Benchmark *, std::vector<int64_t>>> Instances;
+  std::vector<std::string> Names;
+  for (const auto &B : *Registry) {
+    std::vector<std::vector<int64_t>> ArgSets;
+    if (B->getArgs().empty())
+      ArgSets.emplace_back();
+    for (int64_t A : B->getArgs())
+      ArgSets.push_back({A});
+    for (auto &Args : ArgSets) {
+      std::string Name = B->getName();
+      if (!Args.empty())
+        Name += "/" + std::to_string(Args[0]);
+      if (!FilterRegex.match(Name))
+        continue;
+      Instances.emplace_back(B.get(), std::move(Args));
+      Names.push_back(std::move(Name));
+    }
+  }
+
+  if (ListTests) {
+    for (const std::string &Name : Names)
+      outs() << Name << "\n";
+    return 0;
+  }
+
+  if (Format == OF_Console)
+    printConsoleHeader(outs());
+
+  std::vector<Result> Results;
+  for (size_t I = 0, E = Instances.size(); I != E; ++I) {
+    std::vector<Result> Runs;
+    for (unsigned Rep = 0; Rep < std::max(1u, unsigned(Repetitions)); ++Rep) {
+      Runs.push_back(
+          runOnce(*Instances[I].first, Names[I], Instances[I].second));
+      if (Format == OF_Console)
+        printConsole(outs(), Runs.back());
+    }
+    size_t FirstAggregate = Results.size() + Runs.size();
+    Results.insert(Results.end(), Runs.begin(), Runs.end());
+    if (Runs.size() > 1) {
+      addAggregates(Names[I], std::move(Runs), Results);
+      if (Format == OF_Console)
+        for (size_t J = FirstAggregate; J < Results.size(); ++J)
+          printConsole(outs(), Results[J]);
+    }
+  }
+
+  if (Format == OF_JSON)
+    printJSON(outs(), Results, argv[0]);
+
+  if (!OutputFile.empty()) {
+    std::error_code EC;
+    raw_fd_ostream OS(OutputFile, EC, sys::fs::F_Text);
+    if (EC) {
+      errs() << argv[0] << ": " << OutputFile << ": " << EC.message() << "\n";
+      return 1;
+    }
+    printJSON(OS, Results, argv[0]);
+  }
+  return 0;
+}
@@ -0,0 +1,153 @@
+//===- Benchmark.h - Minimal microbenchmark framework -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a small, dependency free subset of the Google Benchmark
+// API (https://github.com/google/benchmark): benchmark::State,
+// benchmark::DoNotOptimize, benchmark::ClobberMemory and the BENCHMARK macro
+// with its Arg/Range modifiers.
+//
+// The library itself is not part of the source tree and the benchmarks must
+// build offline, so this header provides just enough of it for the benchmarks
+// in this directory. Sticking to the upstream spelling keeps them source
+// compatible with the real library, and the runner writes the same JSON
+// schema, so results can be compared across commits with the usual tools.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_BENCHMARKS_BENCHMARK_H
+#define LLVM_BENCHMARKS_BENCHMARK_H
+
+#include "llvm/Support/Compiler.h"
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace benchmark {
+
+/// The state of a single benchmark run, driving its timing loop.
+///
+/// \code
+///   static void BM_Foo(benchmark::State &State) {
+///     while (State.KeepRunning())
+///       benchmark::DoNotOptimize(foo(State.range(0)));
+///   }
+///   BENCHMARK(BM_Foo)->Range(8, 8 << 10);
+/// \endcode
+class State {
+public:
+  State(uint64_t MaxIterations, std::vector<int64_t> Args);
+
+  /// Returns true while the body of the benchmark loop should execute another
+  /// time. The timer starts with the first call and stops with the last one.
+  bool KeepRunning() {
+    if (Iterations == 0)
+      startTimer();
+    if (Iterations < MaxIterations) {
+      ++Iterations;
+      return true;
+    }
+    stopTimer();
+    return false;
+  }
+
+  /// Returns the argument the benchmark was registered with.
+  int64_t range(unsigned Idx = 0) const { return Args[Idx]; }
+
+  /// Excludes the code between PauseTiming and ResumeTiming, typically the
+  /// per-iteration setup, from the measurement.
+  void PauseTiming() { stopTimer(); }
+  void ResumeTiming() { startTimer(); }
+
+  void SetItemsProcessed(int64_t Items) { ItemsProcessed = Items; }
+  void SetBytesProcessed(int64_t Bytes) { BytesProcessed = Bytes; }
+
+  uint64_t iterations() const { return Iterations; }
+  double getRealSeconds() const { return RealSeconds; }
+  double getCPUSeconds() const { return CPUSeconds; }
+  int64_t getItemsProcessed() const { return ItemsProcessed; }
+  int64_t getBytesProcessed() const { return BytesProcessed; }
+
+private:
+  void startTimer() {
+    RealStart = std::chrono::steady_clock::now();
+    CPUStart = std::clock();
+  }
+  void stopTimer() {
+    RealSeconds += std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - RealStart)
+                       .count();
+    CPUSeconds += double(std::clock() - CPUStart) / CLOCKS_PER_SEC;
+  }
+
+  uint64_t Iterations = 0;
+  uint64_t MaxIterations;
+  std::vector<int64_t> Args;
+  std::chrono::steady_clock::time_point RealStart;
+  std::clock_t CPUStart = 0;
+  double RealSeconds = 0;
+  double CPUSeconds = 0;
+  int64_t ItemsProcessed = 0;
+  int64_t BytesProcessed = 0;
+};
+
+/// A registered benchmark function together with the arguments to run it with.
+class Benchmark {
+public:
+  typedef void (*Function)(State &);
+
+  Benchmark(const char *Name, Function Fn) : Name(Name), Fn(Fn) {}
+
+  /// Runs the benchmark once with argument \p Arg.
+  Benchmark *Arg(int64_t Arg);
+
+  /// Runs the benchmark with \p Lo, \p Hi and the powers of 8 in between.
+  Benchmark *Range(int64_t Lo, int64_t Hi);
+
+  const std::string &getName() const { return Name; }
+  Function getFunction() const { return Fn; }
+  const std::vector<int64_t> &getArgs() const { return Args; }
+
+private:
+  std::string Name;
+  Function Fn;
+  std::vector<int64_t> Args;
+};
+
+/// Adds a benchmark to the global registry. Used by the BENCHMARK macro.
+Benchmark *RegisterBenchmark(const char *Name, Benchmark::Function Fn);
+
+/// Prevents the compiler from optimizing away the computation of \p Value.
+template <class T> inline void DoNotOptimize(T const &Value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "r,m"(Value) : "memory");
+#else
+  static const void *volatile Sink;
+  Sink = &Value;
+#endif
+}
+
+/// Forces all pending memory writes to be considered observable.
+inline void ClobberMemory() {
+#if defined(__GNUC__)
+  asm volatile("" : : : "memory");
+#endif
+}
+
+} // end namespace benchmark
+
+#define BENCHMARK_CONCAT2(A, B) A##B
+#define BENCHMARK_CONCAT(A, B) BENCHMARK_CONCAT2(A, B)
+#define BENCHMARK(Fn)                                                          \
+  static ::benchmark::Benchmark *BENCHMARK_CONCAT(BenchmarkRegistration_,      \
+                                                  __LINE__)                    \
+      LLVM_ATTRIBUTE_UNUSED = ::benchmark::RegisterBenchmark(#Fn, Fn)
+
+#endif // LLVM_BENCHMARKS_BENCHMARK_H
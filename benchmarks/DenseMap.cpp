@@ -0,0 +1,112 @@
+//===- DenseMap.cpp - DenseMap benchmarks ---------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Benchmark.h"
+#include "Inputs.h"
+#include "llvm/ADT/DenseMap.h"
+
+using namespace llvm;
+
+static void BM_DenseMapInsertPointers(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  std::vector<void *> Keys = bench::allocatorPointers(State.range(0), Alloc);
+  while (State.KeepRunning()) {
+    DenseMap<void *, unsigned> Map;
+    for (unsigned I = 0, E = Keys.size(); I != E; ++I)
+      Map[Keys[I]] = I;
+    benchmark::DoNotOptimize(Map);
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_DenseMapInsertPointers)->Range(8, 1 << 18);
+
+static void BM_DenseMapInsertRandom(benchmark::State &State) {
+  std::vector<uint64_t> Keys = bench::randomIntegers(State.range(0));
+  while (State.KeepRunning()) {
+    DenseMap<uint64_t, unsigned> Map;
+    for (unsigned I = 0, E = Keys.size(); I != E; ++I)
+      Map[Keys[I]] = I;
+    benchmark::DoNotOptimize(Map);
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_DenseMapInsertRandom)->Range(8, 1 << 18);
+
+static void BM_DenseMapInsertReserved(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  std::vector<void *> Keys = bench::allocatorPointers(State.range(0), Alloc);
+  while (State.KeepRunning()) {
+    DenseMap<void *, unsigned> Map(Keys.size());
+    for (unsigned I = 0, E = Keys.size(); I != E; ++I)
+      Map[Keys[I]] = I;
+    benchmark::DoNotOptimize(Map);
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_DenseMapInsertReserved)->Range(8, 1 << 18);
+
+static void BM_DenseMapLookupHit(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  std::vector<void *> Keys = bench::allocatorPointers(State.range(0), Alloc);
+  DenseMap<void *, unsigned> Map;
+  for (unsigned I = 0, E = Keys.size(); I != E; ++I)
+    Map[Keys[I]] = I;
+  std::vector<size_t> Order = bench::zipfIndices(1024, Keys.size());
+  while (State.KeepRunning())
+    for (size_t Idx : Order)
+      benchmark::DoNotOptimize(Map.find(Keys[Idx]));
+  State.SetItemsProcessed(State.iterations() * Order.size());
+}
+BENCHMARK(BM_DenseMapLookupHit)->Range(8, 1 << 18);
+
+static void BM_DenseMapLookupMiss(benchmark::State &State) {
+  std::vector<uint64_t> Keys = bench::randomIntegers(2 * State.range(0));
+  DenseMap<uint64_t, unsigned> Map;
+  for (unsigned I = 0, E = Keys.size() / 2; I != E; ++I)
+    Map[Keys[I]] = I;
+  while (State.KeepRunning())
+    for (size_t I = Keys.size() / 2, E = Keys.size(); I != E; ++I)
+      benchmark::DoNotOptimize(Map.count(Keys[I]));
+  State.SetItemsProcessed(State.iterations() * (Keys.size() / 2));
+}
+BENCHMARK(BM_DenseMapLookupMiss)->Range(8, 1 << 18);
+
+static void BM_DenseMapEraseInsert(benchmark::State &State) {
+  // Erasing leaves tombstones behind; this measures the steady state of a map
+  // used as a worklist index.
+  std::vector<uint64_t> Keys = bench::randomIntegers(2 * State.range(0));
+  size_t N = Keys.size() / 2;
+  DenseMap<uint64_t, unsigned> Map;
+  for (unsigned I = 0; I != N; ++I)
+    Map[Keys[I]] = I;
+  size_t Next = N;
+  while (State.KeepRunning()) {
+    size_t Old = (Next - N) % Keys.size();
+    Map.erase(Keys[Old]);
+    Map[Keys[Next % Keys.size()]] = Next;
+    ++Next;
+  }
+  State.SetItemsProcessed(State.iterations());
+}
+BENCHMARK(BM_DenseMapEraseInsert)->Range(8, 1 << 18);
+
+static void BM_DenseMapIterate(benchmark::State &State) {
+  std::vector<uint64_t> Keys = bench::randomIntegers(State.range(0));
+  DenseMap<uint64_t, unsigned> Map;
+  for (unsigned I = 0, E = Keys.size(); I != E; ++I)
+    Map[Keys[I]] = I;
+  while (State.KeepRunning()) {
+    unsigned Sum = 0;
+    for (const auto &KV : Map)
+      Sum += KV.second;
+    benchmark::DoNotOptimize(Sum);
+  }
+  State.SetItemsProcessed(State.iterations() * Keys.size());
+}
+BENCHMARK(BM_DenseMapIterate)->Range(8, 1 << 18);
@@ -0,0 +1,91 @@
+//===- FoldingSet.cpp - FoldingSet benchmarks -----------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Benchmark.h"
+#include "Inputs.h"
+#include "llvm/ADT/FoldingSet.h"
+
+using namespace llvm;
+
+namespace {
+/// A node uniqued on an opcode and a few operands, like SCEVs and SDNodes.
+struct Node : FoldingSetNode {
+  unsigned Opcode;
+  const void *Ops[2];
+
+  Node(unsigned Opcode, const void *LHS, const void *RHS) : Opcode(Opcode) {
+    Ops[0] = LHS;
+    Ops[1] = RHS;
+  }
+
+  static void profile(FoldingSetNodeID &ID, unsigned Opcode, const void *LHS,
+                      const void *RHS) {
+    ID.AddInteger(Opcode);
+    ID.AddPointer(LHS);
+    ID.AddPointer(RHS);
+  }
+  void Profile(FoldingSetNodeID &ID) const {
+    profile(ID, Opcode, Ops[0], Ops[1]);
+  }
+};
+
+struct Operation {
+  unsigned Opcode;
+  const void *LHS, *RHS;
+};
+} // end anonymous namespace
+
+/// Returns \p N operations over a pool of operands, about half of which are
+/// repeated, so that both the insert and the hit path of GetOrInsertNode run.
+static std::vector<Operation> operations(size_t N, BumpPtrAllocator &Alloc) {
+  std::vector<void *> Operands = bench::allocatorPointers(N / 4 + 2, Alloc);
+  std::vector<size_t> Picks = bench::zipfIndices(2 * N, Operands.size());
+  std::vector<Operation> Result;
+  for (size_t I = 0; I != N; ++I)
+    Result.push_back({unsigned(I % 7), Operands[Picks[2 * I]],
+                      Operands[Picks[2 * I + 1]]});
+  return Result;
+}
+
+static void BM_FoldingSetGetOrInsert(benchmark::State &State) {
+  BumpPtrAllocator InputAlloc;
+  std::vector<Operation> Ops = operations(State.range(0), InputAlloc);
+  while (State.KeepRunning()) {
+    BumpPtrAllocator Alloc;
+    FoldingSet<Node> Set;
+    for (const Operation &Op : Ops) {
+      FoldingSetNodeID ID;
+      Node::profile(ID, Op.Opcode, Op.LHS, Op.RHS);
+      void *IP = nullptr;
+      if (Node *N = Set.FindNodeOrInsertPos(ID, IP)) {
+        benchmark::DoNotOptimize(N);
+        continue;
+      }
+      Set.InsertNode(new (Alloc.Allocate<Node>()) Node(Op.Opcode, Op.LHS,
+                                                       Op.RHS),
+                     IP);
+    }
+    benchmark::DoNotOptimize(Set.size());
+  }
+  State.SetItemsProcessed(State.iterations() * Ops.size());
+}
+BENCHMARK(BM_FoldingSetGetOrInsert)->Range(8, 1 << 16);
+
+static void BM_FoldingSetNodeIDProfile(benchmark::State &State) {
+  BumpPtrAllocator InputAlloc;
+  std::vector<Operation> Ops = operations(State.range(0), InputAlloc);
+  while (State.KeepRunning())
+    for (const Operation &Op : Ops) {
+      FoldingSetNodeID ID;
+      Node::profile(ID, Op.Opcode, Op.LHS, Op.RHS);
+      benchmark::DoNotOptimize(ID.ComputeHash());
+    }
+  State.SetItemsProcessed(State.iterations() * Ops.size());
+}
+BENCHMARK(BM_FoldingSetNodeIDProfile)->Arg(1024);
@@ -0,0 +1,88 @@
+//===- Inputs.cpp - Deterministic benchmark inputs ------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Inputs.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringSet.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace llvm;
+using namespace llvm::bench;
+
+std::vector<uint64_t> bench::randomIntegers(size_t N, uint64_t Seed) {
+  std::mt19937_64 Engine = makeEngine(Seed);
+  // Avoid the DenseMapInfo empty and tombstone keys.
+  DenseSet<uint64_t> Seen;
+  std::vector<uint64_t> Result;
+  while (Result.size() < N) {
+    uint64_t V = Engine() >> 2;
+    if (Seen.insert(V).second)
+      Result.push_back(V);
+  }
+  return Result;
+}
+
+std::vector<void *> bench::allocatorPointers(size_t N, BumpPtrAllocator &Alloc,
+                                             size_t ObjectSize) {
+  std::vector<void *> Result;
+  Result.reserve(N);
+  for (size_t I = 0; I != N; ++I)
+    Result.push_back(Alloc.Allocate(ObjectSize, 16));
+  return Result;
+}
+
+std::vector<std::string> bench::identifiers(size_t N, uint64_t Seed) {
+  static const char *const Stems[] = {
+      "tmp",     "arrayidx", "add",     "call",   "cmp",  "conv",
+      "retval",  "this.addr", "indvars.iv", "incdec.ptr", "cleanup",
+      "for.body", "if.then",  "land.lhs.true"};
+  static const char *const Namespaces[] = {"llvm", "clang", "std", "detail",
+                                           "impl", "support"};
+  std::mt19937_64 Engine = makeEngine(Seed);
+  StringSet<> Seen;
+  std::vector<std::string> Result;
+  while (Result.size() < N) {
+    std::string Name;
+    if (Engine() % 4) {
+      // A local value name, possibly with an inlining suffix.
+      Name = Stems[Engine() % array_lengthof(Stems)];
+      Name += std::to_string(Engine() % (4 * N + 1));
+      if (Engine() % 3 == 0)
+        Name += ".i";
+    } else {
+      // An Itanium-mangled function name.
+      Name = "_ZN";
+      for (unsigned I = 0, E = 1 + Engine() % 3; I != E; ++I) {
+        std::string NS = Namespaces[Engine() % array_lengthof(Namespaces)];
+        Name += std::to_string(NS.size()) + NS;
+      }
+      std::string Fn = "function" + std::to_string(Engine() % (4 * N + 1));
+      Name += std::to_string(Fn.size()) + Fn + "Ev";
+    }
+    if (Seen.insert(Name).second)
+      Result.push_back(std::move(Name));
+  }
+  return Result;
+}
+
+std::vector<size_t> bench::zipfIndices(size_t N, size_t Range, uint64_t Seed) {
+  // Inverse transform sampling of the continuous approximation of a Zipf
+  // distribution with exponent 1.
+  std::mt19937_64 Engine = makeEngine(Seed);
+  std::uniform_real_distribution<double> Uniform(0.0, 1.0);
+  std::vector<size_t> Result;
+  Result.reserve(N);
+  double LogRange = std::log(double(Range) + 1);
+  for (size_t I = 0; I != N; ++I) {
+    size_t Idx = size_t(std::exp(Uniform(Engine) * LogRange)) - 1;
+    Result.push_back(std::min(Idx, Range - 1));
+  }
+  return Result;
+}
@@ -0,0 +1,57 @@
+//===- Inputs.h - Deterministic benchmark inputs ----------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides the key distributions the benchmarks are run with. All of
+// them are generated from fixed seeds so that results are comparable across
+// runs and commits.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_BENCHMARKS_INPUTS_H
+#define LLVM_BENCHMARKS_INPUTS_H
+
+#include "llvm/Support/Allocator.h"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace llvm {
+namespace bench {
+
+/// Returns the random number engine every input generator draws from.
+inline std::mt19937_64 makeEngine(uint64_t Seed = 0x5eed) {
+  return std::mt19937_64(Seed);
+}
+
+/// Returns \p N distinct integers drawn uniformly at random.
+std::vector<uint64_t> randomIntegers(size_t N, uint64_t Seed = 0x5eed);
+
+/// Returns \p N pointers to distinct objects of \p ObjectSize bytes, in
+/// allocation order, the way keys of pointer-keyed maps such as
+/// DenseMap<Value *, T> look in practice: consecutive, allocator aligned
+/// addresses. The objects live in \p Alloc.
+std::vector<void *> allocatorPointers(size_t N, BumpPtrAllocator &Alloc,
+                                      size_t ObjectSize = 48);
+
+/// Returns \p N distinct identifiers resembling the symbol and value names
+/// found in IR: a mix of short local names ("tmp12", "arrayidx.i") and long
+/// mangled C++ names.
+std::vector<std::string> identifiers(size_t N, uint64_t Seed = 0x5eed);
+
+/// Returns \p N indices in [0, Range) following a Zipf-like distribution, so
+/// that a few keys are looked up very often and most of them rarely, as with
+/// symbol table lookups.
+std::vector<size_t> zipfIndices(size_t N, size_t Range,
+                                uint64_t Seed = 0x5eed);
+
+} // end namespace bench
+} // end namespace llvm
+
+#endif // LLVM_BENCHMARKS_INPUTS_H
@@ -0,0 +1,85 @@
+//===- RawOstream.cpp - raw_ostream benchmarks ----------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Benchmark.h"
+#include "Inputs.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+static void BM_RawSVectorOstreamStrings(benchmark::State &State) {
+  std::vector<std::string> Names = bench::identifiers(State.range(0));
+  size_t Bytes = 0;
+  for (const std::string &Name : Names)
+    Bytes += Name.size() + 1;
+  while (State.KeepRunning()) {
+    SmallString<256> Buffer;
+    raw_svector_ostream OS(Buffer);
+    for (const std::string &Name : Names)
+      OS << Name << ' ';
+    benchmark::DoNotOptimize(Buffer.data());
+  }
+  State.SetBytesProcessed(State.iterations() * Bytes);
+}
+BENCHMARK(BM_RawSVectorOstreamStrings)->Range(8, 1 << 14);
+
+static void BM_RawStringOstreamIntegers(benchmark::State &State) {
+  std::vector<uint64_t> Values = bench::randomIntegers(State.range(0));
+  while (State.KeepRunning()) {
+    std::string Buffer;
+    raw_string_ostream OS(Buffer);
+    for (uint64_t V : Values)
+      OS << V << ", " << (V & 0xffff) << '\n';
+    benchmark::DoNotOptimize(OS.str().data());
+  }
+  State.SetItemsProcessed(State.iterations() * Values.size() * 2);
+}
+BENCHMARK(BM_RawStringOstreamIntegers)->Range(8, 1 << 14);
+
+static void BM_RawOstreamFormatHex(benchmark::State &State) {
+  std::vector<uint64_t> Values = bench::randomIntegers(State.range(0));
+  while (State.KeepRunning()) {
+    SmallString<256> Buffer;
+    raw_svector_ostream OS(Buffer);
+    for (uint64_t V : Values)
+      OS << format_hex(V, 18) << ' ';
+    benchmark::DoNotOptimize(Buffer.data());
+  }
+  State.SetItemsProcessed(State.iterations() * Values.size());
+}
+BENCHMARK(BM_RawOstreamFormatHex)->Range(8, 1 << 14);
+
+static void BM_RawOstreamFormat(benchmark::State &State) {
+  // format() goes through snprintf.
+  std::vector<uint64_t> Values = bench::randomIntegers(State.range(0));
+  while (State.KeepRunning()) {
+    SmallString<256> Buffer;
+    raw_svector_ostream OS(Buffer);
+    for (uint64_t V : Values)
+      OS << format("%8u %5.2f\n", unsigned(V), double(V & 0xffff) / 7);
+    benchmark::DoNotOptimize(Buffer.data());
+  }
+  State.SetItemsProcessed(State.iterations() * Values.size());
+}
+BENCHMARK(BM_RawOstreamFormat)->Range(8, 1 << 14);
+
+static void BM_RawOstreamWriteEscaped(benchmark::State &State) {
+  std::vector<std::string> Names = bench::identifiers(State.range(0));
+  while (State.KeepRunning()) {
+    SmallString<256> Buffer;
+    raw_svector_ostream OS(Buffer);
+    for (const std::string &Name : Names)
+      OS.write_escaped(Name);
+    benchmark::DoNotOptimize(Buffer.data());
+  }
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+BENCHMARK(BM_RawOstreamWriteEscaped)->Range(8, 1 << 14);
@@ -0,0 +1,58 @@
+//===- SmallPtrSet.cpp - SmallPtrSet benchmarks ---------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Benchmark.h"
+#include "Inputs.h"
+#include "llvm/ADT/SmallPtrSet.h"
+
+using namespace llvm;
+
+static void BM_SmallPtrSetInsert(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  std::vector<void *> Ptrs = bench::allocatorPointers(State.range(0), Alloc);
+  while (State.KeepRunning()) {
+    SmallPtrSet<void *, 16> Set;
+    for (void *P : Ptrs)
+      Set.insert(P);
+    benchmark::DoNotOptimize(Set);
+  }
+  State.SetItemsProcessed(State.iterations() * Ptrs.size());
+}
+// Sizes in the small (linear scan) and in the large (hashed) mode.
+BENCHMARK(BM_SmallPtrSetInsert)->Arg(4)->Arg(16)->Arg(17)->Range(64, 1 << 16);
+
+static void BM_SmallPtrSetVisited(benchmark::State &State) {
+  // A graph walk's visited set: every pointer is inserted once and then
+  // queried again about three times.
+  BumpPtrAllocator Alloc;
+  std::vector<void *> Ptrs = bench::allocatorPointers(State.range(0), Alloc);
+  std::vector<size_t> Queries = bench::zipfIndices(3 * Ptrs.size(), Ptrs.size());
+  while (State.KeepRunning()) {
+    SmallPtrSet<void *, 16> Visited;
+    for (void *P : Ptrs)
+      Visited.insert(P);
+    for (size_t Idx : Queries)
+      benchmark::DoNotOptimize(Visited.insert(Ptrs[Idx]).second);
+  }
+  State.SetItemsProcessed(State.iterations() * (Ptrs.size() + Queries.size()));
+}
+BENCHMARK(BM_SmallPtrSetVisited)->Arg(8)->Range(64, 1 << 16);
+
+static void BM_SmallPtrSetCountMiss(benchmark::State &State) {
+  BumpPtrAllocator Alloc;
+  std::vector<void *> Ptrs =
+      bench::allocatorPointers(2 * State.range(0), Alloc);
+  size_t N = Ptrs.size() / 2;
+  SmallPtrSet<void *, 16> Set(Ptrs.begin(), Ptrs.begin() + N);
+  while (State.KeepRunning())
+    for (size_t I = N, E = Ptrs.size(); I != E; ++I)
+      benchmark::DoNotOptimize(Set.count(Ptrs[I]));
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_SmallPtrSetCountMiss)->Arg(8)->Range(64, 1 << 16);
@@ -0,0 +1,80 @@
+//===- SmallVector.cpp - SmallVector benchmarks ---------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Benchmark.h"
+#include "Inputs.h"
+#include "llvm/ADT/SmallVector.h"
+#include <string>
+
+using namespace llvm;
+
+static void BM_SmallVectorPushBack(benchmark::State &State) {
+  int64_t N = State.range(0);
+  while (State.KeepRunning()) {
+    SmallVector<unsigned, 8> V;
+    for (int64_t I = 0; I != N; ++I)
+      V.push_back(I);
+    benchmark::DoNotOptimize(V.data());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+// Sizes below, at and beyond the inline capacity.
+BENCHMARK(BM_SmallVectorPushBack)->Arg(4)->Arg(8)->Arg(9)->Arg(64)->Arg(4096);
+
+static void BM_SmallVectorPushBackPointers(benchmark::State &State) {
+  // The typical worklist: SmallVector<Instruction *, 16>.
+  BumpPtrAllocator Alloc;
+  std::vector<void *> Ptrs = bench::allocatorPointers(State.range(0), Alloc);
+  while (State.KeepRunning()) {
+    SmallVector<void *, 16> V;
+    for (void *P : Ptrs)
+      V.push_back(P);
+    while (!V.empty())
+      benchmark::DoNotOptimize(V.pop_back_val());
+  }
+  State.SetItemsProcessed(State.iterations() * Ptrs.size());
+}
+BENCHMARK(BM_SmallVectorPushBackPointers)->Range(8, 1 << 16);
+
+static void BM_SmallVectorAppend(benchmark::State &State) {
+  std::vector<uint64_t> Values = bench::randomIntegers(State.range(0));
+  while (State.KeepRunning()) {
+    SmallVector<uint64_t, 8> V;
+    V.append(Values.begin(), Values.end());
+    benchmark::DoNotOptimize(V.data());
+  }
+  State.SetBytesProcessed(State.iterations() * Values.size() *
+                          sizeof(uint64_t));
+}
+BENCHMARK(BM_SmallVectorAppend)->Range(8, 1 << 16);
+
+static void BM_SmallVectorStrings(benchmark::State &State) {
+  // Non-trivially copyable elements take the slow grow path.
+  std::vector<std::string> Names = bench::identifiers(State.range(0));
+  while (State.KeepRunning()) {
+    SmallVector<std::string, 4> V;
+    for (const std::string &Name : Names)
+      V.push_back(Name);
+    benchmark::DoNotOptimize(V.data());
+  }
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+BENCHMARK(BM_SmallVectorStrings)->Range(8, 1 << 12);
+
+static void BM_SmallVectorInsertFront(benchmark::State &State) {
+  int64_t N = State.range(0);
+  while (State.KeepRunning()) {
+    SmallVector<unsigned, 8> V;
+    for (int64_t I = 0; I != N; ++I)
+      V.insert(V.begin(), I);
+    benchmark::DoNotOptimize(V.data());
+  }
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_SmallVectorInsertFront)->Range(8, 1 << 10);
@@ -0,0 +1,74 @@
+//===- StringMap.cpp - StringMap benchmarks -------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Benchmark.h"
+#include "Inputs.h"
+#include "llvm/ADT/StringMap.h"
+
+using namespace llvm;
+
+static void BM_StringMapInsert(benchmark::State &State) {
+  std::vector<std::string> Names = bench::identifiers(State.range(0));
+  while (State.KeepRunning()) {
+    StringMap<unsigned> Map;
+    for (unsigned I = 0, E = Names.size(); I != E; ++I)
+      Map[Names[I]] = I;
+    benchmark::DoNotOptimize(Map);
+  }
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+BENCHMARK(BM_StringMapInsert)->Range(8, 1 << 16);
+
+static void BM_StringMapLookupZipf(benchmark::State &State) {
+  // Symbol table lookups: a few names are looked up very often.
+  std::vector<std::string> Names = bench::identifiers(State.range(0));
+  StringMap<unsigned> Map;
+  for (unsigned I = 0, E = Names.size(); I != E; ++I)
+    Map[Names[I]] = I;
+  std::vector<size_t> Order = bench::zipfIndices(1024, Names.size());
+  while (State.KeepRunning())
+    for (size_t Idx : Order)
+      benchmark::DoNotOptimize(Map.find(Names[Idx]));
+  State.SetItemsProcessed(State.iterations() * Order.size());
+}
+BENCHMARK(BM_StringMapLookupZipf)->Range(8, 1 << 16);
+
+static void BM_StringMapLookupMiss(benchmark::State &State) {
+  std::vector<std::string> Names = bench::identifiers(2 * State.range(0));
+  size_t N = Names.size() / 2;
+  StringMap<unsigned> Map;
+  for (unsigned I = 0; I != N; ++I)
+    Map[Names[I]] = I;
+  while (State.KeepRunning())
+    for (size_t I = N, E = Names.size(); I != E; ++I)
+      benchmark::DoNotOptimize(Map.count(Names[I]));
+  State.SetItemsProcessed(State.iterations() * N);
+}
+BENCHMARK(BM_StringMapLookupMiss)->Range(8, 1 << 16);
+
+static void BM_StringMapUniqueNames(benchmark::State &State) {
+  // The ValueSymbolTable pattern: insert, and on collision retry with a
+  // numeric suffix.
+  std::vector<std::string> Names = bench::identifiers(State.range(0));
+  while (State.KeepRunning()) {
+    StringMap<unsigned> Map;
+    for (unsigned Round = 0; Round != 2; ++Round)
+      for (const std::string &Name : Names) {
+        if (Map.insert(std::make_pair(Name, 0)).second)
+          continue;
+        for (unsigned Suffix = 1;; ++Suffix)
+          if (Map.insert(std::make_pair(Name + "." + std::to_string(Suffix), 0))
+                  .second)
+            break;
+      }
+    benchmark::DoNotOptimize(Map);
+  }
+  State.SetItemsProcessed(State.iterations() * Names.size() * 2);
+}
+BENCHMARK(BM_StringMapUniqueNames)->Range(8, 1 << 14);
@@ -0,0 +1,102 @@
+//===- UseList.cpp - Use list benchmarks ----------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Benchmarks for walking and rewriting the use lists of values with many
+// uses. Compare builds with and without LLVM_ENABLE_USE_USER_POINTERS.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Benchmark.h"
+#include "Inputs.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+using namespace llvm;
+
+namespace {
+/// A function in which the two arguments have \p N uses each, spread over
+/// twice as many instructions.
+struct FanoutFunction {
+  LLVMContext Ctx;
+  std::unique_ptr<Module> M;
+  Argument *Hot;
+  Argument *Cold;
+
+  explicit FanoutFunction(size_t N) : M(new Module("bench", Ctx)) {
+    Type *I32 = Type::getInt32Ty(Ctx);
+    Function *F = Function::Create(
+        FunctionType::get(Type::getVoidTy(Ctx), {I32, I32}, false),
+        GlobalValue::ExternalLinkage, "f", M.get());
+    Hot = &*F->arg_begin();
+    Cold = &*std::next(F->arg_begin());
+    IRBuilder<> B(BasicBlock::Create(Ctx, "entry", F));
+    Value *Acc = B.getInt32(0);
+    for (size_t I = 0; I != N; ++I) {
+      Acc = B.CreateAdd(Acc, Cold);
+      Acc = B.CreateXor(Acc, Hot);
+    }
+    B.CreateRetVoid();
+    scramble(*Hot);
+    scramble(*Cold);
+  }
+
+  /// Puts the use list of \p V in random order, the way it looks once a few
+  /// passes have rewritten the function, instead of allocation order.
+  static void scramble(Value &V) {
+    std::vector<uint64_t> Keys = bench::randomIntegers(V.getNumUses());
+    DenseMap<const Use *, uint64_t> Order;
+    size_t I = 0;
+    for (const Use &U : V.uses())
+      Order[&U] = Keys[I++];
+    V.sortUseList([&](const Use &L, const Use &R) {
+      return Order.lookup(&L) < Order.lookup(&R);
+    });
+  }
+};
+} // end anonymous namespace
+
+static void BM_UsersIteration(benchmark::State &State) {
+  FanoutFunction FF(State.range(0));
+  while (State.KeepRunning())
+    for (User *U : FF.Hot->users())
+      benchmark::DoNotOptimize(U);
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_UsersIteration)->Range(64, 1 << 18);
+
+static void BM_UsesIterationOperandNo(benchmark::State &State) {
+  FanoutFunction FF(State.range(0));
+  while (State.KeepRunning())
+    for (const Use &U : FF.Hot->uses())
+      benchmark::DoNotOptimize(U.getOperandNo());
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_UsesIterationOperandNo)->Range(64, 1 << 18);
+
+static void BM_ReplaceAllUsesWith(benchmark::State &State) {
+  FanoutFunction FF(State.range(0));
+  // Move the uses of the hot argument over to the cold one and back, so that
+  // every iteration starts out from the same function.
+  while (State.KeepRunning()) {
+    State.PauseTiming();
+    std::vector<Use *> HotUses;
+    for (Use &U : FF.Hot->uses())
+      HotUses.push_back(&U);
+    State.ResumeTiming();
+    FF.Hot->replaceAllUsesWith(FF.Cold);
+    State.PauseTiming();
+    for (Use *U : HotUses)
+      U->set(FF.Hot);
+    State.ResumeTiming();
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_ReplaceAllUsesWith)->Range(64, 1 << 18);
@@ -38,6 +38,7 @@
 #ifndef LLVM_ANALYSIS_ALIASANALYSIS_H
 #define LLVM_ANALYSIS_ALIASANALYSIS_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/None.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallVector.h"
@@ -217,6 +218,18 @@ public:
   bool invalidate(Function &F, const PreservedAnalyses &PA,
                   FunctionAnalysisManager::Invalidator &Inv);
 
+  /// Start a batch of queries, during which the IR must not change.
+  ///
+  /// While a batch is running, the results of top-level alias queries and the
+  /// per-value information the alias analyses compute along the way (such as
+  /// decomposed GEPs, underlying objects and capture results) are kept for
+  /// the following queries instead of being recomputed. Batches nest. Prefer
+  /// \c BatchAAScope to calling these directly.
+  void beginBatch();
+
+  /// End a batch of queries started with \c beginBatch.
+  void endBatch();
+
   //===--------------------------------------------------------------------===//
   /// \name Alias Queries
   /// @{
@@ -626,6 +639,31 @@ private:
   std::vector<std::unique_ptr<Concept>> AAs;
 
   std::vector<AnalysisKey *> AADeps;
+
+  /// The nesting depth of batches, see \c beginBatch.
+  unsigned BatchDepth = 0;
+
+  /// The nesting depth of alias queries. Alias analyses call back into the
+  /// aggregation while answering a query, and those nested queries may rely
+  /// on assumptions of the outer one, so only top-level results are kept.
+  unsigned AliasQueryDepth = 0;
+
+  /// Results of the top-level alias queries of the current batch.
+  DenseMap<std::pair<MemoryLocation, MemoryLocation>, AliasResult>
+      BatchAliasResults;
+};
+
+/// RAII object running a batch of queries on an \c AAResults for its
+/// lifetime. The IR must not be modified while it is alive.
+class BatchAAScope {
+  AAResults &AA;
+
+public:
+  explicit BatchAAScope(AAResults &AA) : AA(AA) { AA.beginBatch(); }
+  ~BatchAAScope() { AA.endBatch(); }
+
+  BatchAAScope(const BatchAAScope &) = delete;
+  BatchAAScope &operator=(const BatchAAScope &) = delete;
 };
 
 /// Temporary typedef for legacy code that uses a generic \c AliasAnalysis
@@ -695,6 +733,17 @@ public:
   virtual ModRefInfo getModRefInfo(ImmutableCallSite CS1,
                                    ImmutableCallSite CS2) = 0;
 
+  /// @}
+  //===--------------------------------------------------------------------===//
+  /// \name Batching
+  /// @{
+
+  /// Start a batch of queries, during which the IR does not change.
+  virtual void beginBatch() = 0;
+
+  /// End a batch of queries.
+  virtual void endBatch() = 0;
+
   /// @}
 };
 
@@ -746,6 +795,10 @@ public:
                            ImmutableCallSite CS2) override {
     return Result.getModRefInfo(CS1, CS2);
   }
+
+  void beginBatch() override { Result.beginBatch(); }
+
+  void endBatch() override { Result.endBatch(); }
 };
 
 /// A CRTP-driven "mixin" base class to help implement the function alias
@@ -868,6 +921,10 @@ public:
   ModRefInfo getModRefInfo(ImmutableCallSite CS1, ImmutableCallSite CS2) {
     return MRI_ModRef;
   }
+
+  void beginBatch() {}
+
+  void endBatch() {}
 };
 
 /// Return true if this pointer is returned by a noalias function.
@@ -19,6 +19,7 @@
 
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseMapInfo.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/ilist.h"
 #include "llvm/ADT/ilist_node.h"
 #include "llvm/Analysis/AliasAnalysis.h"
@@ -178,8 +179,19 @@ class AliasSet : public ilist_node<AliasSet> {
   /// True if this alias set contains volatile loads or stores.
   unsigned Volatile : 1;
 
+  /// True if some pointer of the set is not known to be based on one of
+  /// Objects.
+  unsigned UnknownObjects : 1;
+
   unsigned SetSize = 0;
 
+  /// A summary of the pointers of the set: the identified objects (see
+  /// isIdentifiedObject) they are based on, unless UnknownObjects is set.
+  /// Pointers based on other identified objects cannot alias any of them,
+  /// which is checked without querying alias analysis. Kept small; a set
+  /// based on more objects than that is summarized as UnknownObjects.
+  SmallVector<const Value *, 4> Objects;
+
   void addRef() { ++RefCount; }
 
   void dropRef(AliasSetTracker &AST) {
@@ -264,7 +276,7 @@ private:
   // Can only be created by AliasSetTracker.
   AliasSet()
       : PtrListEnd(&PtrList), RefCount(0),  AliasAny(false), Access(NoAccess),
-        Alias(SetMustAlias), Volatile(false) {}
+        Alias(SetMustAlias), Volatile(false), UnknownObjects(false) {}
 
   PointerRec *getSomePointer() const {
     return PtrList;
@@ -306,6 +318,21 @@ private:
 
   void setVolatile() { Volatile = true; }
 
+  /// Add \p Object, the identified object a pointer of the set is based on or
+  /// null if there is none, to the summary of the set.
+  void addObject(const Value *Object);
+
+  /// Return true if a pointer based on \p Object, the result of
+  /// getIdentifiedObject, may alias a pointer of the set.
+  bool mayAliasObject(const Value *Object) const {
+    return !Object || UnknownObjects || is_contained(Objects, Object);
+  }
+
+  /// As the public version, with the identified object \p Ptr is based on
+  /// already computed.
+  bool aliasesPointer(const Value *Ptr, uint64_t Size, const AAMDNodes &AAInfo,
+                      const Value *Object, AliasAnalysis &AA) const;
+
 public:
   /// Return true if the specified pointer "may" (or must) alias one of the
   /// members in the set.
@@ -435,8 +462,20 @@ private:
   // all pointers into a single "May" set.
   AliasSet *AliasAnyAS = nullptr;
 
+  /// Set if the AST got saturated while all its pointers were based on
+  /// identified objects. It then keeps one alias set per object, found without
+  /// alias queries, instead of lumping everything together; this maps each
+  /// object to its set. A pointer not based on an identified object, or an
+  /// unknown instruction, saturates it fully.
+  bool SaturatedByObject = false;
+  DenseMap<const Value *, AliasSet *> SetForObject;
+
   void removeAliasSet(AliasSet *AS);
 
+  /// Try to saturate the AST by object; return false if some alias set is not
+  /// summarized by the identified objects of its pointers.
+  bool saturateByObject();
+
   /// Just like operator[] on the map, except that it creates an entry for the
   /// pointer if it doesn't already exist.
   AliasSet::PointerRec &getEntryFor(Value *V) {
@@ -35,6 +35,7 @@ struct AAMDNodes;
 class APInt;
 class AssumptionCache;
 class BasicBlock;
+class CaptureInfo;
 class DataLayout;
 class DominatorTree;
 class Function;
@@ -59,19 +60,22 @@ class BasicAAResult : public AAResultBase<BasicAAResult> {
   AssumptionCache &AC;
   DominatorTree *DT;
   LoopInfo *LI;
+  /// Only consulted during a batch of queries, see beginBatch().
+  CaptureInfo *CI;
 
 public:
   BasicAAResult(const DataLayout &DL, const TargetLibraryInfo &TLI,
                 AssumptionCache &AC, DominatorTree *DT = nullptr,
-                LoopInfo *LI = nullptr)
-      : AAResultBase(), DL(DL), TLI(TLI), AC(AC), DT(DT), LI(LI) {}
+                LoopInfo *LI = nullptr, CaptureInfo *CI = nullptr)
+      : AAResultBase(), DL(DL), TLI(TLI), AC(AC), DT(DT), LI(LI), CI(CI) {}
 
   BasicAAResult(const BasicAAResult &Arg)
       : AAResultBase(Arg), DL(Arg.DL), TLI(Arg.TLI), AC(Arg.AC), DT(Arg.DT),
-        LI(Arg.LI) {}
+        LI(Arg.LI), CI(Arg.CI) {}
   BasicAAResult(BasicAAResult &&Arg)
       : AAResultBase(std::move(Arg)), DL(Arg.DL), TLI(Arg.TLI), AC(Arg.AC),
-        DT(Arg.DT), LI(Arg.LI) {}
+        DT(Arg.DT), LI(Arg.LI), CI(Arg.CI), BatchDepth(Arg.BatchDepth),
+        Batch(std::move(Arg.Batch)) {}
 
   /// Handle invalidation events in the new pass manager.
   bool invalidate(Function &F, const PreservedAnalyses &PA,
@@ -96,6 +100,13 @@ public:
   /// call site is not known.
   FunctionModRefBehavior getModRefBehavior(const Function *F);
 
+  /// Keep decomposed GEPs, underlying objects and capture results from query
+  /// to query until the matching endBatch(). The capture results come from
+  /// the CaptureInfo, if there is one, which is cleared when the outermost
+  /// batch starts, as nothing tells it about uses added in between.
+  void beginBatch();
+  void endBatch();
+
 private:
   // A linear transformation of a Value; this class represents ZExt(SExt(V,
   // SExtBits), ZExtBits) * Scale + Offset.
@@ -160,6 +171,22 @@ private:
   /// Tracks instructions visited by pointsToConstantMemory.
   SmallPtrSet<const Value *, 16> Visited;
 
+  /// Per-value results which only depend on the IR, kept while a batch of
+  /// queries is running.
+  struct BatchCaches {
+    DenseMap<const Value *, std::pair<DecomposedGEP, bool>> DecomposedGEPs;
+    DenseMap<const Value *, const Value *> UnderlyingObjects;
+    DenseMap<const Value *, bool> NonEscapingLocals;
+  };
+  unsigned BatchDepth = 0;
+  std::unique_ptr<BatchCaches> Batch;
+
+  /// DecomposeGEPExpression, GetUnderlyingObject and isNonEscapingLocalObject
+  /// with the results cached during a batch.
+  bool decomposeGEP(const Value *V, DecomposedGEP &Decomposed);
+  const Value *getUnderlyingObject(const Value *V);
+  bool isNonEscapingLocal(const Value *V);
+
   static const Value *
   GetLinearExpression(const Value *V, APInt &Scale, APInt &Offset,
                       unsigned &ZExtBits, unsigned &SExtBits,
@@ -0,0 +1,100 @@
+//===- llvm/Analysis/CaptureInfo.h - Memoized capture tracking --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares CaptureInfo, which answers the capture tracking queries
+// of CaptureTracking.h for the pointers of one function and remembers the
+// answers. The uses of a pointer are walked once, without the use count
+// threshold of PointerMayBeCaptured, to find whether it is captured at all
+// and the earliest point at which it may be: the nearest common dominator of
+// the capturing instructions. Captures in unreachable blocks do not count
+// towards the earliest point.
+//
+// Removing instructions can only remove captures. The results for a pointer
+// are dropped when the pointer or its earliest capture is deleted, and are
+// computed again on the next query; other results stay valid, if possibly
+// conservative. A client which adds uses of a pointer that may capture it
+// must call forgetValue() or clear().
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_CAPTUREINFO_H
+#define LLVM_ANALYSIS_CAPTUREINFO_H
+
+#include "llvm/IR/PassManager.h"
+#include <memory>
+
+namespace llvm {
+
+class DominatorTree;
+class Function;
+class Instruction;
+class raw_ostream;
+class Value;
+
+class CaptureInfo {
+public:
+  explicit CaptureInfo(const DominatorTree &DT);
+  CaptureInfo(CaptureInfo &&Arg);
+  ~CaptureInfo();
+
+  /// Returns true if \p V may be captured in its function, as
+  /// PointerMayBeCaptured does. \p ReturnCaptures specifies whether returning
+  /// the value counts as capturing it. Stores always do.
+  bool isCaptured(const Value *V, bool ReturnCaptures);
+
+  /// Returns the earliest instruction at which \p V may be captured, or null
+  /// if it is not captured in any reachable block. Every reachable capture is
+  /// dominated by the result.
+  const Instruction *getEarliestCapture(const Value *V, bool ReturnCaptures);
+
+  /// Drops the results for \p V.
+  void forgetValue(const Value *V);
+
+  /// Drops all results.
+  void clear();
+
+  /// Handle invalidation events in the new pass manager.
+  bool invalidate(Function &F, const PreservedAnalyses &PA,
+                  FunctionAnalysisManager::Invalidator &Inv);
+
+private:
+  struct Storage;
+
+  const DominatorTree &DT;
+  /// Allocated separately, as the callbacks of its value handles refer to it
+  /// by address.
+  std::unique_ptr<Storage> S;
+};
+
+/// Analysis pass providing a CaptureInfo for a function.
+class CaptureAnalysis : public AnalysisInfoMixin<CaptureAnalysis> {
+  friend AnalysisInfoMixin<CaptureAnalysis>;
+
+  static AnalysisKey Key;
+
+public:
+  using Result = CaptureInfo;
+
+  CaptureInfo run(Function &F, FunctionAnalysisManager &AM);
+};
+
+/// Printer pass for the capture status of the arguments and pointer values of
+/// a function.
+class CaptureInfoPrinterPass : public PassInfoMixin<CaptureInfoPrinterPass> {
+  raw_ostream &OS;
+
+public:
+  explicit CaptureInfoPrinterPass(raw_ostream &OS) : OS(OS) {}
+
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &AM);
+};
+
+} // end namespace llvm
+
+#endif // LLVM_ANALYSIS_CAPTUREINFO_H
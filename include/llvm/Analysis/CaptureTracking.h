@@ -22,6 +22,12 @@ namespace llvm {
   class DominatorTree;
   class OrderedBasicBlock;
 
+  /// The default number of uses of a value, and of each value derived from
+  /// it, that the capture tracking walk looks at before giving up and
+  /// reporting the pointer as captured. Clients which cache the results, such
+  /// as CaptureInfo, can afford to look at all of them.
+  enum : unsigned { DefaultMaxUsesToExplore = 20 };
+
   /// PointerMayBeCaptured - Return true if this pointer value may be captured
   /// by the enclosing function (which is required to exist).  This routine can
   /// be expensive, so consider caching the results.  The boolean ReturnCaptures
@@ -74,8 +80,12 @@ namespace llvm {
 
   /// PointerMayBeCaptured - Visit the value and the values derived from it and
   /// find values which appear to be capturing the pointer value. This feeds
-  /// results into and is controlled by the CaptureTracker object.
-  void PointerMayBeCaptured(const Value *V, CaptureTracker *Tracker);
+  /// results into and is controlled by the CaptureTracker object. If a value
+  /// has more than \p MaxUsesToExplore uses the walk stops and calls
+  /// CaptureTracker::tooManyUses; zero means there is no limit.
+  void PointerMayBeCaptured(const Value *V, CaptureTracker *Tracker,
+                            unsigned MaxUsesToExplore =
+                                DefaultMaxUsesToExplore);
 } // end namespace llvm
 
 #endif
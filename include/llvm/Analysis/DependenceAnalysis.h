@@ -40,10 +40,15 @@
 #ifndef LLVM_ANALYSIS_DEPENDENCEANALYSIS_H
 #define LLVM_ANALYSIS_DEPENDENCEANALYSIS_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallBitVector.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/IR/ValueHandle.h"
 #include "llvm/Pass.h"
+#include <memory>
 
 namespace llvm {
 template <typename T> class ArrayRef;
@@ -51,7 +56,9 @@ template <typename T> class ArrayRef;
   class LoopInfo;
   class ScalarEvolution;
   class SCEV;
+  class SCEVAddRecExpr;
   class SCEVConstant;
+  class SCEVUnknown;
   class raw_ostream;
 
   /// Dependence - This class represents a dependence between two memory
@@ -329,6 +336,19 @@ template <typename T> class ArrayRef;
 
     Function *getFunction() const { return F; }
 
+    /// forgetCachedResults - Drops the delinearizations computed so far. A
+    /// client which keeps this result while it changes the loops or the
+    /// memory accesses of the function must call it. The cached
+    /// delinearization of an access is dropped by itself when the access is
+    /// deleted or replaced.
+    void forgetCachedResults() { DelinearizationCache.clear(); }
+
+    /// Handle invalidation in the new pass manager. The cached
+    /// delinearizations are dropped even when the result is kept, as the
+    /// passes preserving it may still have changed the IR.
+    bool invalidate(Function &F, const PreservedAnalyses &PA,
+                    FunctionAnalysisManager::Invalidator &Inv);
+
   private:
     AliasAnalysis *AA;
     ScalarEvolution *SE;
@@ -912,6 +932,41 @@ template <typename T> class ArrayRef;
 
     bool tryDelinearize(Instruction *Src, Instruction *Dst,
                         SmallVectorImpl<Subscript> &Pair);
+
+    /// DelinearizationInfo - The parts of the delinearization of a memory
+    /// access which do not depend on the access it is tested against.
+    struct DelinearizationInfo {
+      /// The base pointer of the access, or null if it has none.
+      const SCEVUnknown *Base = nullptr;
+      /// The access function relative to Base, or null if it is not affine.
+      const SCEVAddRecExpr *AccessFn = nullptr;
+      const SCEV *ElementSize = nullptr;
+      /// The parametric terms of AccessFn.
+      SmallVector<const SCEV *, 4> Terms;
+    };
+
+    /// getDelinearizationInfo - Returns the DelinearizationInfo of the
+    /// memory access I, computed on the first query. Each access is tested
+    /// against many others; this is the part of the work done once.
+    const DelinearizationInfo &getDelinearizationInfo(Instruction *I);
+
+    /// DelinearizationCacheVH - Drops the cached delinearization of a memory
+    /// access when the access is deleted or replaced, so that another access
+    /// allocated at the same address does not pick it up.
+    class DelinearizationCacheVH final : public CallbackVH {
+      DependenceInfo *DI;
+
+      void deleted() override;
+      void allUsesReplacedWith(Value *New) override;
+
+    public:
+      DelinearizationCacheVH(Value *V, DependenceInfo *DI = nullptr)
+          : CallbackVH(V), DI(DI) {}
+    };
+
+    DenseMap<DelinearizationCacheVH, std::unique_ptr<DelinearizationInfo>,
+             DenseMapInfo<Value *>>
+        DelinearizationCache;
   }; // class DependenceInfo
 
   /// \brief AnalysisPass to compute dependence information in a function
@@ -0,0 +1,128 @@
+//===- llvm/Analysis/DomTreeUpdater.h - Batched dominator updates -*- C++ -*-=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares DomTreeUpdater, which keeps a DominatorTree and a
+// PostDominatorTree, either of them optional, up to date with the CFG changes
+// reported to it. The CFG-mutating utilities of TransformUtils take one so
+// that passes built out of them preserve the trees instead of recomputing
+// them.
+//
+// With the Eager strategy, updates are applied to the trees as they are
+// reported. With the Lazy strategy, they are queued and applied as one batch
+// the next time a tree is asked for, or on flush(); redundant updates, such
+// as the insertion and deletion of the same edge, cancel out then. Blocks
+// deleted through the updater are kept, emptied and unreachable, until the
+// updates which disconnected them have been applied.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_DOMTREEUPDATER_H
+#define LLVM_ANALYSIS_DOMTREEUPDATER_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Dominators.h"
+
+namespace llvm {
+
+class BasicBlock;
+class Function;
+struct PostDominatorTree;
+
+class DomTreeUpdater {
+public:
+  enum class UpdateStrategy : unsigned char { Eager, Lazy };
+
+  explicit DomTreeUpdater(UpdateStrategy Strategy) : Strategy(Strategy) {}
+  DomTreeUpdater(DominatorTree *DT, UpdateStrategy Strategy)
+      : DT(DT), Strategy(Strategy) {}
+  DomTreeUpdater(DominatorTree *DT, PostDominatorTree *PDT,
+                 UpdateStrategy Strategy)
+      : DT(DT), PDT(PDT), Strategy(Strategy) {}
+  DomTreeUpdater(const DomTreeUpdater &) = delete;
+  DomTreeUpdater &operator=(const DomTreeUpdater &) = delete;
+
+  /// Applies the pending updates and deletes the pending blocks.
+  ~DomTreeUpdater() { flush(); }
+
+  bool isEager() const { return Strategy == UpdateStrategy::Eager; }
+  bool isLazy() const { return Strategy == UpdateStrategy::Lazy; }
+
+  bool hasDomTree() const { return DT != nullptr; }
+  bool hasPostDomTree() const { return PDT != nullptr; }
+
+  /// Returns true if there are updates not yet applied to one of the trees.
+  bool hasPendingUpdates() const {
+    return PendDTUpdateIndex != PendUpdates.size() ||
+           PendPDTUpdateIndex != PendUpdates.size();
+  }
+
+  /// Returns true if \p BB has been deleted through the updater, but is still
+  /// in its function.
+  bool isBBPendingDeletion(const BasicBlock *BB) const {
+    return DeletedBBs.count(BB);
+  }
+
+  /// Reports a sequence of CFG edge insertions and deletions, which must
+  /// already have been made, as DominatorTree::applyUpdates expects them.
+  /// Duplicated updates and self loops in the sequence are ignored.
+  void applyUpdates(ArrayRef<DominatorTree::UpdateType> Updates);
+
+  /// Reports the insertion of the edge \p From -> \p To. The edge must be in
+  /// the CFG already.
+  void insertEdge(BasicBlock *From, BasicBlock *To);
+
+  /// Reports the deletion of the edge \p From -> \p To. The edge must not be
+  /// in the CFG any more: with several edges between the blocks, only report
+  /// the deletion of the last one.
+  void deleteEdge(BasicBlock *From, BasicBlock *To);
+
+  /// Deletes \p DelBB, whose incoming and outgoing edges must all have been
+  /// reported deleted. Its instructions are deleted right away, with their
+  /// uses replaced by undef; with the Lazy strategy, the block itself stays in
+  /// its function, ending with an unreachable, until the next flush().
+  void deleteBB(BasicBlock *DelBB);
+
+  /// Deletes the pending blocks and recomputes the trees for \p F, dropping
+  /// the pending updates. Cheaper than applying them after drastic changes.
+  void recalculate(Function &F);
+
+  /// Returns the dominator tree, after applying the pending updates to it.
+  DominatorTree &getDomTree();
+
+  /// Returns the post-dominator tree, after applying the pending updates to
+  /// it.
+  PostDominatorTree &getPostDomTree();
+
+  /// Applies the pending updates to both trees and deletes the pending
+  /// blocks.
+  void flush();
+
+private:
+  void applyDomTreeUpdates();
+  void applyPostDomTreeUpdates();
+  /// Deletes the pending blocks once both trees are up to date.
+  void tryFlushDeletedBBs();
+  /// Removes the nodes of \p DelBB from the trees and deletes it.
+  void eraseDelBB(BasicBlock *DelBB);
+
+  SmallVector<DominatorTree::UpdateType, 16> PendUpdates;
+  /// The first update of PendUpdates each tree has not seen yet.
+  size_t PendDTUpdateIndex = 0;
+  size_t PendPDTUpdateIndex = 0;
+  SmallPtrSet<const BasicBlock *, 8> DeletedBBs;
+  DominatorTree *DT = nullptr;
+  PostDominatorTree *PDT = nullptr;
+  const UpdateStrategy Strategy;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_ANALYSIS_DOMTREEUPDATER_H
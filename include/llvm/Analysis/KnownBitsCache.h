@@ -0,0 +1,127 @@
+//===- llvm/Analysis/KnownBitsCache.h - Memoized known bits -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares KnownBitsCache, which answers the computeKnownBits,
+// ComputeNumSignBits and isKnownNonZero queries of ValueTracking for the
+// values of one function and remembers the results, including those of the
+// queries on operands made along the way. Asking again about a value, or
+// about one the first query looked through, is a hash table lookup.
+//
+// Entries are dropped when their value, their context instruction, or an
+// operand of their value is deleted or replaced, together with the entries of
+// the instructions using the value, transitively. That walk is bounded; past
+// the bound the whole cache is dropped. A client which changes an
+// instruction in place in a way that may change what is known about it, or
+// about the instructions using it, must call forgetValue() or clear().
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_KNOWNBITSCACHE_H
+#define LLVM_ANALYSIS_KNOWNBITSCACHE_H
+
+#include "llvm/ADT/Optional.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Support/KnownBits.h"
+#include <memory>
+
+namespace llvm {
+
+class AssumptionCache;
+class DataLayout;
+class DominatorTree;
+class Function;
+class Instruction;
+class raw_ostream;
+class Value;
+
+class KnownBitsCache {
+public:
+  KnownBitsCache(const DataLayout &DL, AssumptionCache *AC = nullptr,
+                 const DominatorTree *DT = nullptr);
+  KnownBitsCache(KnownBitsCache &&Arg);
+  ~KnownBitsCache();
+
+  /// Cached versions of the ValueTracking functions of the same name, with
+  /// the assumption cache and dominator tree of this cache.
+  /// @{
+  KnownBits computeKnownBits(const Value *V,
+                             const Instruction *CxtI = nullptr);
+  unsigned ComputeNumSignBits(const Value *V,
+                              const Instruction *CxtI = nullptr);
+  bool isKnownNonZero(const Value *V, const Instruction *CxtI = nullptr);
+  /// @}
+
+  /// Drops everything cached about \p V and the instructions using it,
+  /// transitively, and everything cached in the context of \p V.
+  void forgetValue(const Value *V);
+
+  /// Drops everything cached.
+  void clear();
+
+  /// Returns the number of values, and context instructions, with results.
+  unsigned getNumEntries() const;
+
+  /// Handle invalidation events in the new pass manager.
+  bool invalidate(Function &F, const PreservedAnalyses &PA,
+                  FunctionAnalysisManager::Invalidator &Inv);
+
+  /// Interface for ValueTracking. \p Budget is the number of levels the query
+  /// may still recurse through; results computed with a smaller budget are
+  /// not returned.
+  /// @{
+  const KnownBits *lookupKnownBits(const Value *V, const Instruction *CxtI,
+                                   unsigned Budget) const;
+  void insertKnownBits(const Value *V, const Instruction *CxtI,
+                       unsigned Budget, const KnownBits &Known);
+  unsigned lookupNumSignBits(const Value *V, const Instruction *CxtI,
+                             unsigned Budget) const;
+  void insertNumSignBits(const Value *V, const Instruction *CxtI,
+                         unsigned Budget, unsigned NumSignBits);
+  Optional<bool> lookupNonZero(const Value *V, const Instruction *CxtI,
+                               unsigned Budget) const;
+  void insertNonZero(const Value *V, const Instruction *CxtI, unsigned Budget,
+                     bool NonZero);
+  /// @}
+
+private:
+  struct Storage;
+
+  const DataLayout &DL;
+  AssumptionCache *AC;
+  const DominatorTree *DT;
+  /// Out of line, so that moving the cache keeps it where the value map
+  /// tracking its values expects it.
+  std::unique_ptr<Storage> S;
+};
+
+/// Analysis pass providing a KnownBitsCache for a function.
+class KnownBitsAnalysis : public AnalysisInfoMixin<KnownBitsAnalysis> {
+  friend AnalysisInfoMixin<KnownBitsAnalysis>;
+
+  static AnalysisKey Key;
+
+public:
+  using Result = KnownBitsCache;
+
+  KnownBitsCache run(Function &F, FunctionAnalysisManager &AM);
+};
+
+/// Printer pass for the known bits of the integer values of a function.
+class KnownBitsPrinterPass : public PassInfoMixin<KnownBitsPrinterPass> {
+  raw_ostream &OS;
+
+public:
+  explicit KnownBitsPrinterPass(raw_ostream &OS) : OS(OS) {}
+
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &AM);
+};
+
+} // end namespace llvm
+
+#endif // LLVM_ANALYSIS_KNOWNBITSCACHE_H
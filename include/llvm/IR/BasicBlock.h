@@ -84,6 +84,10 @@ public:
   BasicBlock &operator=(const BasicBlock &) = delete;
   ~BasicBlock();
 
+  /// Allocate from the active IRArena, if any.
+  void *operator new(size_t Size);
+  void operator delete(void *Ptr);
+
   /// \brief Get the context in which this basic block lives.
   LLVMContext &getContext() const;
 
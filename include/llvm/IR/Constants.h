@@ -65,7 +65,7 @@ class ConstantData : public Constant {
 protected:
   explicit ConstantData(Type *Ty, ValueTy VT) : Constant(Ty, VT, nullptr, 0) {}
 
-  void *operator new(size_t s) { return User::operator new(s, 0); }
+  void *operator new(size_t s);
 
 public:
   ConstantData(const ConstantData &) = delete;
@@ -815,7 +815,7 @@ class BlockAddress final : public Constant {
 
   BlockAddress(Function *F, BasicBlock *BB);
 
-  void *operator new(size_t s) { return User::operator new(s, 2); }
+  void *operator new(size_t s);
 
   void destroyConstantImpl();
   Value *handleOperandChangeImpl(Value *From, Value *To);
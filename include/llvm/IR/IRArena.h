@@ -0,0 +1,103 @@
+//===- llvm/IR/IRArena.h - Arena allocation of IR objects -------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file declares IRArena, which lets clients that create and discard a
+/// lot of short-lived IR bump-allocate the instructions, their operands and
+/// basic blocks instead of going through malloc for every one of them.
+///
+/// While an IRArena::Scope is active on a thread, every User (instructions,
+/// functions, global variables) and BasicBlock created on that thread is
+/// carved out of the arena. Deleting such an object runs its destructor as
+/// usual but does not return the memory; all of it is released at once when
+/// the arena is reset or destroyed. Constants are owned by the LLVMContext
+/// and outlive any arena, so they are always allocated from the heap.
+/// Resizable operand lists (those of PHI nodes and switches) are heap
+/// allocated as well.
+///
+/// \code
+///   IRArena Arena;
+///   {
+///     IRArena::Scope S(&Arena);
+///     ... build, compile and delete a function ...
+///   }
+///   Arena.reset(); // Reuse the memory for the next function.
+/// \endcode
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_IRARENA_H
+#define LLVM_IR_IRARENA_H
+
+#include "llvm/Support/Allocator.h"
+#include <cstddef>
+
+namespace llvm {
+
+/// A bump-pointer arena for IR objects.
+///
+/// The arena must outlive every object allocated from it. It keeps track of
+/// how many of its bytes belong to objects which are still alive, so that a
+/// client can tell when it is safe to reset it.
+class IRArena {
+public:
+  IRArena() = default;
+  IRArena(const IRArena &) = delete;
+  IRArena &operator=(const IRArena &) = delete;
+  ~IRArena();
+
+  /// Makes \p Arena the arena IR objects created on this thread are allocated
+  /// from, for the lifetime of the scope. A null \p Arena makes them come
+  /// from the heap again. Scopes nest.
+  class Scope {
+  public:
+    explicit Scope(IRArena *Arena);
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    IRArena *Previous;
+  };
+
+  /// Returns the arena active on this thread, or null if there is none.
+  static IRArena *getCurrent();
+
+  /// Allocates \p Size bytes, aligned for any IR object, from the arena
+  /// active on this thread. Returns null if there is no active arena.
+  static void *allocate(size_t Size);
+
+  /// Releases memory returned by allocate(). The memory itself is only
+  /// reclaimed by reset().
+  static void deallocate(void *Ptr);
+
+  /// Releases all the memory of the arena for reuse, keeping the first slab,
+  /// if no object allocated from it is alive anymore. Returns true if the
+  /// arena was reset.
+  bool reset();
+
+  /// Returns the number of bytes allocated since the last reset.
+  size_t getBytesAllocated() const { return BytesAllocated; }
+
+  /// Returns the number of allocated bytes which belong to live objects.
+  size_t getLiveBytes() const { return BytesAllocated - BytesFreed; }
+
+  /// Returns the memory held by the arena, including freed objects and slack.
+  size_t getTotalMemory() const { return Allocator.getTotalMemory(); }
+
+private:
+  BumpPtrAllocator Allocator;
+  size_t BytesAllocated = 0;
+  size_t BytesFreed = 0;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_IR_IRARENA_H
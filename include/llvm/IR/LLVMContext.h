@@ -165,6 +165,17 @@ public:
   void enableDebugTypeODRUniquing();
   void disableDebugTypeODRUniquing();
 
+  /// Whether several threads may create types and constants in this context
+  /// at the same time. Off by default.
+  ///
+  /// Once enabled, the type and constant uniquing tables are sharded and
+  /// guarded by locks. This must be enabled before the first constant is
+  /// created. Metadata is not covered. Use lists are not covered either, so
+  /// threads must still not concurrently create or delete users of the same
+  /// value, including instructions with constant or global operands.
+  bool isConcurrentUniquingEnabled() const;
+  void enableConcurrentUniquing();
+
   using InlineAsmDiagHandlerTy = void (*)(const SMDiagnostic&, void *Context,
                                           unsigned LocCookie);
 
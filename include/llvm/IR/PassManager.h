@@ -45,6 +45,7 @@
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/PassManagerInternal.h"
+#include "llvm/IR/PassProfiler.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/TypeName.h"
 #include "llvm/Support/raw_ostream.h"
@@ -453,7 +454,11 @@ public:
         dbgs() << "Running pass: " << Passes[Idx]->name() << " on "
                << IR.getName() << "\n";
 
-      PreservedAnalyses PassPA = Passes[Idx]->run(IR, AM, ExtraArgs...);
+      PreservedAnalyses PassPA;
+      {
+        PassProfileRegion Profile(Passes[Idx]->name(), IR);
+        PassPA = Passes[Idx]->run(IR, AM, ExtraArgs...);
+      }
 
       // Update the analysis manager as each pass runs and potentially
       // invalidates analyses.
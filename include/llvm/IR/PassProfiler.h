@@ -0,0 +1,125 @@
+//===- llvm/IR/PassProfiler.h - Per-function pass profiling -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file declares the interface for recording the cost of every
+/// (pass, function) pair run by either pass manager.
+///
+/// Unlike -time-passes, which aggregates per pass, the profile keeps one record
+/// per function pass execution so that the inputs which make a particular pass
+/// expensive can be found. Profiling is enabled with
+/// -pass-profile-output=<file>, and the profile is written when the profiler
+/// is destroyed by llvm_shutdown(), either as plain JSON or in the Chrome trace
+/// event format (-pass-profile-format=chrome-trace).
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_PASSPROFILER_H
+#define LLVM_IR_PASSPROFILER_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Mutex.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+class Function;
+class raw_ostream;
+
+/// Collects the per-function pass execution records.
+class PassProfiler {
+public:
+  enum class OutputFormat { JSON, ChromeTrace };
+
+  /// A single run of a pass over a function.
+  struct Record {
+    std::string PassName;
+    std::string FunctionName;
+    /// Start of the run, in microseconds since the profiler was created.
+    uint64_t StartMicros;
+    /// Wall time of the run, in microseconds.
+    uint64_t WallMicros;
+    /// Number of instructions in the function before and after the run.
+    uint64_t InstructionsBefore;
+    uint64_t InstructionsAfter;
+    /// Bytes allocated by malloc before and after the run, if the host
+    /// provides that information (zero otherwise).
+    uint64_t MallocBefore;
+    uint64_t MallocAfter;
+    /// The thread which ran the pass, as returned by llvm::get_threadid().
+    uint64_t ThreadID;
+  };
+
+  PassProfiler(StringRef OutputFilename, OutputFormat Format);
+
+  /// Writes the profile to the output file, if there is one.
+  ~PassProfiler();
+
+  /// Returns the process-wide profiler, or null if profiling is disabled.
+  static PassProfiler *get();
+
+  /// Enables profiling for the rest of the process even without
+  /// -pass-profile-output, for tools which consume the records directly
+  /// through takeRecords().
+  static void enable();
+
+  /// Returns the time since the profiler was created.
+  uint64_t getElapsedMicros() const;
+
+  /// Adds \p R to the profile. This is safe to call from multiple threads.
+  void addRecord(Record R);
+
+  /// Returns the records collected so far and removes them from the profile.
+  std::vector<Record> takeRecords();
+
+  /// Prints the profile to \p OS in the configured format.
+  void print(raw_ostream &OS) const;
+
+private:
+  std::string OutputFilename;
+  OutputFormat Format;
+  std::chrono::steady_clock::time_point Epoch;
+  std::vector<Record> Records;
+  /// Guards Records. A member rather than a ManagedStatic of its own, so that
+  /// it lives exactly as long as the records, including while the destructor
+  /// prints them from llvm_shutdown().
+  mutable sys::SmartMutex<true> RecordsMutex;
+};
+
+/// RAII helper which records a single run of a pass over a function when
+/// profiling is enabled, and does nothing otherwise.
+///
+/// Pass managers over other units of IR construct it as well; those
+/// instantiations are no-ops so that generic pass manager code does not need
+/// to special-case functions.
+class PassProfileRegion {
+public:
+  PassProfileRegion(StringRef PassName, Function &F);
+  template <typename IRUnitT> PassProfileRegion(StringRef, IRUnitT &) {}
+  ~PassProfileRegion();
+
+  PassProfileRegion(const PassProfileRegion &) = delete;
+  PassProfileRegion &operator=(const PassProfileRegion &) = delete;
+
+private:
+  PassProfiler *Profiler = nullptr;
+  Function *F = nullptr;
+  StringRef PassName;
+  uint64_t StartMicros = 0;
+  uint64_t InstructionsBefore = 0;
+  uint64_t MallocBefore = 0;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_IR_PASSPROFILER_H
@@ -20,6 +20,11 @@
 ///
 ///   http://www.llvm.org/docs/ProgrammersManual.html#UserLayout
 ///
+/// Walking the waymarks touches the neighbouring Uses, which makes iterating
+/// over the users of a value with many uses cache unfriendly. Builds with
+/// LLVM_ENABLE_USE_USER_POINTERS trade one word per Use for storing the User
+/// directly; the tags are maintained either way.
+///
 //===----------------------------------------------------------------------===//
 
 #ifndef LLVM_IR_USE_H
@@ -99,7 +104,11 @@ private:
   enum PrevPtrTag { zeroDigitTag, oneDigitTag, stopTag, fullStopTag };
 
   /// Constructor
-  Use(PrevPtrTag tag) { Prev.setInt(tag); }
+#if LLVM_ENABLE_USE_USER_POINTERS
+  Use(PrevPtrTag tag, User *Parent) : Parent(Parent) { Prev.setInt(tag); }
+#else
+  Use(PrevPtrTag tag, User *) { Prev.setInt(tag); }
+#endif
 
 public:
   friend class Value;
@@ -111,7 +120,11 @@ public:
   ///
   /// For an instruction operand, for example, this will return the
   /// instruction.
+#if LLVM_ENABLE_USE_USER_POINTERS
+  User *getUser() const { return Parent; }
+#else
   User *getUser() const LLVM_READONLY;
+#endif
 
   inline void set(Value *Val);
 
@@ -129,8 +142,9 @@ public:
   /// \brief Initializes the waymarking tags on an array of Uses.
   ///
   /// This sets up the array of Uses such that getUser() can find the User from
-  /// any of those Uses.
-  static Use *initTags(Use *Start, Use *Stop);
+  /// any of those Uses. \p U is the User owning the Uses; if it is null, the
+  /// User is assumed to be co-allocated right after \p Stop.
+  static Use *initTags(Use *Start, Use *Stop, User *U = nullptr);
 
   /// \brief Destroys Use operands when the number of operands of
   /// a User changes.
@@ -142,6 +156,9 @@ private:
   Value *Val = nullptr;
   Use *Next;
   PointerIntPair<Use **, 2, PrevPtrTag, PrevPointerTraits> Prev;
+#if LLVM_ENABLE_USE_USER_POINTERS
+  User *Parent;
+#endif
 
   void setPrev(Use **NewPrev) { Prev.setPointer(NewPrev); }
 
@@ -111,7 +111,7 @@ protected:
   ///
   /// Note, this should *NOT* be used directly by any class other than User.
   /// User uses this value to find the Use list.
-  enum : unsigned { NumUserOperandsBits = 28 };
+  enum : unsigned { NumUserOperandsBits = 27 };
   unsigned NumUserOperands : NumUserOperandsBits;
 
   // Use the same type as the bitfield above so that MSVC will pack them.
@@ -119,6 +119,9 @@ protected:
   unsigned HasName : 1;
   unsigned HasHungOffUses : 1;
   unsigned HasDescriptor : 1;
+  /// Set by the operator new of User and BasicBlock if the object was
+  /// allocated from an IRArena.
+  unsigned IsArenaAllocated : 1;
 
 private:
   template <typename UseT> // UseT == 'Use' or 'const Use'
@@ -342,8 +342,10 @@ inline Reader::symbol_range Reader::module_symbols(unsigned I) const {
           SymbolRef(MEnd, MEnd, nullptr, this)};
 }
 
-/// The contents of the irsymtab in a bitcode file. Any underlying data for the
-/// irsymtab are owned by Symtab and Strtab.
+/// The contents of the irsymtab in a bitcode file. If the file has an
+/// up-to-date irsymtab, TheReader refers directly to the symbol and string
+/// tables in the file's buffer and nothing is copied; otherwise the irsymtab
+/// is rebuilt from the modules and owned by Symtab and Strtab.
 struct FileContents {
   SmallVector<char, 0> Symtab, Strtab;
   Reader TheReader;
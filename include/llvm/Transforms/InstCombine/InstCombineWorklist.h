@@ -27,6 +27,9 @@ namespace llvm {
 class InstCombineWorklist {
   SmallVector<Instruction*, 256> Worklist;
   DenseMap<Instruction*, unsigned> WorklistMap;
+  /// Instructions to visit once the worklist is otherwise empty.
+  SmallVector<Instruction*, 16> Deferred;
+  DenseMap<Instruction*, unsigned> DeferredMap;
 
 public:
   InstCombineWorklist() = default;
@@ -34,7 +37,7 @@ public:
   InstCombineWorklist(InstCombineWorklist &&) = default;
   InstCombineWorklist &operator=(InstCombineWorklist &&) = default;
 
-  bool isEmpty() const { return Worklist.empty(); }
+  bool isEmpty() const { return Worklist.empty() && Deferred.empty(); }
 
   /// Add - Add the specified instruction to the worklist if it isn't already
   /// in it.
@@ -45,6 +48,16 @@ public:
     }
   }
 
+  /// AddDeferred - Add the specified instruction to the worklist once
+  /// everything else has been visited.
+  void AddDeferred(Instruction *I) {
+    if (!WorklistMap.count(I) &&
+        DeferredMap.insert(std::make_pair(I, Deferred.size())).second) {
+      DEBUG(dbgs() << "IC: ADD DEFERRED: " << *I << '\n');
+      Deferred.push_back(I);
+    }
+  }
+
   void AddValue(Value *V) {
     if (Instruction *I = dyn_cast<Instruction>(V))
       Add(I);
@@ -67,7 +80,13 @@ public:
 
   // Remove - remove I from the worklist if it exists.
   void Remove(Instruction *I) {
-    DenseMap<Instruction*, unsigned>::iterator It = WorklistMap.find(I);
+    DenseMap<Instruction*, unsigned>::iterator It = DeferredMap.find(I);
+    if (It != DeferredMap.end()) {
+      Deferred[It->second] = nullptr;
+      DeferredMap.erase(It);
+    }
+
+    It = WorklistMap.find(I);
     if (It == WorklistMap.end()) return; // Not in worklist.
 
     // Don't bother moving everything down, just null out the slot.
@@ -76,7 +95,19 @@ public:
     WorklistMap.erase(It);
   }
 
+  /// RemoveOne - Remove an instruction from the worklist. The result may be
+  /// null, if it was removed with Remove.
   Instruction *RemoveOne() {
+    if (Worklist.empty()) {
+      // Visit the deferred instructions in the order they were added.
+      for (Instruction *I : reverse(Deferred))
+        if (I)
+          Add(I);
+      Deferred.clear();
+      DeferredMap.clear();
+      if (Worklist.empty())
+        return nullptr;
+    }
     Instruction *I = Worklist.pop_back_val();
     WorklistMap.erase(I);
     return I;
@@ -91,11 +122,23 @@ public:
       Add(cast<Instruction>(U));
   }
 
+  /// AddUseCountDecremented - V has lost a use: it may be dead now, and if it
+  /// is left with a single user, the folds limited to single-use operands may
+  /// apply to that user. Both are only revisited once the worklist has been
+  /// drained, so that they do not preempt the folds already pending.
+  void AddUseCountDecremented(Value *V) {
+    if (Instruction *I = dyn_cast<Instruction>(V)) {
+      AddDeferred(I);
+      if (I->hasOneUse())
+        AddDeferred(cast<Instruction>(*I->user_begin()));
+    }
+  }
 
   /// Zap - check that the worklist is empty and nuke the backing store for
   /// the map if it is large.
   void Zap() {
-    assert(WorklistMap.empty() && "Worklist empty, but map not?");
+    assert(WorklistMap.empty() && DeferredMap.empty() &&
+           "Worklist empty, but map not?");
 
     // Do an explicit clear, this shrinks the map if needed.
     WorklistMap.clear();
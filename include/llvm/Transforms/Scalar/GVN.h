@@ -25,6 +25,7 @@
 #include "llvm/IR/Dominators.h"
 #include "llvm/IR/InstrTypes.h"
 #include "llvm/IR/PassManager.h"
+#include "llvm/IR/ValueHandle.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/Compiler.h"
 #include <cstdint>
@@ -44,6 +45,9 @@ class FunctionPass;
 class IntrinsicInst;
 class LoadInst;
 class LoopInfo;
+class MemoryAccess;
+class MemorySSA;
+class MemorySSAUpdater;
 class OptimizationRemarkEmitter;
 class PHINode;
 class TargetLibraryInfo;
@@ -157,6 +161,19 @@ private:
   SetVector<BasicBlock *> DeadBlocks;
   OptimizationRemarkEmitter *ORE;
 
+  /// MemorySSA for the function and its updater, while the redundant load
+  /// elimination iterations run with -enable-gvn-memoryssa.
+  MemorySSA *MSSA = nullptr;
+  MemorySSAUpdater *MSSAU = nullptr;
+
+  /// The loads processed so far in this iteration, by pointer operand and
+  /// clobbering access, for getMemorySSADependency to find an earlier load
+  /// that L is redundant with. Loads are visited in RPO, so one dominating L
+  /// is already there.
+  DenseMap<std::pair<const Value *, const MemoryAccess *>,
+           SmallVector<WeakVH, 1>>
+      MemorySSALoads;
+
   ValueTable VN;
 
   /// A mapping from value numbers to lists of Value*'s that
@@ -239,6 +256,12 @@ private:
   // Helper functions of redundant load elimination
   bool processLoad(LoadInst *L);
   bool processNonLocalLoad(LoadInst *L);
+
+  /// Returns the dependency of \p L found with MemorySSA: the instruction
+  /// dominating it which it can reuse the value of (Def) or which may write
+  /// to its memory (Clobber), or NonLocal if its memory is written in
+  /// different ways on the paths leading to it.
+  MemDepResult getMemorySSADependency(LoadInst *L);
   bool processAssumeIntrinsic(IntrinsicInst *II);
 
   /// Given a local dependency (Def or Clobber) determine if a value is
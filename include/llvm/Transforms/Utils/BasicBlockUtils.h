@@ -27,14 +27,17 @@ namespace llvm {
 
 class MemoryDependenceResults;
 class DominatorTree;
+class DomTreeUpdater;
 class LoopInfo;
 class Instruction;
 class MDNode;
 class ReturnInst;
 class TargetLibraryInfo;
 
-/// Delete the specified block, which must have no predecessors.
-void DeleteDeadBlock(BasicBlock *BB);
+/// Delete the specified block, which must have no predecessors. If \p DTU is
+/// given, the deleted CFG edges are reported to it, and the block is deleted
+/// through it.
+void DeleteDeadBlock(BasicBlock *BB, DomTreeUpdater *DTU = nullptr);
 
 /// We know that BB has one predecessor. If there are any single-entry PHI nodes
 /// in it, fold them away. This handles the case when all entries to the PHI
@@ -63,7 +63,9 @@ static cl::opt<bool> DisableBasicAA("disable-basicaa", cl::Hidden,
                                     cl::init(false));
 
 AAResults::AAResults(AAResults &&Arg)
-    : TLI(Arg.TLI), AAs(std::move(Arg.AAs)), AADeps(std::move(Arg.AADeps)) {
+    : TLI(Arg.TLI), AAs(std::move(Arg.AAs)), AADeps(std::move(Arg.AADeps)),
+      BatchDepth(Arg.BatchDepth),
+      BatchAliasResults(std::move(Arg.BatchAliasResults)) {
   for (auto &AA : AAs)
     AA->setAAResults(this);
 }
@@ -99,14 +101,42 @@ bool AAResults::invalidate(Function &F, const PreservedAnalyses &PA,
 // Default chaining methods
 //===----------------------------------------------------------------------===//
 
+void AAResults::beginBatch() {
+  if (BatchDepth++ == 0)
+    for (const auto &AA : AAs)
+      AA->beginBatch();
+}
+
+void AAResults::endBatch() {
+  assert(BatchDepth && "No batch to end");
+  if (--BatchDepth != 0)
+    return;
+  for (const auto &AA : AAs)
+    AA->endBatch();
+  BatchAliasResults.clear();
+}
+
 AliasResult AAResults::alias(const MemoryLocation &LocA,
                              const MemoryLocation &LocB) {
+  bool CacheResult = BatchDepth && AliasQueryDepth == 0;
+  if (CacheResult) {
+    auto It = BatchAliasResults.find({LocA, LocB});
+    if (It != BatchAliasResults.end())
+      return It->second;
+  }
+
+  ++AliasQueryDepth;
+  AliasResult Result = MayAlias;
   for (const auto &AA : AAs) {
-    auto Result = AA->alias(LocA, LocB);
+    Result = AA->alias(LocA, LocB);
     if (Result != MayAlias)
-      return Result;
+      break;
   }
-  return MayAlias;
+  --AliasQueryDepth;
+
+  if (CacheResult)
+    BatchAliasResults[{LocA, LocB}] = Result;
+  return Result;
 }
 
 bool AAResults::pointsToConstantMemory(const MemoryLocation &Loc,
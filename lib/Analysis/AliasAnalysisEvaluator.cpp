@@ -139,6 +139,9 @@ void AAEvaluator::runInternal(Function &F, AAResults &AA) {
     errs() << "Function: " << F.getName() << ": " << Pointers.size()
            << " pointers, " << CallSites.size() << " call sites\n";
 
+  // Nothing changes the IR while the queries run.
+  BatchAAScope BatchAA(AA);
+
   // iterate over the worklist, and run the full (n^2)/2 disambiguations
   for (SetVector<Value *>::iterator I1 = Pointers.begin(), E = Pointers.end();
        I1 != E; ++I1) {
@@ -6,6 +6,11 @@
 namespace llvm {
 namespace cflaa {
 
+cl::opt<unsigned> SummaryThreads(
+    "cfl-summary-threads", cl::init(1), cl::Hidden,
+    cl::desc("The number of threads the CFL alias analyses build the "
+             "summaries of the functions a query needs on"));
+
 namespace {
 const unsigned AttrEscapedIndex = 0;
 const unsigned AttrUnknownIndex = 1;
@@ -39,11 +39,16 @@
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/CallSite.h"
+#include "llvm/Support/CommandLine.h"
 #include <bitset>
 
 namespace llvm {
 namespace cflaa {
 
+/// The number of threads the CFL alias analyses build the summaries of
+/// independent functions on (-cfl-summary-threads).
+extern cl::opt<unsigned> SummaryThreads;
+
 //===----------------------------------------------------------------------===//
 // AliasAttr related stuffs
 //===----------------------------------------------------------------------===//
@@ -14,6 +14,7 @@
 #include "llvm/Analysis/AliasSetTracker.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/MemoryLocation.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/CallSite.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DataLayout.h"
@@ -23,6 +24,7 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/Operator.h"
 #include "llvm/IR/Value.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/AtomicOrdering.h"
@@ -44,6 +46,42 @@ static cl::opt<unsigned>
                         cl::desc("The maximum number of pointers may-alias "
                                  "sets may contain before degradation"));
 
+static cl::opt<bool>
+    SaturateByObject("alias-set-saturate-by-object", cl::Hidden,
+                     cl::init(true),
+                     cl::desc("Keep one alias set per identified object when "
+                              "saturated, if all pointers are based on one"));
+
+/// The number of identified objects an alias set summarizes its pointers with.
+static const unsigned MaxSummaryObjects = 16;
+
+/// Returns the identified object \p Ptr is based on, or null if it is not
+/// known to be based on one.
+static const Value *getIdentifiedObject(const Value *Ptr) {
+  const Value *Object;
+  if (auto *I = dyn_cast<Instruction>(Ptr)) {
+    Object = GetUnderlyingObject(Ptr, I->getModule()->getDataLayout());
+  } else {
+    // Arguments, globals and constant expressions on them need no
+    // simplification, and so no DataLayout.
+    Object = Ptr->stripPointerCasts();
+    if (auto *GEP = dyn_cast<GEPOperator>(Object))
+      Object = GEP->getPointerOperand()->stripPointerCasts();
+  }
+  return isIdentifiedObject(Object) ? Object : nullptr;
+}
+
+void AliasSet::addObject(const Value *Object) {
+  if (UnknownObjects || is_contained(Objects, Object))
+    return;
+  if (!Object || Objects.size() == MaxSummaryObjects) {
+    UnknownObjects = true;
+    Objects.clear();
+    return;
+  }
+  Objects.push_back(Object);
+}
+
 /// mergeSetIn - Merge the specified alias set into this alias set.
 ///
 void AliasSet::mergeSetIn(AliasSet &AS, AliasSetTracker &AST) {
@@ -56,6 +94,12 @@ void AliasSet::mergeSetIn(AliasSet &AS, AliasSetTracker &AST) {
   Alias  |= AS.Alias;
   Volatile |= AS.Volatile;
 
+  if (AS.UnknownObjects)
+    addObject(nullptr);
+  for (const Value *Object : AS.Objects)
+    addObject(Object);
+  AS.Objects.clear();
+
   if (Alias == SetMustAlias) {
     // Check that these two merged sets really are must aliases.  Since both
     // used to be must-alias sets, we can just check any pointer from each set
@@ -117,6 +161,11 @@ void AliasSetTracker::removeAliasSet(AliasSet *AS) {
   if (AS->Alias == AliasSet::SetMayAlias)
     TotalMayAliasSetSize -= AS->size();
 
+  if (SaturatedByObject)
+    for (const Value *Object : AS->Objects)
+      if (SetForObject.lookup(Object) == AS)
+        SetForObject.erase(Object);
+
   AliasSets.erase(AS);
 }
 
@@ -149,6 +198,7 @@ void AliasSet::addPointer(AliasSetTracker &AST, PointerRec &Entry,
 
   Entry.setAliasSet(this);
   Entry.updateSizeAndAAInfo(Size, AAInfo);
+  addObject(getIdentifiedObject(Entry.getValue()));
 
   // Add it to the end of the list...
   ++SetSize;
@@ -185,11 +235,22 @@ void AliasSet::addUnknownInst(Instruction *I, AliasAnalysis &AA) {
 bool AliasSet::aliasesPointer(const Value *Ptr, uint64_t Size,
                               const AAMDNodes &AAInfo,
                               AliasAnalysis &AA) const {
+  return aliasesPointer(Ptr, Size, AAInfo, getIdentifiedObject(Ptr), AA);
+}
+
+bool AliasSet::aliasesPointer(const Value *Ptr, uint64_t Size,
+                              const AAMDNodes &AAInfo, const Value *Object,
+                              AliasAnalysis &AA) const {
   if (AliasAny)
     return true;
 
+  // Pointers based on different identified objects do not alias.
+  bool PointersMayAlias = mayAliasObject(Object);
+
   if (Alias == SetMustAlias) {
     assert(UnknownInsts.empty() && "Illegal must alias set!");
+    if (!PointersMayAlias)
+      return false;
 
     // If this is a set of MustAliases, only check to see if the pointer aliases
     // SOME value in the set.
@@ -202,10 +263,11 @@ bool AliasSet::aliasesPointer(const Value *Ptr, uint64_t Size,
 
   // If this is a may-alias set, we have to check all of the pointers in the set
   // to be sure it doesn't alias the set...
-  for (iterator I = begin(), E = end(); I != E; ++I)
-    if (AA.alias(MemoryLocation(Ptr, Size, AAInfo),
-                 MemoryLocation(I.getPointer(), I.getSize(), I.getAAInfo())))
-      return true;
+  if (PointersMayAlias)
+    for (iterator I = begin(), E = end(); I != E; ++I)
+      if (AA.alias(MemoryLocation(Ptr, Size, AAInfo),
+                   MemoryLocation(I.getPointer(), I.getSize(), I.getAAInfo())))
+        return true;
 
   // Check the unknown instructions...
   if (!UnknownInsts.empty()) {
@@ -255,6 +317,8 @@ void AliasSetTracker::clear() {
   
   // The alias sets should all be clear now.
   AliasSets.clear();
+  SaturatedByObject = false;
+  SetForObject.clear();
 }
 
 
@@ -264,10 +328,19 @@ void AliasSetTracker::clear() {
 AliasSet *AliasSetTracker::mergeAliasSetsForPointer(const Value *Ptr,
                                                     uint64_t Size,
                                                     const AAMDNodes &AAInfo) {
+  const Value *Object = getIdentifiedObject(Ptr);
+  if (SaturatedByObject) {
+    // Only the set of its object may alias a pointer based on one.
+    if (Object)
+      return SetForObject.lookup(Object);
+    return &mergeAllAliasSets();
+  }
+
   AliasSet *FoundSet = nullptr;
   for (iterator I = begin(), E = end(); I != E;) {
     iterator Cur = I++;
-    if (Cur->Forward || !Cur->aliasesPointer(Ptr, Size, AAInfo, AA)) continue;
+    if (Cur->Forward || !Cur->aliasesPointer(Ptr, Size, AAInfo, Object, AA))
+      continue;
     
     if (!FoundSet) {      // If this is the first alias set ptr can go into.
       FoundSet = &*Cur;   // Remember it.
@@ -344,6 +417,8 @@ AliasSet &AliasSetTracker::getAliasSetForPointer(Value *Pointer, uint64_t Size,
   // Otherwise create a new alias set to hold the loaded pointer.
   AliasSets.push_back(new AliasSet());
   AliasSets.back().addPointer(*this, Entry, Size, AAInfo);
+  if (SaturatedByObject)
+    SetForObject[AliasSets.back().Objects.front()] = &AliasSets.back();
   return AliasSets.back();
 }
 
@@ -442,6 +517,11 @@ void AliasSetTracker::addUnknown(Instruction *Inst) {
   if (!Inst->mayReadOrWriteMemory())
     return; // doesn't alias anything
 
+  // Telling the sets an unknown instruction touches apart would need alias
+  // queries against all of their pointers.
+  if (SaturatedByObject)
+    mergeAllAliasSets();
+
   AliasSet *AS = findAliasSetForUnknownInst(Inst);
   if (AS) {
     AS->addUnknownInst(Inst, AA);
@@ -550,10 +630,47 @@ void AliasSetTracker::copyValue(Value *From, Value *To) {
                  true);
 }
 
+bool AliasSetTracker::saturateByObject() {
+  assert(!AliasAnyAS && !SaturatedByObject && SetForObject.empty() &&
+         "Saturating twice");
+  for (AliasSet &AS : *this)
+    if (!AS.Forward && (AS.UnknownObjects || !AS.UnknownInsts.empty()))
+      return false;
+
+  // Merge the sets based on the same objects, so that each object has one.
+  for (iterator I = begin(), E = end(); I != E;) {
+    iterator Cur = I++;
+    if (Cur->Forward)
+      continue;
+    AliasSet *Target = nullptr;
+    for (const Value *Object : Cur->Objects)
+      if (AliasSet *AS = SetForObject.lookup(Object)) {
+        Target = AS;
+        break;
+      }
+    if (Target)
+      Target->mergeSetIn(*Cur, *this);
+    else
+      Target = &*Cur;
+    if (Target->UnknownObjects) {
+      // The merged set has too many objects to be summarized.
+      SetForObject.clear();
+      return false;
+    }
+    for (const Value *Object : Target->Objects)
+      SetForObject[Object] = Target;
+  }
+  SaturatedByObject = true;
+  return true;
+}
+
 AliasSet &AliasSetTracker::mergeAllAliasSets() {
-  assert(!AliasAnyAS && (TotalMayAliasSetSize > SaturationThreshold) &&
+  assert(!AliasAnyAS &&
+         (TotalMayAliasSetSize > SaturationThreshold || SaturatedByObject) &&
          "Full merge should happen once, when the saturation threshold is "
          "reached");
+  SaturatedByObject = false;
+  SetForObject.clear();
 
   // Collect all alias sets, so that we can drop references with impunity
   // without worrying about iterator invalidation.
@@ -594,9 +711,13 @@ AliasSet &AliasSetTracker::addPointer(Value *P, uint64_t Size,
   AliasSet &AS = getAliasSetForPointer(P, Size, AAInfo);
   AS.Access |= E;
 
-  if (!AliasAnyAS && (TotalMayAliasSetSize > SaturationThreshold)) {
+  if (!AliasAnyAS && !SaturatedByObject &&
+      (TotalMayAliasSetSize > SaturationThreshold)) {
     // The AST is now saturated. From here on, we conservatively consider all
-    // pointers to alias each-other.
+    // pointers to alias each-other, or, if they are all based on identified
+    // objects, all pointers based on the same object.
+    if (SaturateByObject && saturateByObject())
+      return *AS.getForwardedTarget(*this);
     return mergeAllAliasSets();
   }
 
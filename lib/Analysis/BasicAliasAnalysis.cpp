@@ -21,6 +21,7 @@
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/AssumptionCache.h"
 #include "llvm/Analysis/CFG.h"
+#include "llvm/Analysis/CaptureInfo.h"
 #include "llvm/Analysis/CaptureTracking.h"
 #include "llvm/Analysis/InstructionSimplify.h"
 #include "llvm/Analysis/LoopInfo.h"
@@ -93,7 +94,8 @@ bool BasicAAResult::invalidate(Function &F, const PreservedAnalyses &PA,
   // depend on them.
   if (Inv.invalidate<AssumptionAnalysis>(F, PA) ||
       (DT && Inv.invalidate<DominatorTreeAnalysis>(F, PA)) ||
-      (LI && Inv.invalidate<LoopAnalysis>(F, PA)))
+      (LI && Inv.invalidate<LoopAnalysis>(F, PA)) ||
+      (CI && Inv.invalidate<CaptureAnalysis>(F, PA)))
     return true;
 
   // Otherwise this analysis result remains valid.
@@ -106,15 +108,21 @@ bool BasicAAResult::invalidate(Function &F, const PreservedAnalyses &PA,
 
 /// Returns true if the pointer is to a function-local object that never
 /// escapes from the function.
-static bool isNonEscapingLocalObject(const Value *V) {
+static bool isNonEscapingLocalObject(const Value *V, CaptureInfo *CI) {
+  // Set StoreCaptures to True so that we can assume in our callers that the
+  // pointer is not the result of a load instruction. Currently
+  // PointerMayBeCaptured doesn't have any special analysis for the
+  // StoreCaptures=false case; if it did, our callers could be refined to be
+  // more precise. CaptureInfo always counts stores as captures.
+  auto MayBeCaptured = [&]() {
+    if (CI)
+      return CI->isCaptured(V, /*ReturnCaptures=*/false);
+    return PointerMayBeCaptured(V, false, /*StoreCaptures=*/true);
+  };
+
   // If this is a local allocation, check to see if it escapes.
   if (isa<AllocaInst>(V) || isNoAliasCall(V))
-    // Set StoreCaptures to True so that we can assume in our callers that the
-    // pointer is not the result of a load instruction. Currently
-    // PointerMayBeCaptured doesn't have any special analysis for the
-    // StoreCaptures=false case; if it did, our callers could be refined to be
-    // more precise.
-    return !PointerMayBeCaptured(V, false, /*StoreCaptures=*/true);
+    return !MayBeCaptured();
 
   // If this is an argument that corresponds to a byval or noalias argument,
   // then it has not escaped before entering the function.  Check if it escapes
@@ -124,7 +132,7 @@ static bool isNonEscapingLocalObject(const Value *V) {
       // Note even if the argument is marked nocapture, we still need to check
       // for copies made inside the function. The nocapture attribute only
       // specifies that there are no copies made that outlive the function.
-      return !PointerMayBeCaptured(V, false, /*StoreCaptures=*/true);
+      return !MayBeCaptured();
 
   return false;
 }
@@ -144,6 +152,52 @@ static bool isEscapeSource(const Value *V) {
   return false;
 }
 
+void BasicAAResult::beginBatch() {
+  if (BatchDepth++ == 0) {
+    Batch = llvm::make_unique<BatchCaches>();
+    // Uses which capture a pointer may have been added since the last batch,
+    // and nothing tells CaptureInfo about them.
+    if (CI)
+      CI->clear();
+  }
+}
+
+void BasicAAResult::endBatch() {
+  assert(BatchDepth && "No batch to end");
+  if (--BatchDepth == 0)
+    Batch.reset();
+}
+
+bool BasicAAResult::decomposeGEP(const Value *V, DecomposedGEP &Decomposed) {
+  if (!Batch)
+    return DecomposeGEPExpression(V, Decomposed, DL, &AC, DT);
+  auto Inserted = Batch->DecomposedGEPs.insert({V, {DecomposedGEP(), false}});
+  auto &Cached = Inserted.first->second;
+  if (Inserted.second)
+    Cached.second = DecomposeGEPExpression(V, Cached.first, DL, &AC, DT);
+  Decomposed = Cached.first;
+  return Cached.second;
+}
+
+const Value *BasicAAResult::getUnderlyingObject(const Value *V) {
+  if (!Batch)
+    return GetUnderlyingObject(V, DL, MaxLookupSearchDepth);
+  const Value *&Object = Batch->UnderlyingObjects[V];
+  if (!Object)
+    Object = GetUnderlyingObject(V, DL, MaxLookupSearchDepth);
+  return Object;
+}
+
+bool BasicAAResult::isNonEscapingLocal(const Value *V) {
+  // CaptureInfo is only trusted while the IR cannot change.
+  if (!Batch)
+    return isNonEscapingLocalObject(V, nullptr);
+  auto Inserted = Batch->NonEscapingLocals.insert({V, false});
+  if (Inserted.second)
+    Inserted.first->second = isNonEscapingLocalObject(V, CI);
+  return Inserted.first->second;
+}
+
 /// Returns the size of the object specified by V or UnknownSize if unknown.
 static uint64_t getObjectSize(const Value *V, const DataLayout &DL,
                               const TargetLibraryInfo &TLI,
@@ -756,7 +810,7 @@ ModRefInfo BasicAAResult::getModRefInfo(ImmutableCallSite CS,
   assert(notDifferentParent(CS.getInstruction(), Loc.Ptr) &&
          "AliasAnalysis query involving multiple functions!");
 
-  const Value *Object = GetUnderlyingObject(Loc.Ptr, DL);
+  const Value *Object = getUnderlyingObject(Loc.Ptr);
 
   // If this is a tail call and Loc.Ptr points to a stack location, we know that
   // the tail call cannot access or modify the local stack.
@@ -772,7 +826,7 @@ ModRefInfo BasicAAResult::getModRefInfo(ImmutableCallSite CS,
   // then the call can not mod/ref the pointer unless the call takes the pointer
   // as an argument, and itself doesn't capture it.
   if (!isa<Constant>(Object) && CS.getInstruction() != Object &&
-      isNonEscapingLocalObject(Object)) {
+      isNonEscapingLocal(Object)) {
 
     // Optimistically assume that call doesn't touch Object and check this
     // assumption in the following loop.
@@ -1159,10 +1213,8 @@ AliasResult BasicAAResult::aliasGEP(const GEPOperator *GEP1, uint64_t V1Size,
                                     const Value *UnderlyingV1,
                                     const Value *UnderlyingV2) {
   DecomposedGEP DecompGEP1, DecompGEP2;
-  bool GEP1MaxLookupReached =
-    DecomposeGEPExpression(GEP1, DecompGEP1, DL, &AC, DT);
-  bool GEP2MaxLookupReached =
-    DecomposeGEPExpression(V2, DecompGEP2, DL, &AC, DT);
+  bool GEP1MaxLookupReached = decomposeGEP(GEP1, DecompGEP1);
+  bool GEP2MaxLookupReached = decomposeGEP(V2, DecompGEP2);
 
   int64_t GEP1BaseOffset = DecompGEP1.StructOffset + DecompGEP1.OtherOffset;
   int64_t GEP2BaseOffset = DecompGEP2.StructOffset + DecompGEP2.OtherOffset;
@@ -1560,10 +1612,10 @@ AliasResult BasicAAResult::aliasCheck(const Value *V1, uint64_t V1Size,
 
   // Figure out what objects these things are pointing to if we can.
   if (O1 == nullptr)
-    O1 = GetUnderlyingObject(V1, DL, MaxLookupSearchDepth);
+    O1 = getUnderlyingObject(V1);
 
   if (O2 == nullptr)
-    O2 = GetUnderlyingObject(V2, DL, MaxLookupSearchDepth);
+    O2 = getUnderlyingObject(V2);
 
   // Null values in the default address space don't point to any object, so they
   // don't alias any other pointer.
@@ -1599,9 +1651,9 @@ AliasResult BasicAAResult::aliasCheck(const Value *V1, uint64_t V1Size,
     // temporary store the nocapture argument's value in a temporary memory
     // location if that memory location doesn't escape. Or it may pass a
     // nocapture value to other functions as long as they don't capture it.
-    if (isEscapeSource(O1) && isNonEscapingLocalObject(O2))
+    if (isEscapeSource(O1) && isNonEscapingLocal(O2))
       return NoAlias;
-    if (isEscapeSource(O2) && isNonEscapingLocalObject(O1))
+    if (isEscapeSource(O2) && isNonEscapingLocal(O1))
       return NoAlias;
   }
 
@@ -1818,7 +1870,8 @@ BasicAAResult BasicAA::run(Function &F, FunctionAnalysisManager &AM) {
                        AM.getResult<TargetLibraryAnalysis>(F),
                        AM.getResult<AssumptionAnalysis>(F),
                        &AM.getResult<DominatorTreeAnalysis>(F),
-                       AM.getCachedResult<LoopAnalysis>(F));
+                       AM.getCachedResult<LoopAnalysis>(F),
+                       AM.getCachedResult<CaptureAnalysis>(F));
 }
 
 BasicAAWrapperPass::BasicAAWrapperPass() : FunctionPass(ID) {
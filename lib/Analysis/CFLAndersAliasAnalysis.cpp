@@ -63,6 +63,7 @@
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/MemoryLocation.h"
@@ -89,6 +90,8 @@ using namespace llvm::cflaa;
 
 #define DEBUG_TYPE "cfl-anders-aa"
 
+STATISTIC(NumFunctionsScanned, "Number of functions analyzed");
+
 CFLAndersAAResult::CFLAndersAAResult(const TargetLibraryInfo &TLI) : TLI(TLI) {}
 CFLAndersAAResult::CFLAndersAAResult(CFLAndersAAResult &&RHS)
     : AAResultBase(std::move(RHS)), TLI(RHS.TLI) {}
@@ -806,17 +809,21 @@ CFLAndersAAResult::buildInfoFrom(const Function &Fn) {
 }
 
 void CFLAndersAAResult::scan(const Function &Fn) {
-  auto InsertPair = Cache.insert(std::make_pair(&Fn, Optional<FunctionInfo>()));
-  (void)InsertPair;
-  assert(InsertPair.second &&
+  assert(!Cache.count(&Fn) &&
          "Trying to scan a function that has already been cached");
 
-  // Note that we can't do Cache[Fn] = buildSetsFrom(Fn) here: the function call
-  // may get evaluated after operator[], potentially triggering a DenseMap
-  // resize and invalidating the reference returned by operator[]
-  auto FunInfo = buildInfoFrom(Fn);
-  Cache[&Fn] = std::move(FunInfo);
-  Handles.emplace_front(const_cast<Function *>(&Fn), this);
+  buildCalleesFirst(
+      TLI, Fn,
+      [&](const Function &F) {
+        return Cache.insert(std::make_pair(&F, Optional<FunctionInfo>()))
+            .second;
+      },
+      [&](const Function &F) { return buildInfoFrom(F); },
+      [&](const Function &F, FunctionInfo FunInfo) {
+        Cache[&F] = std::move(FunInfo);
+        Handles.emplace_front(const_cast<Function *>(&F), this);
+        ++NumFunctionsScanned;
+      });
 }
 
 void CFLAndersAAResult::evict(const Function *Fn) { Cache.erase(Fn); }
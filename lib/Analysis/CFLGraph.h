@@ -19,6 +19,8 @@
 #include "AliasAnalysisSummary.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Analysis/MemoryBuiltins.h"
@@ -37,8 +39,10 @@
 #include "llvm/IR/Operator.h"
 #include "llvm/IR/Type.h"
 #include "llvm/IR/Value.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/ErrorHandling.h"
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <vector>
@@ -665,6 +669,147 @@ public:
   }
 };
 
+/// Collects, in order, the functions whose summaries building the graph of
+/// \p Fn asks for: those of the calls tryInterproceduralAnalysis may handle.
+inline void getSummarizedCallees(const TargetLibraryInfo &TLI,
+                                 const Function &Fn,
+                                 SmallVectorImpl<const Function *> &Callees) {
+  for (const BasicBlock &BB : Fn)
+    for (const Instruction &I : BB) {
+      ImmutableCallSite CS(&I);
+      if (!CS)
+        continue;
+      const Function *Callee = CS.getCalledFunction();
+      if (!Callee || !Callee->hasExactDefinition() || Callee->isVarArg() ||
+          CS.arg_size() > MaxSupportedArgsInSummary)
+        continue;
+      if (isMallocOrCallocLikeFn(&I, &TLI) || isFreeCall(&I, &TLI))
+        continue;
+      if (!is_contained(Callees, Callee))
+        Callees.push_back(Callee);
+    }
+}
+
+/// Computes ahead the layouts of the structs the GEPs of \p Fn index into,
+/// which DataLayout otherwise computes and caches on the first query, so that
+/// graphs can be built on several threads.
+inline void computeStructLayouts(const DataLayout &DL, const Function &Fn) {
+  SmallVector<Type *, 16> Types;
+  SmallVector<const ConstantExpr *, 16> Exprs;
+  SmallPtrSet<const ConstantExpr *, 16> VisitedExprs;
+  auto AddOperands = [&](const User &U) {
+    if (auto *GEP = dyn_cast<GEPOperator>(&U))
+      Types.push_back(GEP->getSourceElementType());
+    for (const Value *Op : U.operands())
+      if (auto *CE = dyn_cast<ConstantExpr>(Op))
+        if (VisitedExprs.insert(CE).second)
+          Exprs.push_back(CE);
+  };
+  for (const BasicBlock &BB : Fn)
+    for (const Instruction &I : BB)
+      AddOperands(I);
+  while (!Exprs.empty())
+    AddOperands(*Exprs.pop_back_val());
+
+  SmallPtrSet<Type *, 16> VisitedTypes;
+  while (!Types.empty()) {
+    Type *Ty = Types.pop_back_val();
+    if (!VisitedTypes.insert(Ty).second)
+      continue;
+    if (auto *STy = dyn_cast<StructType>(Ty)) {
+      // isSized caches its result in the type as well.
+      if (!STy->isSized())
+        continue;
+      DL.getStructLayout(STy);
+      Types.append(STy->element_begin(), STy->element_end());
+    } else if (auto *SeqTy = dyn_cast<SequentialType>(Ty)) {
+      Types.push_back(SeqTy->getElementType());
+    }
+  }
+}
+
+/// Builds the cache entry of \p Fn after those of the functions whose
+/// summaries it needs, directly or not: callees before callers, in the order
+/// the graph builders would otherwise build them recursively. This keeps a
+/// single graph alive at a time, whatever the depth of the call graph.
+///
+/// \p Begin is called first on each function, and marks it as being built in
+/// the cache; it returns false if the function is cached or being built
+/// already, which leaves the summaries of recursive calls unavailable as
+/// before. \p Build then returns the entry, which \p Finish stores.
+///
+/// With -cfl-summary-threads above one, the functions are instead grouped by
+/// level, a function being one level above the highest of the callees built
+/// before it, and the functions of a level are built in parallel. \p Build
+/// must then only read the cache, which holds the entries of all the lower
+/// levels: each function sees the same summaries as when built in order.
+template <typename BeginT, typename BuildT, typename FinishT>
+void buildCalleesFirst(const TargetLibraryInfo &TLI, const Function &Fn,
+                       BeginT Begin, BuildT Build, FinishT Finish) {
+  struct Frame {
+    const Function *Fn;
+    SmallVector<const Function *, 8> Callees;
+    /// The number of callees visited so far.
+    unsigned Next;
+  };
+  auto Push = [&](SmallVectorImpl<Frame> &Stack, const Function &F) {
+    Stack.emplace_back();
+    Stack.back().Fn = &F;
+    getSummarizedCallees(TLI, F, Stack.back().Callees);
+    Stack.back().Next = 0;
+  };
+
+  if (!Begin(Fn))
+    return;
+  bool Parallel = SummaryThreads > 1;
+  DenseMap<const Function *, unsigned> Levels;
+  std::vector<SmallVector<const Function *, 8>> FunctionsByLevel;
+  SmallVector<Frame, 8> Stack;
+  Push(Stack, Fn);
+  while (!Stack.empty()) {
+    Frame &Top = Stack.back();
+    if (Top.Next != Top.Callees.size()) {
+      const Function *Callee = Top.Callees[Top.Next++];
+      if (Begin(*Callee))
+        Push(Stack, *Callee);
+      continue;
+    }
+    if (!Parallel) {
+      const Function *F = Stack.pop_back_val().Fn;
+      Finish(*F, Build(*F));
+      continue;
+    }
+    // Callees without a level were cached before, or are still on the stack
+    // and get no summary.
+    unsigned Level = 0;
+    for (const Function *Callee : Top.Callees) {
+      auto It = Levels.find(Callee);
+      if (It != Levels.end())
+        Level = std::max(Level, It->second + 1);
+    }
+    const Function *F = Stack.pop_back_val().Fn;
+    Levels[F] = Level;
+    if (Level == FunctionsByLevel.size())
+      FunctionsByLevel.emplace_back();
+    FunctionsByLevel[Level].push_back(F);
+  }
+  if (!Parallel)
+    return;
+
+  const DataLayout &DL = Fn.getParent()->getDataLayout();
+  ThreadPool Pool(SummaryThreads);
+  for (ArrayRef<const Function *> Functions : FunctionsByLevel) {
+    for (const Function *F : Functions)
+      computeStructLayouts(DL, *F);
+    std::vector<Optional<decltype(Build(Fn))>> Entries(Functions.size());
+    for (unsigned I = 0, E = Functions.size(); I != E; ++I)
+      Pool.async([&, I] { Entries[I] = Build(*Functions[I]); });
+    Pool.wait();
+    for (unsigned I = 0, E = Functions.size(); I != E; ++I)
+      Finish(*Functions[I], std::move(*Entries[I]));
+  }
+}
+
 } // end namespace cflaa
 } // end namespace llvm
 
@@ -42,6 +42,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
@@ -61,6 +62,8 @@ using namespace llvm::cflaa;
 
 #define DEBUG_TYPE "cfl-steens-aa"
 
+STATISTIC(NumFunctionsScanned, "Number of functions analyzed");
+
 CFLSteensAAResult::CFLSteensAAResult(const TargetLibraryInfo &TLI)
     : AAResultBase(), TLI(TLI) {}
 CFLSteensAAResult::CFLSteensAAResult(CFLSteensAAResult &&Arg)
@@ -224,18 +227,27 @@ CFLSteensAAResult::FunctionInfo CFLSteensAAResult::buildSetsFrom(Function *Fn) {
 }
 
 void CFLSteensAAResult::scan(Function *Fn) {
-  auto InsertPair = Cache.insert(std::make_pair(Fn, Optional<FunctionInfo>()));
-  (void)InsertPair;
-  assert(InsertPair.second &&
+  assert(!Cache.count(Fn) &&
          "Trying to scan a function that has already been cached");
 
-  // Note that we can't do Cache[Fn] = buildSetsFrom(Fn) here: the function call
-  // may get evaluated after operator[], potentially triggering a DenseMap
-  // resize and invalidating the reference returned by operator[]
-  auto FunInfo = buildSetsFrom(Fn);
-  Cache[Fn] = std::move(FunInfo);
-
-  Handles.emplace_front(Fn, this);
+  buildCalleesFirst(
+      TLI, *Fn,
+      [&](const Function &F) {
+        return Cache
+            .insert(std::make_pair(const_cast<Function *>(&F),
+                                   Optional<FunctionInfo>()))
+            .second;
+      },
+      [&](const Function &F) {
+        return buildSetsFrom(const_cast<Function *>(&F));
+      },
+      [&](const Function &F, FunctionInfo FunInfo) {
+        Function *Fun = const_cast<Function *>(&F);
+        Cache[Fun] = std::move(FunInfo);
+
+        Handles.emplace_front(Fun, this);
+        ++NumFunctionsScanned;
+      });
 }
 
 void CFLSteensAAResult::evict(Function *Fn) { Cache.erase(Fn); }
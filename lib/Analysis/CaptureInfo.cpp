@@ -0,0 +1,238 @@
+//===- CaptureInfo.cpp - Memoized capture tracking ------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements CaptureInfo and the analysis pass providing it.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/CaptureInfo.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/CaptureTracking.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/ValueMap.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace llvm;
+
+namespace {
+/// Finds the earliest reachable capture of a pointer, both counting returns
+/// as captures and not.
+struct EarliestCaptureTracker : public CaptureTracker {
+  explicit EarliestCaptureTracker(const DominatorTree &DT) : DT(DT) {}
+
+  void tooManyUses() override {
+    // Not reached, as all uses are explored; be conservative anyway.
+    for (bool ReturnCaptures : {false, true}) {
+      Captured[ReturnCaptures] = true;
+      Earliest[ReturnCaptures] = &DT.getRoot()->front();
+    }
+  }
+
+  bool captured(const Use *U) override {
+    const Instruction *I = cast<Instruction>(U->getUser());
+    bool Reachable = DT.isReachableFromEntry(I->getParent());
+    for (bool ReturnCaptures : {false, true}) {
+      if (isa<ReturnInst>(I) && !ReturnCaptures)
+        continue;
+      Captured[ReturnCaptures] = true;
+      if (Reachable)
+        addCapture(Earliest[ReturnCaptures], I);
+    }
+    // Keep going, all captures have to be seen.
+    return false;
+  }
+
+  /// Makes \p Earliest the nearest common dominator of itself and \p I.
+  void addCapture(const Instruction *&Earliest, const Instruction *I) {
+    if (!Earliest) {
+      Earliest = I;
+      return;
+    }
+    const BasicBlock *BB = Earliest->getParent();
+    const BasicBlock *IBB = I->getParent();
+    if (BB == IBB) {
+      for (const Instruction &Inst : *BB) {
+        if (&Inst == Earliest)
+          return;
+        if (&Inst == I)
+          break;
+      }
+      Earliest = I;
+      return;
+    }
+    const BasicBlock *Dom = DT.findNearestCommonDominator(BB, IBB);
+    if (Dom == IBB)
+      Earliest = I;
+    else if (Dom != BB)
+      Earliest = Dom->getTerminator();
+  }
+
+  const DominatorTree &DT;
+  bool Captured[2] = {false, false};
+  const Instruction *Earliest[2] = {nullptr, nullptr};
+};
+
+/// The capture status of a pointer, indexed by whether returns count as
+/// captures.
+struct CaptureEntry {
+  bool Captured[2];
+  const Instruction *Earliest[2];
+};
+} // end anonymous namespace
+
+struct CaptureInfo::Storage {
+  /// Maps each value some entries depend on to the pointers of those
+  /// entries: the value itself, if it is a pointer with an entry, and the
+  /// pointers it is the earliest capture of. Deleting the value drops them.
+  /// Replacing it also drops those depending on the new value, which takes
+  /// over the uses, and possibly the captures.
+  struct DependentsConfig : ValueMapConfig<const Value *> {
+    enum { FollowRAUW = false };
+    using ExtraData = Storage *;
+
+    static void onRAUW(Storage *S, const Value *Old, const Value *New) {
+      S->forget(Old);
+      S->forget(New);
+    }
+    static void onDelete(Storage *S, const Value *V) { S->forget(V); }
+  };
+
+  Storage() : Dependents(this) {}
+
+  DenseMap<const Value *, CaptureEntry> Entries;
+  ValueMap<const Value *, SmallVector<const Value *, 2>, DependentsConfig>
+      Dependents;
+
+  const CaptureEntry &get(const Value *V, const DominatorTree &DT) {
+    auto It = Entries.find(V);
+    if (It != Entries.end())
+      return It->second;
+
+    EarliestCaptureTracker Tracker(DT);
+    PointerMayBeCaptured(V, &Tracker, /*MaxUsesToExplore=*/0);
+    CaptureEntry E;
+    for (bool ReturnCaptures : {false, true}) {
+      E.Captured[ReturnCaptures] = Tracker.Captured[ReturnCaptures];
+      E.Earliest[ReturnCaptures] = Tracker.Earliest[ReturnCaptures];
+      if (E.Earliest[ReturnCaptures])
+        track(E.Earliest[ReturnCaptures], V);
+    }
+    track(V, V);
+    return Entries.insert({V, E}).first->second;
+  }
+
+  void track(const Value *V, const Value *Pointer) {
+    Dependents[V].push_back(Pointer);
+  }
+
+  void forget(const Value *V) {
+    auto It = Dependents.find(V);
+    if (It == Dependents.end())
+      return;
+    SmallVector<const Value *, 2> Pointers = std::move(It->second);
+    Dependents.erase(It);
+    for (const Value *Pointer : Pointers)
+      forgetPointer(Pointer);
+  }
+
+  /// Drops the entry of \p Pointer and unregisters it from the values it
+  /// depends on.
+  void forgetPointer(const Value *Pointer) {
+    auto It = Entries.find(Pointer);
+    if (It == Entries.end())
+      return;
+    CaptureEntry E = It->second;
+    Entries.erase(It);
+    untrack(Pointer, Pointer);
+    for (const Instruction *Earliest : E.Earliest)
+      if (Earliest)
+        untrack(Earliest, Pointer);
+  }
+
+  void untrack(const Value *V, const Value *Pointer) {
+    auto It = Dependents.find(V);
+    if (It == Dependents.end())
+      return;
+    auto &Pointers = It->second;
+    Pointers.erase(std::remove(Pointers.begin(), Pointers.end(), Pointer),
+                   Pointers.end());
+  }
+};
+
+CaptureInfo::CaptureInfo(const DominatorTree &DT) : DT(DT), S(new Storage) {}
+
+CaptureInfo::CaptureInfo(CaptureInfo &&Arg) = default;
+
+CaptureInfo::~CaptureInfo() = default;
+
+bool CaptureInfo::isCaptured(const Value *V, bool ReturnCaptures) {
+  assert(!isa<GlobalValue>(V) &&
+         "It doesn't make sense to ask whether a global is captured.");
+  return S->get(V, DT).Captured[ReturnCaptures];
+}
+
+const Instruction *CaptureInfo::getEarliestCapture(const Value *V,
+                                                   bool ReturnCaptures) {
+  assert(!isa<GlobalValue>(V) &&
+         "It doesn't make sense to ask whether a global is captured.");
+  return S->get(V, DT).Earliest[ReturnCaptures];
+}
+
+void CaptureInfo::forgetValue(const Value *V) { S->forgetPointer(V); }
+
+void CaptureInfo::clear() {
+  S->Entries.clear();
+  S->Dependents.clear();
+}
+
+bool CaptureInfo::invalidate(Function &F, const PreservedAnalyses &PA,
+                             FunctionAnalysisManager::Invalidator &Inv) {
+  auto PAC = PA.getChecker<CaptureAnalysis>();
+  if (!PAC.preserved() && !PAC.preservedSet<AllAnalysesOn<Function>>())
+    return true;
+  return Inv.invalidate<DominatorTreeAnalysis>(F, PA);
+}
+
+AnalysisKey CaptureAnalysis::Key;
+
+CaptureInfo CaptureAnalysis::run(Function &F, FunctionAnalysisManager &AM) {
+  return CaptureInfo(AM.getResult<DominatorTreeAnalysis>(F));
+}
+
+PreservedAnalyses CaptureInfoPrinterPass::run(Function &F,
+                                              FunctionAnalysisManager &AM) {
+  CaptureInfo &CI = AM.getResult<CaptureAnalysis>(F);
+  OS << "Capture info for function '" << F.getName() << "':\n";
+  auto Print = [&](const Value &V) {
+    if (!V.getType()->isPointerTy())
+      return;
+    OS << "  ";
+    V.printAsOperand(OS, /*PrintType=*/false);
+    if (!CI.isCaptured(&V, /*ReturnCaptures=*/true)) {
+      OS << ": not captured\n";
+      return;
+    }
+    OS << ": captured";
+    if (!CI.isCaptured(&V, /*ReturnCaptures=*/false))
+      OS << " by returns only";
+    if (const Instruction *E = CI.getEarliestCapture(&V, true))
+      OS << ", earliest:" << *E;
+    OS << "\n";
+  };
+  for (Argument &A : F.args())
+    Print(A);
+  for (Instruction &I : instructions(F))
+    Print(I);
+  return PreservedAnalyses::all();
+}
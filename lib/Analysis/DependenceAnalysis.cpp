@@ -106,6 +106,7 @@ STATISTIC(GCDindependence, "GCD independence");
 STATISTIC(BanerjeeApplications, "Banerjee applications");
 STATISTIC(BanerjeeIndependence, "Banerjee independence");
 STATISTIC(BanerjeeSuccesses, "Banerjee successes");
+STATISTIC(DelinearizationCacheHits, "Delinearizations reused");
 
 static cl::opt<bool>
 Delinearize("da-delinearize", cl::init(false), cl::Hidden, cl::ZeroOrMore,
@@ -124,6 +125,19 @@ DependenceAnalysis::run(Function &F, FunctionAnalysisManager &FAM) {
 
 AnalysisKey DependenceAnalysis::Key;
 
+bool DependenceInfo::invalidate(Function &F, const PreservedAnalyses &PA,
+                                FunctionAnalysisManager::Invalidator &Inv) {
+  auto PAC = PA.getChecker<DependenceAnalysis>();
+  if (!PAC.preserved() && !PAC.preservedSet<AllAnalysesOn<Function>>())
+    return true;
+  if (Inv.invalidate<AAManager>(F, PA) ||
+      Inv.invalidate<ScalarEvolutionAnalysis>(F, PA) ||
+      Inv.invalidate<LoopAnalysis>(F, PA))
+    return true;
+  forgetCachedResults();
+  return false;
+}
+
 INITIALIZE_PASS_BEGIN(DependenceAnalysisWrapperPass, "da",
                       "Dependence Analysis", true, true)
 INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
@@ -3175,44 +3189,59 @@ void DependenceInfo::updateDirection(Dependence::DVEntry &Level,
 /// source and destination array references are recurrences on a nested loop,
 /// this function flattens the nested recurrences into separate recurrences
 /// for each loop level.
-bool DependenceInfo::tryDelinearize(Instruction *Src, Instruction *Dst,
-                                    SmallVectorImpl<Subscript> &Pair) {
-  Value *SrcPtr = getPointerOperand(Src);
-  Value *DstPtr = getPointerOperand(Dst);
-
-  Loop *SrcLoop = LI->getLoopFor(Src->getParent());
-  Loop *DstLoop = LI->getLoopFor(Dst->getParent());
+const DependenceInfo::DelinearizationInfo &
+DependenceInfo::getDelinearizationInfo(Instruction *I) {
+  auto It = DelinearizationCache.find_as(static_cast<Value *>(I));
+  if (It != DelinearizationCache.end()) {
+    ++DelinearizationCacheHits;
+    return *It->second;
+  }
+  DelinearizationInfo &Info =
+      *DelinearizationCache
+           .insert({DelinearizationCacheVH(I, this),
+                    llvm::make_unique<DelinearizationInfo>()})
+           .first->second;
 
   // Below code mimics the code in Delinearization.cpp
-  const SCEV *SrcAccessFn =
-    SE->getSCEVAtScope(SrcPtr, SrcLoop);
-  const SCEV *DstAccessFn =
-    SE->getSCEVAtScope(DstPtr, DstLoop);
+  const SCEV *AccessFn =
+    SE->getSCEVAtScope(getPointerOperand(I), LI->getLoopFor(I->getParent()));
+  Info.Base = dyn_cast<SCEVUnknown>(SE->getPointerBase(AccessFn));
+  if (!Info.Base)
+    return Info;
 
-  const SCEVUnknown *SrcBase =
-      dyn_cast<SCEVUnknown>(SE->getPointerBase(SrcAccessFn));
-  const SCEVUnknown *DstBase =
-      dyn_cast<SCEVUnknown>(SE->getPointerBase(DstAccessFn));
+  Info.ElementSize = SE->getElementSize(I);
+  const SCEVAddRecExpr *AR =
+      dyn_cast<SCEVAddRecExpr>(SE->getMinusSCEV(AccessFn, Info.Base));
+  if (!AR || !AR->isAffine())
+    return Info;
 
-  if (!SrcBase || !DstBase || SrcBase != DstBase)
-    return false;
+  Info.AccessFn = AR;
+  SE->collectParametricTerms(AR, Info.Terms);
+  return Info;
+}
+
+bool DependenceInfo::tryDelinearize(Instruction *Src, Instruction *Dst,
+                                    SmallVectorImpl<Subscript> &Pair) {
+  // The entries are allocated separately, and stay put when the cache grows.
+  const DelinearizationInfo &SrcInfo = getDelinearizationInfo(Src);
+  const DelinearizationInfo &DstInfo = getDelinearizationInfo(Dst);
 
-  const SCEV *ElementSize = SE->getElementSize(Src);
-  if (ElementSize != SE->getElementSize(Dst))
+  if (!SrcInfo.Base || !DstInfo.Base || SrcInfo.Base != DstInfo.Base)
     return false;
 
-  const SCEV *SrcSCEV = SE->getMinusSCEV(SrcAccessFn, SrcBase);
-  const SCEV *DstSCEV = SE->getMinusSCEV(DstAccessFn, DstBase);
+  const SCEV *ElementSize = SrcInfo.ElementSize;
+  if (ElementSize != DstInfo.ElementSize)
+    return false;
 
-  const SCEVAddRecExpr *SrcAR = dyn_cast<SCEVAddRecExpr>(SrcSCEV);
-  const SCEVAddRecExpr *DstAR = dyn_cast<SCEVAddRecExpr>(DstSCEV);
-  if (!SrcAR || !DstAR || !SrcAR->isAffine() || !DstAR->isAffine())
+  const SCEVAddRecExpr *SrcAR = SrcInfo.AccessFn;
+  const SCEVAddRecExpr *DstAR = DstInfo.AccessFn;
+  if (!SrcAR || !DstAR)
     return false;
 
   // First step: collect parametric terms in both array references.
-  SmallVector<const SCEV *, 4> Terms;
-  SE->collectParametricTerms(SrcAR, Terms);
-  SE->collectParametricTerms(DstAR, Terms);
+  SmallVector<const SCEV *, 4> Terms(SrcInfo.Terms.begin(),
+                                     SrcInfo.Terms.end());
+  Terms.append(DstInfo.Terms.begin(), DstInfo.Terms.end());
 
   // Second step: find subscript sizes.
   SmallVector<const SCEV *, 4> Sizes;
@@ -3945,3 +3974,14 @@ const SCEV *DependenceInfo::getSplitIteration(const Dependence &Dep,
   llvm_unreachable("somehow reached end of routine");
   return nullptr;
 }
+
+void DependenceInfo::DelinearizationCacheVH::deleted() {
+  auto It = DI->DelinearizationCache.find_as(getValPtr());
+  if (It != DI->DelinearizationCache.end())
+    DI->DelinearizationCache.erase(It);
+  // this now dangles!
+}
+
+void DependenceInfo::DelinearizationCacheVH::allUsesReplacedWith(Value *) {
+  deleted();
+}
@@ -0,0 +1,153 @@
+//===- DomTreeUpdater.cpp - Batched dominator tree updates ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements DomTreeUpdater, which applies the CFG updates reported
+// to it to a DominatorTree and a PostDominatorTree, eagerly or in batches.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/DomTreeUpdater.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Analysis/PostDominators.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+
+using namespace llvm;
+
+void DomTreeUpdater::applyUpdates(ArrayRef<DominatorTree::UpdateType> Updates) {
+  if (!DT && !PDT)
+    return;
+
+  // Reporting an edge once per duplicated successor is easy to do by mistake,
+  // and would unbalance the sequence. Self loops never change dominance.
+  // Batches are of the size of a successor list, searching them is fine.
+  SmallVector<DominatorTree::UpdateType, 8> Unique;
+  for (const auto &U : Updates)
+    if (U.getFrom() != U.getTo() && !is_contained(Unique, U))
+      Unique.push_back(U);
+  if (Unique.empty())
+    return;
+
+  if (isLazy()) {
+    PendUpdates.append(Unique.begin(), Unique.end());
+    return;
+  }
+  if (DT)
+    DT->applyUpdates(Unique);
+  if (PDT)
+    PDT->applyUpdates(Unique);
+}
+
+void DomTreeUpdater::insertEdge(BasicBlock *From, BasicBlock *To) {
+  applyUpdates({{DominatorTree::Insert, From, To}});
+}
+
+void DomTreeUpdater::deleteEdge(BasicBlock *From, BasicBlock *To) {
+  applyUpdates({{DominatorTree::Delete, From, To}});
+}
+
+void DomTreeUpdater::deleteBB(BasicBlock *DelBB) {
+  assert(pred_begin(DelBB) == pred_end(DelBB) &&
+         "Deleting a block with predecessors!");
+  while (!DelBB->empty()) {
+    Instruction &I = DelBB->back();
+    // Uses in other dead blocks may be left, and are replaced by an arbitrary
+    // value.
+    if (!I.use_empty())
+      I.replaceAllUsesWith(UndefValue::get(I.getType()));
+    DelBB->getInstList().pop_back();
+  }
+
+  if (isLazy()) {
+    // Keep the block well formed until the trees have forgotten it.
+    new UnreachableInst(DelBB->getContext(), DelBB);
+    DeletedBBs.insert(DelBB);
+    return;
+  }
+  eraseDelBB(DelBB);
+}
+
+void DomTreeUpdater::eraseDelBB(BasicBlock *DelBB) {
+  // An unreachable block has no node in the dominator tree. In the
+  // post-dominator tree, it is a leaf once its outgoing edges are gone.
+  if (DT && DT->getNode(DelBB))
+    DT->eraseNode(DelBB);
+  if (PDT && PDT->getNode(DelBB))
+    PDT->eraseNode(DelBB);
+  DelBB->eraseFromParent();
+}
+
+void DomTreeUpdater::recalculate(Function &F) {
+  for (const BasicBlock *BB : DeletedBBs)
+    const_cast<BasicBlock *>(BB)->eraseFromParent();
+  DeletedBBs.clear();
+  PendUpdates.clear();
+  PendDTUpdateIndex = PendPDTUpdateIndex = 0;
+
+  if (DT)
+    DT->recalculate(F);
+  if (PDT)
+    PDT->recalculate(F);
+}
+
+void DomTreeUpdater::applyDomTreeUpdates() {
+  if (!DT) {
+    PendDTUpdateIndex = PendUpdates.size();
+    return;
+  }
+  if (PendDTUpdateIndex == PendUpdates.size())
+    return;
+  DT->applyUpdates(makeArrayRef(PendUpdates).slice(PendDTUpdateIndex));
+  PendDTUpdateIndex = PendUpdates.size();
+}
+
+void DomTreeUpdater::applyPostDomTreeUpdates() {
+  if (!PDT) {
+    PendPDTUpdateIndex = PendUpdates.size();
+    return;
+  }
+  if (PendPDTUpdateIndex == PendUpdates.size())
+    return;
+  PDT->applyUpdates(makeArrayRef(PendUpdates).slice(PendPDTUpdateIndex));
+  PendPDTUpdateIndex = PendUpdates.size();
+}
+
+void DomTreeUpdater::tryFlushDeletedBBs() {
+  if (hasPendingUpdates())
+    return;
+  PendUpdates.clear();
+  PendDTUpdateIndex = PendPDTUpdateIndex = 0;
+
+  for (const BasicBlock *BB : DeletedBBs)
+    eraseDelBB(const_cast<BasicBlock *>(BB));
+  DeletedBBs.clear();
+}
+
+DominatorTree &DomTreeUpdater::getDomTree() {
+  assert(DT && "Invalid acquisition of a null DomTree");
+  applyDomTreeUpdates();
+  tryFlushDeletedBBs();
+  return *DT;
+}
+
+PostDominatorTree &DomTreeUpdater::getPostDomTree() {
+  assert(PDT && "Invalid acquisition of a null PostDomTree");
+  applyPostDomTreeUpdates();
+  tryFlushDeletedBBs();
+  return *PDT;
+}
+
+void DomTreeUpdater::flush() {
+  applyDomTreeUpdates();
+  applyPostDomTreeUpdates();
+  tryFlushDeletedBBs();
+}
@@ -0,0 +1,245 @@
+//===- KnownBitsCache.cpp - Memoized known bits ---------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the storage of KnownBitsCache and the analysis pass
+// providing it. The queries themselves live in ValueTracking.cpp.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/KnownBitsCache.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/AssumptionCache.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/ValueMap.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace llvm;
+
+namespace {
+using CacheKey = std::pair<const Value *, const Instruction *>;
+
+/// The number of uses forgetting a value may look at before the whole cache is
+/// dropped instead.
+const unsigned MaxForgetSteps = 64;
+
+/// The results known for a value in the context of an instruction. A budget of
+/// zero means the result has not been computed.
+struct CacheEntry {
+  KnownBits Known;
+  unsigned NumSignBits = 0;
+  bool NonZero = false;
+  uint8_t KnownBitsBudget = 0;
+  uint8_t NumSignBitsBudget = 0;
+  uint8_t NonZeroBudget = 0;
+};
+} // end anonymous namespace
+
+struct KnownBitsCache::Storage {
+  /// Drops the entries of a value, and of the values computed from it, when it
+  /// is deleted or replaced. The entries are dropped by forget(), which also
+  /// removes the value from the map.
+  struct TrackedConfig : ValueMapConfig<const Value *> {
+    enum { FollowRAUW = false };
+    using ExtraData = Storage *;
+
+    static void onRAUW(Storage *S, const Value *Old, const Value *) {
+      S->forget(Old);
+    }
+    static void onDelete(Storage *S, const Value *V) { S->forget(V); }
+  };
+
+  /// The keys of the entries a value takes part in, as the value or as the
+  /// context. The operands of a cached instruction are tracked with no keys of
+  /// their own, so that replacing them drops the results computed from them.
+  using TrackedMap = ValueMap<const Value *, SmallVector<CacheKey, 2>,
+                              TrackedConfig>;
+
+  Storage() : Tracked(this) {}
+
+  DenseMap<CacheKey, CacheEntry> Entries;
+  TrackedMap Tracked;
+
+  void clear() {
+    Entries.clear();
+    Tracked.clear();
+  }
+
+  const CacheEntry *lookup(const Value *V, const Instruction *CxtI) const {
+    auto It = Entries.find({V, CxtI});
+    return It == Entries.end() ? nullptr : &It->second;
+  }
+
+  CacheEntry &getOrCreate(const Value *V, const Instruction *CxtI) {
+    auto Inserted = Entries.insert({{V, CxtI}, CacheEntry()});
+    if (Inserted.second) {
+      Tracked[V].push_back({V, CxtI});
+      if (CxtI && CxtI != V)
+        Tracked[CxtI].push_back({V, CxtI});
+      if (auto *I = dyn_cast<Instruction>(V))
+        for (const Value *Op : I->operands())
+          if (!isa<Constant>(Op))
+            Tracked[Op];
+    }
+    return Inserted.first->second;
+  }
+
+  /// Drops the entries of \p V, and those of the instructions using it,
+  /// transitively, as their results may have been computed from \p V. Only
+  /// tracked values are walked through: a value without entries, which no
+  /// cached instruction uses, took part in no cached result. A walk looking at
+  /// more than MaxForgetSteps uses drops the whole cache instead, so that
+  /// replacing a value with many users stays cheap.
+  void forget(const Value *V) {
+    SmallVector<const Value *, 16> Worklist;
+    SmallPtrSet<const Value *, 16> Visited;
+    unsigned Steps = 0;
+    Worklist.push_back(V);
+    while (!Worklist.empty()) {
+      const Value *Cur = Worklist.pop_back_val();
+      if (!Tracked.count(Cur) || !Visited.insert(Cur).second)
+        continue;
+      forgetEntries(Cur);
+      for (const User *U : Cur->users()) {
+        if (++Steps > MaxForgetSteps) {
+          clear();
+          return;
+        }
+        if (isa<Instruction>(U))
+          Worklist.push_back(U);
+      }
+    }
+  }
+
+  void forgetEntries(const Value *V) {
+    auto It = Tracked.find(V);
+    if (It == Tracked.end())
+      return;
+    SmallVector<CacheKey, 2> Keys = std::move(It->second);
+    Tracked.erase(It);
+    for (const CacheKey &Key : Keys) {
+      Entries.erase(Key);
+      // Unregister the key from the other value it was tracked for.
+      const Value *Other = Key.first == V ? Key.second : Key.first;
+      if (!Other || Other == V)
+        continue;
+      auto OtherIt = Tracked.find(Other);
+      if (OtherIt == Tracked.end())
+        continue;
+      auto &OtherKeys = OtherIt->second;
+      OtherKeys.erase(std::remove(OtherKeys.begin(), OtherKeys.end(), Key),
+                      OtherKeys.end());
+    }
+  }
+};
+
+KnownBitsCache::KnownBitsCache(const DataLayout &DL, AssumptionCache *AC,
+                               const DominatorTree *DT)
+    : DL(DL), AC(AC), DT(DT), S(new Storage) {}
+
+KnownBitsCache::KnownBitsCache(KnownBitsCache &&Arg) = default;
+
+KnownBitsCache::~KnownBitsCache() = default;
+
+void KnownBitsCache::forgetValue(const Value *V) { S->forget(V); }
+
+void KnownBitsCache::clear() { S->clear(); }
+
+unsigned KnownBitsCache::getNumEntries() const { return S->Entries.size(); }
+
+bool KnownBitsCache::invalidate(Function &F, const PreservedAnalyses &PA,
+                                FunctionAnalysisManager::Invalidator &Inv) {
+  auto PAC = PA.getChecker<KnownBitsAnalysis>();
+  if (!PAC.preserved() && !PAC.preservedSet<AllAnalysesOn<Function>>())
+    return true;
+  return (AC && Inv.invalidate<AssumptionAnalysis>(F, PA)) ||
+         (DT && Inv.invalidate<DominatorTreeAnalysis>(F, PA));
+}
+
+const KnownBits *KnownBitsCache::lookupKnownBits(const Value *V,
+                                                 const Instruction *CxtI,
+                                                 unsigned Budget) const {
+  const CacheEntry *E = S->lookup(V, CxtI);
+  return E && E->KnownBitsBudget >= Budget ? &E->Known : nullptr;
+}
+
+void KnownBitsCache::insertKnownBits(const Value *V, const Instruction *CxtI,
+                                     unsigned Budget, const KnownBits &Known) {
+  CacheEntry &E = S->getOrCreate(V, CxtI);
+  if (E.KnownBitsBudget >= Budget)
+    return;
+  E.Known = Known;
+  E.KnownBitsBudget = Budget;
+}
+
+unsigned KnownBitsCache::lookupNumSignBits(const Value *V,
+                                           const Instruction *CxtI,
+                                           unsigned Budget) const {
+  const CacheEntry *E = S->lookup(V, CxtI);
+  return E && E->NumSignBitsBudget >= Budget ? E->NumSignBits : 0;
+}
+
+void KnownBitsCache::insertNumSignBits(const Value *V, const Instruction *CxtI,
+                                       unsigned Budget, unsigned NumSignBits) {
+  CacheEntry &E = S->getOrCreate(V, CxtI);
+  if (E.NumSignBitsBudget >= Budget)
+    return;
+  E.NumSignBits = NumSignBits;
+  E.NumSignBitsBudget = Budget;
+}
+
+Optional<bool> KnownBitsCache::lookupNonZero(const Value *V,
+                                             const Instruction *CxtI,
+                                             unsigned Budget) const {
+  const CacheEntry *E = S->lookup(V, CxtI);
+  if (E && E->NonZeroBudget >= Budget)
+    return E->NonZero;
+  return None;
+}
+
+void KnownBitsCache::insertNonZero(const Value *V, const Instruction *CxtI,
+                                   unsigned Budget, bool NonZero) {
+  CacheEntry &E = S->getOrCreate(V, CxtI);
+  if (E.NonZeroBudget >= Budget)
+    return;
+  E.NonZero = NonZero;
+  E.NonZeroBudget = Budget;
+}
+
+AnalysisKey KnownBitsAnalysis::Key;
+
+KnownBitsCache KnownBitsAnalysis::run(Function &F,
+                                      FunctionAnalysisManager &AM) {
+  return KnownBitsCache(F.getParent()->getDataLayout(),
+                        &AM.getResult<AssumptionAnalysis>(F),
+                        &AM.getResult<DominatorTreeAnalysis>(F));
+}
+
+PreservedAnalyses KnownBitsPrinterPass::run(Function &F,
+                                            FunctionAnalysisManager &AM) {
+  KnownBitsCache &KBC = AM.getResult<KnownBitsAnalysis>(F);
+  OS << "Known bits for function '" << F.getName() << "':\n";
+  for (Instruction &I : instructions(F)) {
+    if (!I.getType()->isIntOrIntVectorTy())
+      continue;
+    KnownBits Known = KBC.computeKnownBits(&I);
+    OS << "  ";
+    I.printAsOperand(OS, /*PrintType=*/false);
+    OS << ": Zero=0x" << Known.Zero.toString(16, false)
+       << " One=0x" << Known.One.toString(16, false)
+       << " SignBits=" << KBC.ComputeNumSignBits(&I)
+       << " NonZero=" << KBC.isKnownNonZero(&I) << "\n";
+  }
+  return PreservedAnalyses::all();
+}
@@ -15,6 +15,7 @@
 #include "llvm/Analysis/LazyValueInfo.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AssumptionCache.h"
 #include "llvm/Analysis/ConstantFolding.h"
 #include "llvm/Analysis/InstructionSimplify.h"
@@ -32,9 +33,11 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/PatternMatch.h"
 #include "llvm/IR/ValueHandle.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FormattedStream.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <map>
 #include <stack>
 using namespace llvm;
@@ -46,6 +49,16 @@ using namespace PatternMatch;
 // answer for a given value.
 static const unsigned MaxProcessedPerValue = 500;
 
+static cl::opt<unsigned> LVICacheMaxEntries(
+    "lvi-cache-max-entries", cl::Hidden, cl::init(0),
+    cl::desc("Maximum number of lattice values cached by LazyValueInfo before "
+             "the least recently used ones are evicted (0 = no limit)"));
+
+STATISTIC(NumCacheEvictions, "Number of times the cache went over budget");
+STATISTIC(NumValuesEvicted, "Number of values evicted from the cache");
+STATISTIC(NumOverDefinedEvicted,
+          "Number of over-defined markers evicted from the cache");
+
 char LazyValueInfoWrapperPass::ID = 0;
 INITIALIZE_PASS_BEGIN(LazyValueInfoWrapperPass, "lazy-value-info",
                 "Lazy Value Information Analysis", false, true)
@@ -383,6 +396,9 @@ namespace {
       ValueCacheEntryTy(Value *V, LazyValueInfoCache *P) : Handle(V, P) {}
       LVIValueHandle Handle;
       SmallDenseMap<PoisoningVH<BasicBlock>, LVILatticeVal, 4> BlockVals;
+      /// When the entry was last used, for evicting the least recently used
+      /// values when the cache is over budget.
+      mutable uint64_t LastUsed = 0;
     };
 
     /// This tracks, on a per-block basis, the set of values that are
@@ -398,6 +414,19 @@ namespace {
     DenseMap<Value *, std::unique_ptr<ValueCacheEntryTy>> ValueCache;
     OverDefinedCacheTy OverDefinedCache;
 
+    /// The number of lattice values and over-defined markers in the cache.
+    unsigned NumEntries = 0;
+
+    /// Incremented whenever an entry of ValueCache is used.
+    mutable uint64_t UseCounter = 0;
+
+    void touch(const ValueCacheEntryTy &Entry) const {
+      Entry.LastUsed = ++UseCounter;
+    }
+
+    /// Evicts the least recently used values, and then the over-defined
+    /// markers, until the cache is down to three quarters of \p MaxEntries.
+    void evict(unsigned MaxEntries);
 
   public:
     void insertResult(Value *Val, BasicBlock *BB, const LVILatticeVal &Result) {
@@ -405,16 +434,22 @@ namespace {
 
       // Insert over-defined values into their own cache to reduce memory
       // overhead.
-      if (Result.isOverdefined())
-        OverDefinedCache[BB].insert(Val);
-      else {
+      if (Result.isOverdefined()) {
+        if (OverDefinedCache[BB].insert(Val).second)
+          ++NumEntries;
+      } else {
         auto It = ValueCache.find_as(Val);
         if (It == ValueCache.end()) {
           ValueCache[Val] = make_unique<ValueCacheEntryTy>(Val, this);
           It = ValueCache.find_as(Val);
           assert(It != ValueCache.end() && "Val was just added to the map!");
         }
-        It->second->BlockVals[BB] = Result;
+        touch(*It->second);
+        auto Inserted = It->second->BlockVals.insert({BB, Result});
+        if (Inserted.second)
+          ++NumEntries;
+        else
+          Inserted.first->second = Result;
       }
     }
 
@@ -448,6 +483,7 @@ namespace {
       auto BBI = I->second->BlockVals.find(BB);
       if (BBI == I->second->BlockVals.end())
         return LVILatticeVal();
+      touch(*I->second);
       return BBI->second;
     }
 
@@ -456,6 +492,15 @@ namespace {
       SeenBlocks.clear();
       ValueCache.clear();
       OverDefinedCache.clear();
+      NumEntries = 0;
+    }
+
+    /// Evicts entries if the cache holds more than -lvi-cache-max-entries.
+    /// Must only be called between queries, as the solver relies on the
+    /// entries it computed during a query staying around.
+    void enforceBudget() {
+      if (LVICacheMaxEntries && NumEntries > LVICacheMaxEntries)
+        evict(LVICacheMaxEntries);
     }
 
     /// Inform the cache that a given value has been deleted.
@@ -480,12 +525,17 @@ void LazyValueInfoCache::eraseValue(Value *V) {
     // ourselves.
     auto Iter = I++;
     SmallPtrSetImpl<Value *> &ValueSet = Iter->second;
-    ValueSet.erase(V);
+    if (ValueSet.erase(V))
+      --NumEntries;
     if (ValueSet.empty())
       OverDefinedCache.erase(Iter);
   }
 
-  ValueCache.erase(V);
+  auto It = ValueCache.find(V);
+  if (It != ValueCache.end()) {
+    NumEntries -= It->second->BlockVals.size();
+    ValueCache.erase(It);
+  }
 }
 
 void LVIValueHandle::deleted() {
@@ -502,11 +552,42 @@ void LazyValueInfoCache::eraseBlock(BasicBlock *BB) {
   SeenBlocks.erase(I);
 
   auto ODI = OverDefinedCache.find(BB);
-  if (ODI != OverDefinedCache.end())
+  if (ODI != OverDefinedCache.end()) {
+    NumEntries -= ODI->second.size();
     OverDefinedCache.erase(ODI);
+  }
+
+  for (auto &I : ValueCache)
+    NumEntries -= I.second->BlockVals.erase(BB);
+}
+
+void LazyValueInfoCache::evict(unsigned MaxEntries) {
+  ++NumCacheEvictions;
+  unsigned Target = MaxEntries - MaxEntries / 4;
 
+  // The use counter orders the values deterministically.
+  std::vector<std::pair<uint64_t, Value *>> ByLastUse;
+  ByLastUse.reserve(ValueCache.size());
   for (auto &I : ValueCache)
-    I.second->BlockVals.erase(BB);
+    ByLastUse.push_back({I.second->LastUsed, I.first});
+  std::sort(ByLastUse.begin(), ByLastUse.end());
+
+  for (auto &Use : ByLastUse) {
+    if (NumEntries <= Target)
+      return;
+    auto It = ValueCache.find(Use.second);
+    NumEntries -= It->second->BlockVals.size();
+    ValueCache.erase(It);
+    ++NumValuesEvicted;
+  }
+
+  // Over-defined markers are cheap, and only go if they alone are over
+  // budget.
+  if (NumEntries <= Target)
+    return;
+  NumOverDefinedEvicted += NumEntries;
+  OverDefinedCache.clear();
+  NumEntries = 0;
 }
 
 void LazyValueInfoCache::threadEdgeImpl(BasicBlock *OldSucc,
@@ -550,6 +631,7 @@ void LazyValueInfoCache::threadEdgeImpl(BasicBlock *OldSucc,
     for (Value *V : ValsToClear) {
       if (!ValueSet.erase(V))
         continue;
+      --NumEntries;
 
       // If we removed anything, then we potentially need to update
       // blocks successors too.
@@ -1590,6 +1672,7 @@ LVILatticeVal LazyValueInfoImpl::getValueInBlock(Value *V, BasicBlock *BB,
         << BB->getName() << "'\n");
 
   assert(BlockValueStack.empty() && BlockValueSet.empty());
+  TheCache.enforceBudget();
   if (!hasBlockValue(V, BB)) {
     pushBlockValue(std::make_pair(BB, V));
     solve();
@@ -1623,6 +1706,7 @@ getValueOnEdge(Value *V, BasicBlock *FromBB, BasicBlock *ToBB,
   DEBUG(dbgs() << "LVI Getting edge value " << *V << " from '"
         << FromBB->getName() << "' to '" << ToBB->getName() << "'\n");
 
+  TheCache.enforceBudget();
   LVILatticeVal Result;
   if (!getEdgeValue(V, FromBB, ToBB, Result, CxtI)) {
     solve();
@@ -1707,6 +1707,11 @@ void LoopAccessInfo::analyzeLoop(AliasAnalysis *AA, LoopInfo *LI,
   PtrRtChecking->Pointers.clear();
   PtrRtChecking->Need = false;
 
+  // The alias set tracker and the run-time check grouping below query every
+  // pair of accesses, mostly GEPs off a few common bases; the IR does not
+  // change while doing so.
+  BatchAAScope BatchAA(*AA);
+
   const bool IsAnnotatedParallel = TheLoop->isAnnotatedParallel();
 
   // For each block.
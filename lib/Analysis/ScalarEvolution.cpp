@@ -143,6 +143,16 @@ STATISTIC(NumTripCountsNotComputed,
           "Number of loops without predictable loop counts");
 STATISTIC(NumBruteForceTripCountsComputed,
           "Number of loops with trip counts computed by force");
+STATISTIC(NumSCEVCacheHits, "Number of getSCEV queries answered by the cache");
+STATISTIC(NumSCEVCacheMisses,
+          "Number of getSCEV queries which created an expression");
+STATISTIC(NumBECountCacheHits,
+          "Number of backedge-taken count queries answered by the cache");
+STATISTIC(NumBECountCacheMisses,
+          "Number of backedge-taken count queries which computed the count");
+STATISTIC(NumRangeCacheHits, "Number of range queries answered by the cache");
+STATISTIC(NumRangeCacheMisses,
+          "Number of range queries which computed the range");
 
 static cl::opt<unsigned>
 MaxBruteForceIterations("scalar-evolution-max-iterations", cl::ReallyHidden,
@@ -3739,7 +3749,10 @@ const SCEV *ScalarEvolution::getSCEV(Value *V) {
   assert(isSCEVable(V->getType()) && "Value is not SCEVable!");
 
   const SCEV *S = getExistingSCEV(V);
-  if (S == nullptr) {
+  if (S) {
+    ++NumSCEVCacheHits;
+  } else {
+    ++NumSCEVCacheMisses;
     S = createSCEV(V);
     // During PHI resolution, it is possible to create two SCEVs for the same
     // V, so it is needed to double check whether V->S is inserted into
@@ -5206,8 +5219,11 @@ ScalarEvolution::getRangeRef(const SCEV *S,
 
   // See if we've computed this range already.
   DenseMap<const SCEV *, ConstantRange>::iterator I = Cache.find(S);
-  if (I != Cache.end())
+  if (I != Cache.end()) {
+    ++NumRangeCacheHits;
     return I->second;
+  }
+  ++NumRangeCacheMisses;
 
   if (const SCEVConstant *C = dyn_cast<SCEVConstant>(S))
     return setRange(C, SignHint, ConstantRange(C->getAPInt()));
@@ -6284,8 +6300,11 @@ ScalarEvolution::getBackedgeTakenInfo(const Loop *L) {
   // backedge-taken count, which could result in infinite recursion.
   std::pair<DenseMap<const Loop *, BackedgeTakenInfo>::iterator, bool> Pair =
       BackedgeTakenCounts.insert({L, BackedgeTakenInfo()});
-  if (!Pair.second)
+  if (!Pair.second) {
+    ++NumBECountCacheHits;
     return Pair.first->second;
+  }
+  ++NumBECountCacheMisses;
 
   // computeBackedgeTakenCount may allocate memory for its result. Inserting it
   // into the BackedgeTakenCounts map transfers ownership. Otherwise, the result
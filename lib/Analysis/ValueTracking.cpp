@@ -27,6 +27,7 @@
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/AssumptionCache.h"
 #include "llvm/Analysis/InstructionSimplify.h"
+#include "llvm/Analysis/KnownBitsCache.h"
 #include "llvm/Analysis/Loads.h"
 #include "llvm/Analysis/LoopInfo.h"
 #include "llvm/Analysis/OptimizationDiagnosticInfo.h"
@@ -126,18 +127,31 @@ struct Query {
 
   unsigned NumExcluded = 0;
 
+  /// Results are memoized here if set. Queries with excluded assumptions may
+  /// be less precise, so their results are not.
+  KnownBitsCache *Cache = nullptr;
+
   Query(const DataLayout &DL, AssumptionCache *AC, const Instruction *CxtI,
-        const DominatorTree *DT, OptimizationRemarkEmitter *ORE = nullptr)
-      : DL(DL), AC(AC), CxtI(CxtI), DT(DT), ORE(ORE) {}
+        const DominatorTree *DT, OptimizationRemarkEmitter *ORE = nullptr,
+        KnownBitsCache *Cache = nullptr)
+      : DL(DL), AC(AC), CxtI(CxtI), DT(DT), ORE(ORE), Cache(Cache) {}
 
   Query(const Query &Q, const Value *NewExcl)
       : DL(Q.DL), AC(Q.AC), CxtI(Q.CxtI), DT(Q.DT), ORE(Q.ORE),
-        NumExcluded(Q.NumExcluded) {
+        NumExcluded(Q.NumExcluded), Cache(Q.Cache) {
     Excluded = Q.Excluded;
     Excluded[NumExcluded++] = NewExcl;
     assert(NumExcluded <= Excluded.size());
   }
 
+  /// Returns the cache to use for a query about \p V at \p Depth, if any.
+  /// Constants are cheap to look at again.
+  KnownBitsCache *getCache(const Value *V, unsigned Depth) const {
+    if (!Cache || NumExcluded != 0 || Depth >= MaxDepth || isa<Constant>(V))
+      return nullptr;
+    return Cache;
+  }
+
   bool isExcluded(const Value *Value) const {
     if (NumExcluded == 0)
       return false;
@@ -295,6 +309,23 @@ unsigned llvm::ComputeNumSignBits(const Value *V, const DataLayout &DL,
   return ::ComputeNumSignBits(V, Depth, Query(DL, AC, safeCxtI(V, CxtI), DT));
 }
 
+KnownBits KnownBitsCache::computeKnownBits(const Value *V,
+                                           const Instruction *CxtI) {
+  return ::computeKnownBits(
+      V, 0, Query(DL, AC, safeCxtI(V, CxtI), DT, nullptr, this));
+}
+
+unsigned KnownBitsCache::ComputeNumSignBits(const Value *V,
+                                            const Instruction *CxtI) {
+  return ::ComputeNumSignBits(
+      V, 0, Query(DL, AC, safeCxtI(V, CxtI), DT, nullptr, this));
+}
+
+bool KnownBitsCache::isKnownNonZero(const Value *V, const Instruction *CxtI) {
+  return ::isKnownNonZero(
+      V, 0, Query(DL, AC, safeCxtI(V, CxtI), DT, nullptr, this));
+}
+
 static void computeKnownBitsAddSub(bool Add, const Value *Op0, const Value *Op1,
                                    bool NSW,
                                    KnownBits &KnownOut, KnownBits &Known2,
@@ -1561,6 +1592,14 @@ void computeKnownBits(const Value *V, KnownBits &Known, unsigned Depth,
   if (Depth == MaxDepth)
     return;
 
+  KnownBitsCache *Cache = Q.getCache(V, Depth);
+  if (Cache)
+    if (const KnownBits *Cached =
+            Cache->lookupKnownBits(V, Q.CxtI, MaxDepth - Depth)) {
+      Known = *Cached;
+      return;
+    }
+
   // A weak GlobalAlias is totally unknown. A non-weak GlobalAlias has
   // the bits of its aliasee.
   if (const GlobalAlias *GA = dyn_cast<GlobalAlias>(V)) {
@@ -1586,6 +1625,8 @@ void computeKnownBits(const Value *V, KnownBits &Known, unsigned Depth,
   computeKnownBitsFromAssume(V, Known, Depth, Q);
 
   assert((Known.Zero & Known.One) == 0 && "Bits known to be one AND zero?");
+  if (Cache)
+    Cache->insertKnownBits(V, Q.CxtI, MaxDepth - Depth, Known);
 }
 
 /// Return true if the given value is known to have exactly one
@@ -1819,6 +1860,9 @@ static bool rangeMetadataExcludesValue(const MDNode* Ranges, const APInt& Value)
   return true;
 }
 
+static bool isKnownNonZeroImpl(const Value *V, unsigned Depth,
+                               const Query &Q);
+
 /// Return true if the given value is known to be non-zero when defined. For
 /// vectors, return true if every element is known to be non-zero when
 /// defined. For pointers, if the context instruction and dominator tree are
@@ -1826,6 +1870,18 @@ static bool rangeMetadataExcludesValue(const MDNode* Ranges, const APInt& Value)
 /// pointer couldn't possibly be null at the specified instruction.
 /// Supports values with integer or pointer type and vectors of integers.
 bool isKnownNonZero(const Value *V, unsigned Depth, const Query &Q) {
+  KnownBitsCache *Cache = Q.getCache(V, Depth);
+  if (!Cache)
+    return isKnownNonZeroImpl(V, Depth, Q);
+  if (Optional<bool> Cached = Cache->lookupNonZero(V, Q.CxtI, MaxDepth - Depth))
+    return *Cached;
+  bool Result = isKnownNonZeroImpl(V, Depth, Q);
+  Cache->insertNonZero(V, Q.CxtI, MaxDepth - Depth, Result);
+  return Result;
+}
+
+static bool isKnownNonZeroImpl(const Value *V, unsigned Depth,
+                               const Query &Q) {
   if (auto *C = dyn_cast<Constant>(V)) {
     if (C->isNullValue())
       return false;
@@ -2124,8 +2180,15 @@ static unsigned ComputeNumSignBitsImpl(const Value *V, unsigned Depth,
 
 static unsigned ComputeNumSignBits(const Value *V, unsigned Depth,
                                    const Query &Q) {
+  KnownBitsCache *Cache = Q.getCache(V, Depth);
+  if (Cache)
+    if (unsigned Cached =
+            Cache->lookupNumSignBits(V, Q.CxtI, MaxDepth - Depth))
+      return Cached;
   unsigned Result = ComputeNumSignBitsImpl(V, Depth, Q);
   assert(Result > 0 && "At least one sign bit needs to be present!");
+  if (Cache)
+    Cache->insertNumSignBits(V, Q.CxtI, MaxDepth - Depth, Result);
   return Result;
 }
 
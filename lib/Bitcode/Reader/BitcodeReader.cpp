@@ -70,6 +70,7 @@
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -92,6 +93,11 @@ static cl::opt<bool> PrintSummaryGUIDs(
     cl::desc(
         "Print the global id for each value when reading the module summary"));
 
+static cl::opt<unsigned> BitcodeReaderThreads(
+    "bitcode-reader-threads", cl::init(1), cl::Hidden,
+    cl::desc("Number of threads decoding function bodies ahead of their "
+             "construction when a whole module is materialized"));
+
 namespace {
 
 enum {
@@ -437,6 +443,97 @@ BitcodeReaderBase::readNameFromStrtab(ArrayRef<uint64_t> Record) {
 
 namespace {
 
+/// The records of a function block, decoded ahead of time from a private
+/// cursor so that several function bodies can be decoded concurrently while
+/// the IR for another is being constructed.
+///
+/// Only the records of the block itself are staged. Of its sub-blocks
+/// (constants, metadata, symbol tables, use-lists) just the position is
+/// remembered; advance() moves the reader's stream there so that they are
+/// parsed from the stream as usual.
+class StagedFunctionBlock {
+  struct Item {
+    BitstreamEntry Entry;
+    /// The code of a record.
+    unsigned Code;
+    /// The position of the contents of a sub-block.
+    uint64_t SubBlockBit;
+    /// The operands of a record, as a range of Ops.
+    size_t OpsBegin, OpsEnd;
+  };
+
+  std::vector<Item> Items;
+  std::vector<uint64_t> Ops;
+  size_t Next = 0;
+  bool Valid = false;
+
+public:
+  /// Decodes the function block whose contents start at \p Bit, the position
+  /// recorded in DeferredFunctionInfo. \p Cursor must not be shared with
+  /// another thread.
+  void decode(BitstreamCursor Cursor, uint64_t Bit);
+
+  /// Whether the block was decoded successfully. If not, the body must be
+  /// parsed from the stream, which reports the error.
+  bool isValid() const { return Valid; }
+
+  /// Returns the next entry of the block, and positions \p Stream at the
+  /// contents of the sub-block if it is one.
+  BitstreamEntry advance(BitstreamCursor &Stream) {
+    const Item &I = Items[Next++];
+    if (I.Entry.Kind == BitstreamEntry::SubBlock)
+      Stream.JumpToBit(I.SubBlockBit);
+    return I.Entry;
+  }
+
+  /// Reads the record returned by the last call to advance().
+  unsigned readRecord(SmallVectorImpl<uint64_t> &Vals) const {
+    const Item &I = Items[Next - 1];
+    Vals.append(Ops.begin() + I.OpsBegin, Ops.begin() + I.OpsEnd);
+    return I.Code;
+  }
+};
+
+} // end anonymous namespace
+
+void StagedFunctionBlock::decode(BitstreamCursor Cursor, uint64_t Bit) {
+  Cursor.JumpToBit(Bit);
+  if (Cursor.EnterSubBlock(bitc::FUNCTION_BLOCK_ID))
+    return;
+
+  SmallVector<uint64_t, 64> Record;
+  while (true) {
+    Item I;
+    I.Entry = Cursor.advance();
+    I.Code = 0;
+    I.SubBlockBit = 0;
+    I.OpsBegin = I.OpsEnd = Ops.size();
+    switch (I.Entry.Kind) {
+    case BitstreamEntry::Error:
+      return;
+    case BitstreamEntry::EndBlock:
+      Items.push_back(I);
+      Valid = true;
+      return;
+    case BitstreamEntry::SubBlock:
+      I.SubBlockBit = Cursor.GetCurrentBitNo();
+      Items.push_back(I);
+      if (Cursor.SkipBlock())
+        return;
+      break;
+    case BitstreamEntry::Record:
+      Record.clear();
+      I.Code = Cursor.readRecord(I.Entry.ID, Record);
+      Ops.insert(Ops.end(), Record.begin(), Record.end());
+      I.OpsEnd = Ops.size();
+      Items.push_back(I);
+      break;
+    }
+  }
+}
+
+namespace {
+
 class BitcodeReader : public BitcodeReaderBase, public GVMaterializer {
   LLVMContext &Context;
   Module *TheModule = nullptr;
@@ -493,6 +590,10 @@ class BitcodeReader : public BitcodeReaderBase, public GVMaterializer {
   /// where to find deferred function body in the stream.
   DenseMap<Function*, uint64_t> DeferredFunctionInfo;
 
+  /// Function bodies which have been decoded ahead of their parsing by
+  /// materializeFunctionsConcurrently().
+  DenseMap<Function *, StagedFunctionBlock> StagedFunctionBlocks;
+
   /// When Metadata block is initially scanned when parsing the module, we may
   /// choose to defer parsing of the metadata. This vector contains info about
   /// which Metadata blocks are deferred.
@@ -671,6 +772,7 @@ private:
   Error rememberAndSkipMetadata();
   Error typeCheckLoadStoreInst(Type *ValType, Type *PtrType);
   Error parseFunctionBody(Function *F);
+  Error materializeFunctionsConcurrently(unsigned Threads);
   Error globalCleanup();
   Error resolveGlobalAndIndirectSymbolInits();
   Error parseUseLists();
@@ -3310,7 +3412,15 @@ Error BitcodeReader::typeCheckLoadStoreInst(Type *ValType, Type *PtrType) {
 
 /// Lazily parse the specified function body block.
 Error BitcodeReader::parseFunctionBody(Function *F) {
-  if (Stream.EnterSubBlock(bitc::FUNCTION_BLOCK_ID))
+  // Read the records from the staged block if the body has been decoded ahead
+  // of time, and from the stream otherwise.
+  StagedFunctionBlock Staged;
+  auto StagedIt = StagedFunctionBlocks.find(F);
+  if (StagedIt != StagedFunctionBlocks.end()) {
+    Staged = std::move(StagedIt->second);
+    StagedFunctionBlocks.erase(StagedIt);
+  }
+  if (!Staged.isValid() && Stream.EnterSubBlock(bitc::FUNCTION_BLOCK_ID))
     return error("Invalid record");
 
   // Unexpected unresolved metadata when parsing function.
@@ -3345,7 +3455,8 @@ Error BitcodeReader::parseFunctionBody(Function *F) {
   SmallVector<uint64_t, 64> Record;
 
   while (true) {
-    BitstreamEntry Entry = Stream.advance();
+    BitstreamEntry Entry =
+        Staged.isValid() ? Staged.advance(Stream) : Stream.advance();
 
     switch (Entry.Kind) {
     case BitstreamEntry::Error:
@@ -3393,7 +3504,8 @@ Error BitcodeReader::parseFunctionBody(Function *F) {
     // Read a record.
     Record.clear();
     Instruction *I = nullptr;
-    unsigned BitCode = Stream.readRecord(Entry.ID, Record);
+    unsigned BitCode = Staged.isValid() ? Staged.readRecord(Record)
+                                        : Stream.readRecord(Entry.ID, Record);
     switch (BitCode) {
     default: // Default behavior: reject
       return error("Invalid value");
@@ -4703,9 +4815,14 @@ Error BitcodeReader::materializeModule() {
 
   // Iterate over the module, deserializing any functions that are still on
   // disk.
-  for (Function &F : *TheModule) {
-    if (Error Err = materialize(&F))
+  if (BitcodeReaderThreads > 1) {
+    if (Error Err = materializeFunctionsConcurrently(BitcodeReaderThreads))
       return Err;
+  } else {
+    for (Function &F : *TheModule) {
+      if (Error Err = materialize(&F))
+        return Err;
+    }
   }
   // At this point, if there are any function bodies, parse the rest of
   // the bits in the module past the last function block we have recorded
@@ -4748,6 +4865,74 @@ Error BitcodeReader::materializeModule() {
   return Error::success();
 }
 
+/// Materializes all the functions of the module, in module order, while
+/// \p Threads threads decode the bodies that come next.
+///
+/// The construction of the IR has to happen on this thread as the context is
+/// not thread safe, but the decoding of the bitstream does not touch the
+/// context. The functions are processed in windows: the bodies of one window
+/// are decoded concurrently while those of the previous one are constructed.
+Error BitcodeReader::materializeFunctionsConcurrently(unsigned Threads) {
+  std::vector<Function *> Worklist;
+  for (Function &F : *TheModule)
+    if (F.isMaterializable())
+      Worklist.push_back(&F);
+
+  struct Window {
+    size_t Begin, End;
+    std::vector<StagedFunctionBlock> Blocks;
+    std::vector<std::shared_future<void>> Tasks;
+  };
+  const size_t WindowSize = 8 * Threads;
+  ThreadPool Pool(Threads);
+
+  auto StartWindow = [&](size_t Begin) {
+    auto W = llvm::make_unique<Window>();
+    W->Begin = Begin;
+    W->End = std::min(Begin + WindowSize, Worklist.size());
+    W->Blocks.resize(W->End - W->Begin);
+    for (size_t I = W->Begin; I != W->End; ++I) {
+      // Bodies whose position is not known yet are found and parsed by
+      // materialize() as usual.
+      uint64_t Bit = DeferredFunctionInfo.lookup(Worklist[I]);
+      if (!Bit)
+        continue;
+      StagedFunctionBlock *Block = &W->Blocks[I - W->Begin];
+      BitstreamCursor Cursor(Stream.getBitcodeBytes());
+      Cursor.setBlockInfo(&BlockInfo);
+      W->Tasks.push_back(Pool.async(
+          [Block, Cursor, Bit] { Block->decode(Cursor, Bit); }));
+    }
+    return W;
+  };
+
+  std::unique_ptr<Window> Current = StartWindow(0);
+  while (Current->Begin != Current->End) {
+    std::unique_ptr<Window> Next = StartWindow(Current->End);
+    for (auto &Task : Current->Tasks)
+      Task.wait();
+    for (size_t I = Current->Begin; I != Current->End; ++I) {
+      StagedFunctionBlock &Block = Current->Blocks[I - Current->Begin];
+      // Functions forward-referenced from an earlier body through a
+      // blockaddress may have been materialized already.
+      if (Block.isValid() && Worklist[I]->isMaterializable())
+        StagedFunctionBlocks[Worklist[I]] = std::move(Block);
+    }
+    for (size_t I = Current->Begin; I != Current->End; ++I) {
+      if (Error Err = materialize(Worklist[I])) {
+        // The tasks of the next window still refer to it.
+        Pool.wait();
+        StagedFunctionBlocks.clear();
+        return Err;
+      }
+    }
+    Current = std::move(Next);
+  }
+  Pool.wait();
+  StagedFunctionBlocks.clear();
+  return Error::success();
+}
+
 std::vector<StructType *> BitcodeReader::getIdentifiedStructTypes() const {
   return IdentifiedStructTypes;
 }
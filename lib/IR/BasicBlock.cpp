@@ -16,6 +16,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/IRArena.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/LLVMContext.h"
@@ -51,6 +52,23 @@ BasicBlock::BasicBlock(LLVMContext &C, const Twine &Name, Function *NewParent,
   setName(Name);
 }
 
+void *BasicBlock::operator new(size_t Size) {
+  void *Mem = IRArena::allocate(Size);
+  bool IsArenaAllocated = Mem;
+  if (!Mem)
+    Mem = ::operator new(Size);
+  // The Value constructor leaves this bit alone.
+  static_cast<BasicBlock *>(Mem)->IsArenaAllocated = IsArenaAllocated;
+  return Mem;
+}
+
+void BasicBlock::operator delete(void *Ptr) {
+  if (static_cast<BasicBlock *>(Ptr)->IsArenaAllocated)
+    IRArena::deallocate(Ptr);
+  else
+    ::operator delete(Ptr);
+}
+
 void BasicBlock::insertInto(Function *NewParent, BasicBlock *InsertBefore) {
   assert(NewParent && "Expected a parent");
   assert(!Parent && "Already has a parent");
@@ -25,16 +25,19 @@
 #include "llvm/IR/Constant.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/IRArena.h"
 #include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/Instruction.h"
 #include "llvm/IR/OperandTraits.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <mutex>
 #include <utility>
 
 #define DEBUG_TYPE "ir"
@@ -564,6 +567,12 @@ struct ConstantExprKeyType {
   }
 };
 
+/// Locks \p M, the lock of a uniquing table, unless it is null, which is the
+/// case in contexts without concurrent uniquing.
+inline std::unique_lock<sys::Mutex> lockUniquingTable(sys::Mutex *M) {
+  return M ? std::unique_lock<sys::Mutex>(*M) : std::unique_lock<sys::Mutex>();
+}
+
 template <class ConstantClass> class ConstantUniqueMap {
 public:
   using ValType = typename ConstantInfo<ConstantClass>::ValType;
@@ -620,9 +629,14 @@ public:
 
 private:
   MapTy Map;
+  sys::Mutex *Lock = nullptr;
 
 public:
   typename MapTy::iterator begin() { return Map.begin(); }
+
+  /// Makes the map lock \p M while it is used, see
+  /// LLVMContext::enableConcurrentUniquing().
+  void setLock(sys::Mutex *M) { Lock = M; }
   typename MapTy::iterator end() { return Map.end(); }
 
   void freeConstants() {
@@ -632,6 +646,8 @@ public:
 
 private:
   ConstantClass *create(TypeClass *Ty, ValType V, LookupKeyHashed &HashKey) {
+    // Constants are owned by the context, and outlive any IRArena.
+    IRArena::Scope NoArena(nullptr);
     ConstantClass *Result = V.create(Ty);
 
     assert(Result->getType() == Ty && "Type specified is not correct!");
@@ -647,6 +663,7 @@ public:
     /// Hash once, and reuse it for the lookup and the insertion if needed.
     LookupKeyHashed Lookup(MapInfo::getHashValue(Key), Key);
 
+    auto Guard = lockUniquingTable(Lock);
     ConstantClass *Result = nullptr;
 
     auto I = Map.find_as(Lookup);
@@ -661,6 +678,7 @@ public:
 
   /// Remove this constant from the map
   void remove(ConstantClass *CP) {
+    auto Guard = lockUniquingTable(Lock);
     typename MapTy::iterator I = Map.find(CP);
     assert(I != Map.end() && "Constant not found in constant table!");
     assert(*I == CP && "Didn't find correct element?");
@@ -675,6 +693,7 @@ public:
     /// Hash once, and reuse it for the lookup and the insertion if needed.
     LookupKeyHashed Lookup(MapInfo::getHashValue(Key), Key);
 
+    auto Guard = lockUniquingTable(Lock);
     auto I = Map.find_as(Lookup);
     if (I != Map.end())
       return *I;
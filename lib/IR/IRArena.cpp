@@ -0,0 +1,68 @@
+//===- IRArena.cpp - Arena allocation of IR objects -----------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the IRArena class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/IRArena.h"
+#include "llvm/Support/Compiler.h"
+#include <cassert>
+
+using namespace llvm;
+
+static LLVM_THREAD_LOCAL IRArena *CurrentArena = nullptr;
+
+namespace {
+/// Precedes every allocation, so that deallocate() can find the arena and the
+/// size of the object.
+struct alignas(8) AllocationHeader {
+  IRArena *Owner;
+  size_t Size;
+};
+} // end anonymous namespace
+
+IRArena::~IRArena() {
+  assert(getLiveBytes() == 0 &&
+         "IR objects allocated from an arena outlive it");
+}
+
+IRArena::Scope::Scope(IRArena *Arena) : Previous(CurrentArena) {
+  CurrentArena = Arena;
+}
+
+IRArena::Scope::~Scope() { CurrentArena = Previous; }
+
+IRArena *IRArena::getCurrent() { return CurrentArena; }
+
+void *IRArena::allocate(size_t Size) {
+  IRArena *Arena = CurrentArena;
+  if (!Arena)
+    return nullptr;
+  size_t Bytes = sizeof(AllocationHeader) + Size;
+  auto *Header = static_cast<AllocationHeader *>(
+      Arena->Allocator.Allocate(Bytes, alignof(AllocationHeader)));
+  Header->Owner = Arena;
+  Header->Size = Bytes;
+  Arena->BytesAllocated += Bytes;
+  return Header + 1;
+}
+
+void IRArena::deallocate(void *Ptr) {
+  auto *Header = static_cast<AllocationHeader *>(Ptr) - 1;
+  Header->Owner->BytesFreed += Header->Size;
+}
+
+bool IRArena::reset() {
+  if (getLiveBytes() != 0)
+    return false;
+  Allocator.Reset();
+  BytesAllocated = BytesFreed = 0;
+  return true;
+}
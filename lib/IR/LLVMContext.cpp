@@ -314,6 +314,25 @@ void LLVMContext::enableDebugTypeODRUniquing() {
 
 void LLVMContext::disableDebugTypeODRUniquing() { pImpl->DITypeMap.reset(); }
 
+bool LLVMContext::isConcurrentUniquingEnabled() const {
+  return !!pImpl->Locks;
+}
+
+void LLVMContext::enableConcurrentUniquing() {
+  if (pImpl->Locks)
+    return;
+
+  assert(pImpl->IntConstants[0].empty() && pImpl->FPConstants[0].empty() &&
+         "Concurrent uniquing must be enabled before creating constants");
+  pImpl->Locks = llvm::make_unique<LLVMContextImpl::UniquingLocks>();
+  sys::Mutex *ConstantsLock = &pImpl->Locks->Constants;
+  pImpl->ArrayConstants.setLock(ConstantsLock);
+  pImpl->StructConstants.setLock(ConstantsLock);
+  pImpl->VectorConstants.setLock(ConstantsLock);
+  pImpl->ExprConstants.setLock(ConstantsLock);
+  pImpl->InlineAsms.setLock(ConstantsLock);
+}
+
 void LLVMContext::setDiscardValueNames(bool Discard) {
   pImpl->DiscardValueNames = Discard;
 }
@@ -89,8 +89,10 @@ LLVMContextImpl::~LLVMContextImpl() {
   CAZConstants.clear();
   CPNConstants.clear();
   UVConstants.clear();
-  IntConstants.clear();
-  FPConstants.clear();
+  for (IntMapTy &Shard : IntConstants)
+    Shard.clear();
+  for (FPMapTy &Shard : FPConstants)
+    Shard.clear();
 
   for (auto &CDSConstant : CDSConstants)
     delete CDSConstant.second;
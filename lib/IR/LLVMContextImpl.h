@@ -41,6 +41,7 @@
 #include "llvm/IR/TrackingMDRef.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/YAMLTraits.h"
 #include <algorithm>
 #include <cassert>
@@ -1177,13 +1178,49 @@ public:
   LLVMContext::YieldCallbackTy YieldCallback = nullptr;
   void *YieldOpaqueHandle = nullptr;
 
+  /// The number of shards IntConstants and FPConstants are split into, so
+  /// that threads creating different constants rarely wait for each other.
+  /// Without concurrent uniquing, only the first shard is used.
+  static const unsigned NumUniquingShards = 16;
+
+  /// The locks of the uniquing tables, once concurrent uniquing is enabled.
+  struct UniquingLocks {
+    sys::Mutex IntConstants[NumUniquingShards];
+    sys::Mutex FPConstants[NumUniquingShards];
+    /// Guards the other constant tables. Creating a constant with operands
+    /// adds to the use lists of the operands, so this is a single lock.
+    sys::Mutex Constants;
+    /// Guards the type tables and TypeAllocator.
+    sys::Mutex Types;
+  };
+  std::unique_ptr<UniquingLocks> Locks;
+
+  unsigned getIntConstantsShard(const APInt &V) const {
+    if (!Locks)
+      return 0;
+    return DenseMapAPIntKeyInfo::getHashValue(V) % NumUniquingShards;
+  }
+  unsigned getFPConstantsShard(const APFloat &V) const {
+    if (!Locks)
+      return 0;
+    return DenseMapAPFloatKeyInfo::getHashValue(V) % NumUniquingShards;
+  }
+  sys::Mutex *getIntConstantsLock(unsigned Shard) {
+    return Locks ? &Locks->IntConstants[Shard] : nullptr;
+  }
+  sys::Mutex *getFPConstantsLock(unsigned Shard) {
+    return Locks ? &Locks->FPConstants[Shard] : nullptr;
+  }
+  sys::Mutex *getConstantsLock() { return Locks ? &Locks->Constants : nullptr; }
+  sys::Mutex *getTypesLock() { return Locks ? &Locks->Types : nullptr; }
+
   using IntMapTy =
       DenseMap<APInt, std::unique_ptr<ConstantInt>, DenseMapAPIntKeyInfo>;
-  IntMapTy IntConstants;
+  IntMapTy IntConstants[NumUniquingShards];
 
   using FPMapTy =
       DenseMap<APFloat, std::unique_ptr<ConstantFP>, DenseMapAPFloatKeyInfo>;
-  FPMapTy FPConstants;
+  FPMapTy FPConstants[NumUniquingShards];
 
   FoldingSet<AttributeImpl> AttrsSet;
   FoldingSet<AttributeListImpl> AttrsLists;
@@ -0,0 +1,185 @@
+//===- llvm/IR/PassProfiler.cpp - Per-function pass profiling -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the recording of per (pass, function) execution
+// profiles for both pass managers.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/PassProfiler.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+static cl::opt<std::string> PassProfileOutput(
+    "pass-profile-output", cl::value_desc("filename"),
+    cl::desc("Record wall time, instruction count and memory usage of every "
+             "function pass run on every function, and write them to the "
+             "given file"));
+
+static cl::opt<PassProfiler::OutputFormat> PassProfileFormat(
+    "pass-profile-format", cl::desc("Format of the -pass-profile-output file"),
+    cl::init(PassProfiler::OutputFormat::JSON),
+    cl::values(clEnumValN(PassProfiler::OutputFormat::JSON, "json",
+                          "A JSON array of records (default)"),
+               clEnumValN(PassProfiler::OutputFormat::ChromeTrace,
+                          "chrome-trace",
+                          "The Chrome trace event format, loadable in "
+                          "chrome://tracing")));
+
+static bool PassProfilerForceEnabled = false;
+
+namespace {
+struct CreatePassProfiler {
+  static void *call() {
+    return new PassProfiler(PassProfileOutput, PassProfileFormat);
+  }
+};
+} // end anonymous namespace
+
+static ManagedStatic<PassProfiler, CreatePassProfiler> ThePassProfiler;
+
+PassProfiler::PassProfiler(StringRef OutputFilename, OutputFormat Format)
+    : OutputFilename(OutputFilename), Format(Format),
+      Epoch(std::chrono::steady_clock::now()) {}
+
+PassProfiler::~PassProfiler() {
+  if (OutputFilename.empty())
+    return;
+  std::error_code EC;
+  raw_fd_ostream OS(OutputFilename, EC, sys::fs::F_Text);
+  if (EC) {
+    errs() << "Could not open pass profile file '" << OutputFilename
+           << "': " << EC.message() << "\n";
+    return;
+  }
+  print(OS);
+}
+
+PassProfiler *PassProfiler::get() {
+  if (PassProfileOutput.empty() && !PassProfilerForceEnabled)
+    return nullptr;
+  return &*ThePassProfiler;
+}
+
+void PassProfiler::enable() { PassProfilerForceEnabled = true; }
+
+uint64_t PassProfiler::getElapsedMicros() const {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - Epoch)
+      .count();
+}
+
+void PassProfiler::addRecord(Record R) {
+  sys::SmartScopedLock<true> Lock(RecordsMutex);
+  Records.push_back(std::move(R));
+}
+
+std::vector<PassProfiler::Record> PassProfiler::takeRecords() {
+  sys::SmartScopedLock<true> Lock(RecordsMutex);
+  std::vector<Record> Result;
+  Result.swap(Records);
+  return Result;
+}
+
+/// Prints \p Str as a JSON string literal.
+static void printJSONString(raw_ostream &OS, StringRef Str) {
+  OS << '"';
+  for (unsigned char C : Str) {
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << "\\u00" << hexdigit(C >> 4, true) << hexdigit(C & 0xF, true);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+static void printRecordFields(raw_ostream &OS,
+                              const PassProfiler::Record &R) {
+  OS << "\"instructions_before\": " << R.InstructionsBefore
+     << ", \"instructions_after\": " << R.InstructionsAfter
+     << ", \"malloc_before\": " << R.MallocBefore
+     << ", \"malloc_after\": " << R.MallocAfter;
+}
+
+void PassProfiler::print(raw_ostream &OS) const {
+  sys::SmartScopedLock<true> Lock(RecordsMutex);
+  bool Chrome = Format == OutputFormat::ChromeTrace;
+  OS << (Chrome ? "{\"traceEvents\": [" : "[");
+  for (size_t I = 0, E = Records.size(); I != E; ++I) {
+    const Record &R = Records[I];
+    OS << (I ? ",\n  " : "\n  ");
+    if (Chrome) {
+      OS << "{\"name\": ";
+      printJSONString(OS, R.PassName);
+      OS << ", \"cat\": \"pass\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+         << R.ThreadID << ", \"ts\": " << R.StartMicros
+         << ", \"dur\": " << R.WallMicros
+         << ", \"args\": {\"function\": ";
+      printJSONString(OS, R.FunctionName);
+      OS << ", ";
+      printRecordFields(OS, R);
+      OS << "}}";
+      continue;
+    }
+    OS << "{\"pass\": ";
+    printJSONString(OS, R.PassName);
+    OS << ", \"function\": ";
+    printJSONString(OS, R.FunctionName);
+    OS << ", \"start_us\": " << R.StartMicros
+       << ", \"wall_us\": " << R.WallMicros << ", ";
+    printRecordFields(OS, R);
+    OS << "}";
+  }
+  OS << (Chrome ? "\n]}\n" : "\n]\n");
+}
+
+static uint64_t countInstructions(const Function &F) {
+  uint64_t Count = 0;
+  for (const BasicBlock &BB : F)
+    Count += BB.size();
+  return Count;
+}
+
+PassProfileRegion::PassProfileRegion(StringRef PassName, Function &F) {
+  Profiler = PassProfiler::get();
+  if (!Profiler)
+    return;
+  this->F = &F;
+  this->PassName = PassName;
+  InstructionsBefore = countInstructions(F);
+  MallocBefore = sys::Process::GetMallocUsage();
+  StartMicros = Profiler->getElapsedMicros();
+}
+
+PassProfileRegion::~PassProfileRegion() {
+  if (!Profiler)
+    return;
+  uint64_t EndMicros = Profiler->getElapsedMicros();
+  PassProfiler::Record R;
+  R.PassName = PassName;
+  R.FunctionName = F->getName();
+  R.StartMicros = StartMicros;
+  R.WallMicros = EndMicros - StartMicros;
+  R.InstructionsBefore = InstructionsBefore;
+  R.InstructionsAfter = countInstructions(*F);
+  R.MallocBefore = MallocBefore;
+  R.MallocAfter = sys::Process::GetMallocUsage();
+  R.ThreadID = get_threadid();
+  Profiler->addRecord(std::move(R));
+}
@@ -10,6 +10,7 @@
 #include "llvm/IR/User.h"
 #include "llvm/IR/Constant.h"
 #include "llvm/IR/GlobalValue.h"
+#include "llvm/IR/IRArena.h"
 #include "llvm/IR/Operator.h"
 
 namespace llvm {
@@ -54,7 +55,7 @@ void User::allocHungoffUses(unsigned N, bool IsPhi) {
   Use *Begin = static_cast<Use*>(::operator new(size));
   Use *End = Begin + N;
   (void) new(End) Use::UserRef(const_cast<User*>(this), 1);
-  setOperandList(Use::initTags(Begin, End));
+  setOperandList(Use::initTags(Begin, End, this));
 }
 
 void User::growHungoffUses(unsigned NewNumUses, bool IsPhi) {
@@ -122,14 +123,19 @@ void *User::allocateFixedOperandUser(size_t Size, unsigned Us,
   assert(DescBytesToAllocate % sizeof(void *) == 0 &&
          "We need this to satisfy alignment constraints for Uses");
 
-  uint8_t *Storage = static_cast<uint8_t *>(
-      ::operator new(Size + sizeof(Use) * Us + DescBytesToAllocate));
+  size_t Bytes = Size + sizeof(Use) * Us + DescBytesToAllocate;
+  void *Mem = IRArena::allocate(Bytes);
+  bool IsArenaAllocated = Mem;
+  if (!Mem)
+    Mem = ::operator new(Bytes);
+  uint8_t *Storage = static_cast<uint8_t *>(Mem);
   Use *Start = reinterpret_cast<Use *>(Storage + DescBytesToAllocate);
   Use *End = Start + Us;
   User *Obj = reinterpret_cast<User*>(End);
   Obj->NumUserOperands = Us;
   Obj->HasHungOffUses = false;
   Obj->HasDescriptor = DescBytes != 0;
+  Obj->IsArenaAllocated = IsArenaAllocated;
   Use::initTags(Start, End);
 
   if (DescBytes != 0) {
@@ -150,12 +156,17 @@ void *User::operator new(size_t Size, unsigned Us, unsigned DescBytes) {
 
 void *User::operator new(size_t Size) {
   // Allocate space for a single Use*
-  void *Storage = ::operator new(Size + sizeof(Use *));
+  size_t Bytes = Size + sizeof(Use *);
+  void *Storage = IRArena::allocate(Bytes);
+  bool IsArenaAllocated = Storage;
+  if (!Storage)
+    Storage = ::operator new(Bytes);
   Use **HungOffOperandList = static_cast<Use **>(Storage);
   User *Obj = reinterpret_cast<User *>(HungOffOperandList + 1);
   Obj->NumUserOperands = 0;
   Obj->HasHungOffUses = true;
   Obj->HasDescriptor = false;
+  Obj->IsArenaAllocated = IsArenaAllocated;
   *HungOffOperandList = nullptr;
   return Obj;
 }
@@ -164,6 +175,13 @@ void *User::operator new(size_t Size) {
 //                         User operator delete Implementation
 //===----------------------------------------------------------------------===//
 
+static void freeUserStorage(void *Storage, bool IsArenaAllocated) {
+  if (IsArenaAllocated)
+    IRArena::deallocate(Storage);
+  else
+    ::operator delete(Storage);
+}
+
 void User::operator delete(void *Usr) {
   // Hung off uses use a single Use* before the User, while other subclasses
   // use a Use[] allocated prior to the user.
@@ -175,19 +193,19 @@ void User::operator delete(void *Usr) {
     // drop the hung off uses.
     Use::zap(*HungOffOperandList, *HungOffOperandList + Obj->NumUserOperands,
              /* Delete */ true);
-    ::operator delete(HungOffOperandList);
+    freeUserStorage(HungOffOperandList, Obj->IsArenaAllocated);
   } else if (Obj->HasDescriptor) {
     Use *UseBegin = static_cast<Use *>(Usr) - Obj->NumUserOperands;
     Use::zap(UseBegin, UseBegin + Obj->NumUserOperands, /* Delete */ false);
 
     auto *DI = reinterpret_cast<DescriptorInfo *>(UseBegin) - 1;
     uint8_t *Storage = reinterpret_cast<uint8_t *>(DI) - DI->SizeInBytes;
-    ::operator delete(Storage);
+    freeUserStorage(Storage, Obj->IsArenaAllocated);
   } else {
     Use *Storage = static_cast<Use *>(Usr) - Obj->NumUserOperands;
     Use::zap(Storage, Storage + Obj->NumUserOperands,
              /* Delete */ false);
-    ::operator delete(Storage);
+    freeUserStorage(Storage, Obj->IsArenaAllocated);
   }
 }
 
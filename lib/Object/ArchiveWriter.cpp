@@ -17,6 +17,7 @@
 #include "llvm/BinaryFormat/Magic.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/Object/Archive.h"
+#include "llvm/Object/IRObjectFile.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Object/SymbolicFile.h"
 #include "llvm/Support/EndianStream.h"
@@ -290,8 +291,57 @@ writeSymbolTable(raw_fd_ostream &Out, object::Archive::Kind Kind,
   SmallString<128> NameBuf;
   raw_svector_ostream NameOS(NameBuf);
   LLVMContext Context;
+
+  // Starts the symbol table when the first member which is an object file is
+  // seen.
+  auto startSymbolTable = [&] {
+    if (HeaderStartOffset)
+      return;
+    HeaderStartOffset = Out.tell();
+    if (isBSDLike(Kind))
+      printBSDMemberHeader(Out, "__.SYMDEF", now(Deterministic), 0, 0, 0, 0);
+    else
+      printGNUSmallMemberHeader(Out, "", now(Deterministic), 0, 0, 0, 0);
+    BodyStartOffset = Out.tell();
+    print32(Out, Kind, 0); // number of entries or bytes
+  };
+
+  // Adds an entry for the symbol whose name starts at NameOffset.
+  auto addSymbol = [&](unsigned MemberNum, unsigned NameOffset) {
+    NameOS << '\0';
+    MemberOffsetRefs.push_back(MemberNum);
+    if (isBSDLike(Kind))
+      print32(Out, Kind, NameOffset);
+    print32(Out, Kind, 0); // member offset
+  };
+
   for (unsigned MemberNum = 0, N = Members.size(); MemberNum < N; ++MemberNum) {
     MemoryBufferRef MemberBuffer = Members[MemberNum].Buf->getMemBufferRef();
+
+    // Bitcode members carry a symbol table of their own, which is read in
+    // place, without loading the module or copying the names. It cannot be
+    // built for modules without a datalayout, which are handled below.
+    if (identify_magic(MemberBuffer.getBuffer()) == file_magic::bitcode) {
+      Expected<object::IRSymtabFile> SymtabOrErr =
+          object::readIRSymtab(MemberBuffer);
+      if (SymtabOrErr) {
+        startSymbolTable();
+        for (const irsymtab::Reader::SymbolRef &Sym :
+             SymtabOrErr->TheReader.symbols()) {
+          // This is the same filter as below, on the irsymtab flags.
+          if (Sym.isFormatSpecific() || !Sym.isGlobal())
+            continue;
+          if (Sym.isUndefined() && !Sym.isIndirect())
+            continue;
+          unsigned NameOffset = NameOS.tell();
+          NameOS << Sym.getName();
+          addSymbol(MemberNum, NameOffset);
+        }
+        continue;
+      }
+      consumeError(SymtabOrErr.takeError());
+    }
+
     Expected<std::unique_ptr<object::SymbolicFile>> ObjOrErr =
         object::SymbolicFile::createSymbolicFile(
             MemberBuffer, llvm::file_magic::unknown, &Context);
@@ -302,16 +352,7 @@ writeSymbolTable(raw_fd_ostream &Out, object::Archive::Kind Kind,
     }
     object::SymbolicFile &Obj = *ObjOrErr.get();
 
-    if (!HeaderStartOffset) {
-      HeaderStartOffset = Out.tell();
-      if (isBSDLike(Kind))
-        printBSDMemberHeader(Out, "__.SYMDEF", now(Deterministic), 0, 0, 0, 0);
-      else
-        printGNUSmallMemberHeader(Out, "", now(Deterministic), 0, 0, 0, 0);
-      BodyStartOffset = Out.tell();
-      print32(Out, Kind, 0); // number of entries or bytes
-    }
-
+    startSymbolTable();
     for (const object::BasicSymbolRef &S : Obj.symbols()) {
       uint32_t Symflags = S.getFlags();
       if (Symflags & object::SymbolRef::SF_FormatSpecific)
@@ -325,11 +366,7 @@ writeSymbolTable(raw_fd_ostream &Out, object::Archive::Kind Kind,
       unsigned NameOffset = NameOS.tell();
       if (auto EC = S.printName(NameOS))
         return EC;
-      NameOS << '\0';
-      MemberOffsetRefs.push_back(MemberNum);
-      if (isBSDLike(Kind))
-        print32(Out, Kind, NameOffset);
-      print32(Out, Kind, 0); // member offset
+      addSymbol(MemberNum, NameOffset);
     }
   }
 
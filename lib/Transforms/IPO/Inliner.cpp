@@ -51,6 +51,8 @@ STATISTIC(NumMergedAllocas, "Number of allocas merged together");
 // if those would be more profitable and blocked inline steps.
 STATISTIC(NumCallerCallersAnalyzed, "Number of caller-callers analyzed");
 
+STATISTIC(NumInlineCostsReused, "Number of inline costs reused");
+
 /// Flag to disable manual alloca merging.
 ///
 /// Merging of allocas was originally done as a stack-size saving technique
@@ -77,6 +79,75 @@ cl::opt<InlinerFunctionImportStatsOpts> InlinerFunctionImportStats(
                clEnumValN(InlinerFunctionImportStatsOpts::Verbose, "verbose",
                           "printing of statistics for each inlined function")),
     cl::Hidden, cl::desc("Enable inliner stats for imported functions"));
+
+/// Remembers the inline costs computed while the inliner visits an SCC.
+///
+/// The cost of a call site depends on its arguments, on the body and
+/// attributes of its caller, and on the body and the number of uses of its
+/// callee. While it visits an SCC, the inliner is the only thing changing
+/// functions, and it reports each function it changes in one of these ways.
+/// A cost is reused until its caller or its callee has been reported.
+/// Deferral decisions query the costs of all the callers of a function each
+/// time it is about to be inlined into; most of those are reused.
+class InlineCostCache {
+public:
+  InlineCost get(CallSite CS, function_ref<InlineCost(CallSite CS)> Compute) {
+    Function *Caller = CS.getCaller();
+    Function *Callee = CS.getCalledFunction();
+    auto It = Costs.find(CS.getInstruction());
+    if (It != Costs.end()) {
+      const Entry &E = It->second;
+      // The call site may be a new instruction at the address of a deleted
+      // one, and then it is in a changed function.
+      if (E.Caller == Caller && E.Callee == Callee &&
+          ChangedAt.lookup(Caller) <= E.ComputedAt &&
+          ChangedAt.lookup(Callee) <= E.ComputedAt) {
+        ++NumInlineCostsReused;
+        return E.IC;
+      }
+      Costs.erase(It);
+    }
+    InlineCost IC = Compute(CS);
+    Costs.insert({CS.getInstruction(), {Caller, Callee, Epoch, IC}});
+    return IC;
+  }
+
+  /// Reports that the body, the attributes or the number of uses of \p F
+  /// changed.
+  void invalidate(Function *F) { ChangedAt[F] = ++Epoch; }
+
+  /// Reports that \p Callee has been inlined into \p Caller, with the calls
+  /// in \p InlinedCalls as the inlined copies of its calls.
+  template <typename RangeT>
+  void invalidateInlined(Function *Caller, Function *Callee,
+                         const RangeT &InlinedCalls) {
+    invalidate(Caller);
+    invalidate(Callee);
+    for (const auto &Call : InlinedCalls)
+      if (CallSite CS = CallSite(Call))
+        if (Function *F = CS.getCalledFunction())
+          invalidate(F);
+  }
+
+  /// Drops all costs, when a function has been deleted.
+  void clear() {
+    Costs.clear();
+    ChangedAt.clear();
+  }
+
+private:
+  struct Entry {
+    Function *Caller;
+    Function *Callee;
+    unsigned ComputedAt;
+    InlineCost IC;
+  };
+
+  DenseMap<const Instruction *, Entry> Costs;
+  /// The epoch at which each function last changed.
+  DenseMap<const Function *, unsigned> ChangedAt;
+  unsigned Epoch = 0;
+};
 } // namespace
 
 LegacyInlinerBase::LegacyInlinerBase(char &ID)
@@ -505,6 +576,11 @@ inlineCallsImpl(CallGraphSCC &SCC, CallGraph &CG,
   InlinedArrayAllocasTy InlinedArrayAllocas;
   InlineFunctionInfo InlineInfo(&CG, &GetAssumptionCache, PSI);
 
+  InlineCostCache Costs;
+  auto GetCachedInlineCost = [&](CallSite CS) {
+    return Costs.get(CS, GetInlineCost);
+  };
+
   // Now that we have all of the call sites, loop over them and inline them if
   // it looks profitable to do so.
   bool Changed = false;
@@ -546,7 +622,7 @@ inlineCallsImpl(CallGraphSCC &SCC, CallGraph &CG,
       // just become a regular analysis dependency.
       OptimizationRemarkEmitter ORE(Caller);
 
-      Optional<InlineCost> OIC = shouldInline(CS, GetInlineCost, ORE);
+      Optional<InlineCost> OIC = shouldInline(CS, GetCachedInlineCost, ORE);
       // If the policy determines that we should inline this function,
       // delete the call instead.
       if (!OIC)
@@ -562,6 +638,8 @@ inlineCallsImpl(CallGraphSCC &SCC, CallGraph &CG,
         CG[Caller]->removeCallEdgeFor(CS);
         Instr->eraseFromParent();
         ++NumCallsDeleted;
+        Costs.invalidate(Caller);
+        Costs.invalidate(Callee);
       } else {
         // Get DebugLoc to report. CS will be invalid after Inliner.
         DebugLoc DLoc = CS->getDebugLoc();
@@ -579,6 +657,7 @@ inlineCallsImpl(CallGraphSCC &SCC, CallGraph &CG,
           continue;
         }
         ++NumInlined;
+        Costs.invalidateInlined(Caller, Callee, InlineInfo.InlinedCalls);
 
         if (OIC->isAlways())
           ORE.emit(OptimizationRemark(DEBUG_TYPE, "AlwaysInline", DLoc, Block)
@@ -627,6 +706,7 @@ inlineCallsImpl(CallGraphSCC &SCC, CallGraph &CG,
         // Removing the node for callee from the call graph and delete it.
         delete CG.removeFunctionFromModule(CalleeNode);
         ++NumDeleted;
+        Costs.clear();
       }
 
       // Remove this call site from the list.  If possible, use
@@ -825,6 +905,8 @@ PreservedAnalyses InlinerPass::run(LazyCallGraph::SCC &InitialC,
   // defer deleting these to make it easier to handle the call graph updates.
   SmallVector<Function *, 4> DeadFunctions;
 
+  InlineCostCache Costs;
+
   // Loop forward over all of the calls. Note that we cannot cache the size as
   // inlining can introduce new calls that need to be processed.
   for (int i = 0; i < (int)Calls.size(); ++i) {
@@ -897,7 +979,8 @@ PreservedAnalyses InlinerPass::run(LazyCallGraph::SCC &InitialC,
         continue;
       }
 
-      Optional<InlineCost> OIC = shouldInline(CS, GetInlineCost, ORE);
+      Optional<InlineCost> OIC = shouldInline(
+          CS, [&](CallSite CS) { return Costs.get(CS, GetInlineCost); }, ORE);
       // Check whether we want to inline this callsite.
       if (!OIC)
         continue;
@@ -923,6 +1006,7 @@ PreservedAnalyses InlinerPass::run(LazyCallGraph::SCC &InitialC,
       }
       DidInline = true;
       InlinedCallees.insert(&Callee);
+      Costs.invalidateInlined(&F, &Callee, IFI.InlinedCallSites);
 
       if (OIC->isAlways())
         ORE.emit(OptimizationRemark(DEBUG_TYPE, "AlwaysInline", DLoc, Block)
@@ -971,6 +1055,7 @@ PreservedAnalyses InlinerPass::run(LazyCallGraph::SCC &InitialC,
           assert(find(DeadFunctions, &Callee) == DeadFunctions.end() &&
                  "Cannot put cause a function to become dead twice!");
           DeadFunctions.push_back(&Callee);
+          Costs.clear();
         }
       }
     }
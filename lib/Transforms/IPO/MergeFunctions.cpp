@@ -21,8 +21,8 @@
 // for all a and b: a <= b or b <= a (totality).
 //
 // Comparison iterates through each instruction in each basic block.
-// Functions are kept on binary tree. For each new function F we perform
-// lookup in binary tree.
+// Functions are kept on binary trees, one per hash value (see below). For each
+// new function F we perform lookup in the binary tree of its hash.
 // In practice it works the following way:
 // -- We define Function* container class with custom "operator<" (FunctionPtr).
 // -- "FunctionPtr" instances are stored in std::set collection, so every
@@ -34,7 +34,10 @@
 // the comparison function, then hash(F) == hash(G). This consistency property
 // is critical to ensuring all possible merging opportunities are exploited.
 // Collisions in the hash affect the speed of the pass but not the correctness
-// or determinism of the resulting transformation.
+// or determinism of the resulting transformation. Functions with a hash no
+// other function has are never compared at all. The hash only depends on the
+// opcodes and the shape of the CFG, which merging never changes in the
+// functions it does not delete.
 //
 // When a match is found the functions are folded. If both functions are
 // overridable, we move the functionality into a new internal function and
@@ -108,9 +111,11 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/Utils/FunctionComparator.h"
+#include <unordered_map>
 #include <vector>
 
 using namespace llvm;
@@ -120,6 +125,8 @@ using namespace llvm;
 STATISTIC(NumFunctionsMerged, "Number of functions merged");
 STATISTIC(NumThunksWritten, "Number of thunks generated");
 STATISTIC(NumDoubleWeak, "Number of new functions created");
+STATISTIC(NumComparisons, "Number of function comparisons");
+STATISTIC(NumUniqueHashes, "Number of functions with a unique hash");
 
 static cl::opt<unsigned> NumFunctionsForSanityCheck(
     "mergefunc-sanity",
@@ -148,15 +155,20 @@ static cl::opt<bool>
                       cl::desc("Preserve debug info in thunk when mergefunc "
                                "transformations are made."));
 
+static cl::opt<bool>
+    MergeFunctionsParallelHash("mergefunc-parallel-hash", cl::Hidden,
+                               cl::init(false),
+                               cl::desc("Hash the functions of the module on "
+                                        "several threads."));
+
 namespace {
 
 class FunctionNode {
   mutable AssertingVH<Function> F;
   FunctionComparator::FunctionHash Hash;
 public:
-  // Note the hash is recalculated potentially multiple times, but it is cheap.
-  FunctionNode(Function *F)
-    : F(F), Hash(FunctionComparator::functionHash(*F))  {}
+  FunctionNode(Function *F, FunctionComparator::FunctionHash Hash)
+    : F(F), Hash(Hash)  {}
   Function *getFunc() const { return F; }
   FunctionComparator::FunctionHash getHash() const { return Hash; }
 
@@ -178,7 +190,7 @@ class MergeFunctions : public ModulePass {
 public:
   static char ID;
   MergeFunctions()
-    : ModulePass(ID), FnTree(FunctionNodeCmp(&GlobalNumbers)), FNodesInTree() {
+    : ModulePass(ID), FNodesInTree() {
     initializeMergeFunctionsPass(*PassRegistry::getPassRegistry());
   }
 
@@ -192,14 +204,16 @@ private:
   public:
     FunctionNodeCmp(GlobalNumberState* GN) : GlobalNumbers(GN) {}
     bool operator()(const FunctionNode &LHS, const FunctionNode &RHS) const {
-      // Order first by hashes, then full function comparison.
-      if (LHS.getHash() != RHS.getHash())
-        return LHS.getHash() < RHS.getHash();
+      // All the functions of a tree have the same hash.
+      assert(LHS.getHash() == RHS.getHash() && "Comparing across trees!");
+      ++NumComparisons;
       FunctionComparator FCmp(LHS.getFunc(), RHS.getFunc(), GlobalNumbers);
       return FCmp.compare() == -1;
     }
   };
   typedef std::set<FunctionNode, FunctionNodeCmp> FnTreeType;
+  typedef std::unordered_map<FunctionComparator::FunctionHash, FnTreeType>
+      FnTreesType;
 
   GlobalNumberState GlobalNumbers;
 
@@ -213,9 +227,9 @@ private:
   bool doSanityCheck(std::vector<WeakTrackingVH> &Worklist);
 #endif
 
-  /// Insert a ComparableFunction into the FnTree, or merge it away if it's
-  /// equal to one that's already present.
-  bool insert(Function *NewFunction);
+  /// Insert a ComparableFunction into the FnTree of its hash \p Hash, or merge
+  /// it away if it's equal to one that's already present.
+  bool insert(Function *NewFunction, FunctionComparator::FunctionHash Hash);
 
   /// Remove a Function from the FnTree and queue it up for a second sweep of
   /// analysis.
@@ -254,14 +268,15 @@ private:
   /// Replace function F with function G in the function tree.
   void replaceFunctionInTree(const FunctionNode &FN, Function *G);
 
-  /// The set of all distinct functions. Use the insert() and remove() methods
-  /// to modify it. The map allows efficient lookup and deferring of Functions.
-  FnTreeType FnTree;
+  /// The sets of all distinct functions, one FnTree per hash value. Use the
+  /// insert() and remove() methods to modify them. The map allows efficient
+  /// lookup and deferring of Functions.
+  FnTreesType FnTrees;
   // Map functions to the iterators of the FunctionNode which contains them
-  // in the FnTree. This must be updated carefully whenever the FnTree is
+  // in an FnTree. This must be updated carefully whenever an FnTree is
   // modified, i.e. in insert(), remove(), and replaceFunctionInTree(), to avoid
-  // dangling iterators into FnTree. The invariant that preserves this is that
-  // there is exactly one mapping F -> FN for each FunctionNode FN in FnTree.
+  // dangling iterators into FnTrees. The invariant that preserves this is that
+  // there is exactly one mapping F -> FN for each FunctionNode FN in FnTrees.
   ValueMap<Function*, FnTreeType::iterator> FNodesInTree;
 };
 
@@ -359,9 +374,19 @@ bool MergeFunctions::runOnModule(Module &M) {
     HashedFuncs;
   for (Function &Func : M) {
     if (!Func.isDeclaration() && !Func.hasAvailableExternallyLinkage()) {
-      HashedFuncs.push_back({FunctionComparator::functionHash(Func), &Func});
+      HashedFuncs.push_back({0, &Func});
     } 
   }
+  // Hashing only reads the functions.
+  auto HashFunction =
+      [](std::pair<FunctionComparator::FunctionHash, Function *> &HF) {
+        HF.first = FunctionComparator::functionHash(*HF.second);
+      };
+  if (MergeFunctionsParallelHash)
+    parallel::for_each(parallel::par, HashedFuncs.begin(), HashedFuncs.end(),
+                       HashFunction);
+  else
+    std::for_each(HashedFuncs.begin(), HashedFuncs.end(), HashFunction);
 
   std::stable_sort(
       HashedFuncs.begin(), HashedFuncs.end(),
@@ -370,6 +395,8 @@ bool MergeFunctions::runOnModule(Module &M) {
         return a.first < b.first;
       });
 
+  // The hashes of the first worklist, in the same order.
+  std::vector<FunctionComparator::FunctionHash> WorklistHashes;
   auto S = HashedFuncs.begin();
   for (auto I = HashedFuncs.begin(), IE = HashedFuncs.end(); I != IE; ++I) {
     // If the hash value matches the previous value or the next one, we must
@@ -377,6 +404,9 @@ bool MergeFunctions::runOnModule(Module &M) {
     if ((I != S && std::prev(I)->first == I->first) ||
         (std::next(I) != IE && std::next(I)->first == I->first) ) {
       Deferred.push_back(WeakTrackingVH(I->second));
+      WorklistHashes.push_back(I->first);
+    } else {
+      ++NumUniqueHashes;
     }
   }
   
@@ -390,18 +420,24 @@ bool MergeFunctions::runOnModule(Module &M) {
     DEBUG(dbgs() << "size of worklist: " << Worklist.size() << '\n');
 
     // Insert functions and merge them.
-    for (WeakTrackingVH &I : Worklist) {
+    for (unsigned Idx = 0, E = Worklist.size(); Idx != E; ++Idx) {
+      WeakTrackingVH &I = Worklist[Idx];
       if (!I)
         continue;
       Function *F = cast<Function>(I);
       if (!F->isDeclaration() && !F->hasAvailableExternallyLinkage()) {
-        Changed |= insert(F);
+        // The functions deferred by a merge are hashed again.
+        FunctionComparator::FunctionHash Hash =
+            WorklistHashes.empty() ? FunctionComparator::functionHash(*F)
+                                   : WorklistHashes[Idx];
+        Changed |= insert(F, Hash);
       }
     }
-    DEBUG(dbgs() << "size of FnTree: " << FnTree.size() << '\n');
+    WorklistHashes.clear();
+    DEBUG(dbgs() << "size of FnTrees: " << FNodesInTree.size() << '\n');
   } while (!Deferred.empty());
 
-  FnTree.clear();
+  FnTrees.clear();
   GlobalNumbers.clear();
 
   return Changed;
@@ -758,11 +794,16 @@ void MergeFunctions::replaceFunctionInTree(const FunctionNode &FN,
   FN.replaceBy(G);
 }
 
-// Insert a ComparableFunction into the FnTree, or merge it away if equal to one
-// that was already inserted.
-bool MergeFunctions::insert(Function *NewFunction) {
+// Insert a ComparableFunction into the FnTree of its hash, or merge it away if
+// equal to one that was already inserted.
+bool MergeFunctions::insert(Function *NewFunction,
+                            FunctionComparator::FunctionHash Hash) {
+  auto TreeIt = FnTrees.find(Hash);
+  if (TreeIt == FnTrees.end())
+    TreeIt = FnTrees.insert({Hash, FnTreeType(FunctionNodeCmp(&GlobalNumbers))})
+                 .first;
   std::pair<FnTreeType::iterator, bool> Result =
-      FnTree.insert(FunctionNode(NewFunction));
+      TreeIt->second.insert(FunctionNode(NewFunction, Hash));
 
   if (Result.second) {
     assert(FNodesInTree.count(NewFunction) == 0);
@@ -814,7 +855,8 @@ void MergeFunctions::remove(Function *F) {
   auto I = FNodesInTree.find(F);
   if (I != FNodesInTree.end()) {
     DEBUG(dbgs() << "Deferred " << F->getName()<< ".\n");
-    FnTree.erase(I->second);
+    // Empty trees are left in place, the hash is likely to come back.
+    FnTrees.find(I->second->getHash())->second.erase(I->second);
     // I->second has been invalidated, remove it from the FNodesInTree map to
     // preserve the invariant.
     FNodesInTree.erase(I);
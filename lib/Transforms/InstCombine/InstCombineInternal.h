@@ -233,6 +233,11 @@ private:
 
   bool MadeIRChange;
 
+  /// The instruction operands of the instruction being visited, as they were
+  /// before the visit. With RequeueDecrementedOperands, the ones it no longer
+  /// uses afterwards are revisited.
+  SmallVector<Instruction *, 4> VisitedOperands;
+
 public:
   InstCombiner(InstCombineWorklist &Worklist, BuilderTy &Builder,
                bool MinimizeSize, bool ExpensiveCombines, AliasAnalysis *AA,
@@ -533,13 +538,21 @@ public:
 
     // Make sure that we reprocess all operands now that we reduced their
     // use counts.
+    SmallVector<Instruction *, 8> Operands;
     if (I.getNumOperands() < 8) {
       for (Use &Operand : I.operands())
-        if (auto *Inst = dyn_cast<Instruction>(Operand))
+        if (auto *Inst = dyn_cast<Instruction>(Operand)) {
           Worklist.Add(Inst);
+          if (RequeueDecrementedOperands && Inst != &I)
+            Operands.push_back(Inst);
+        }
     }
     Worklist.Remove(&I);
+    std::replace(VisitedOperands.begin(), VisitedOperands.end(), &I,
+                 static_cast<Instruction *>(nullptr));
     I.eraseFromParent();
+    for (Instruction *Inst : Operands)
+      Worklist.AddUseCountDecremented(Inst);
     MadeIRChange = true;
     return nullptr; // Don't do anything with FI
   }
@@ -586,6 +599,11 @@ public:
   /// Maximum size of array considered when transforming.
   uint64_t MaxArraySizeForCombine;
 
+  /// Whether the operands which lose a use, and their remaining single users,
+  /// are revisited once the pending folds are done. This lets a single
+  /// iteration reach the fixpoint, at the cost of a different visit order.
+  bool RequeueDecrementedOperands = false;
+
 private:
   /// \brief Performs a few simplifications for operators which are associative
   /// or commutative.
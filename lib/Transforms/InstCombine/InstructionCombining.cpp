@@ -54,6 +54,7 @@
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/DIBuilder.h"
 #include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/Dominators.h"
 #include "llvm/IR/GetElementPtrTypeIterator.h"
 #include "llvm/IR/IntrinsicInst.h"
@@ -62,6 +63,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/DebugCounter.h"
+#include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/KnownBits.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/InstCombine/InstCombine.h"
@@ -81,6 +83,10 @@ STATISTIC(NumSunkInst , "Number of instructions sunk");
 STATISTIC(NumExpand,    "Number of expansions");
 STATISTIC(NumFactor   , "Number of factorizations");
 STATISTIC(NumReassoc  , "Number of reassociations");
+STATISTIC(NumWorklistIterations,
+          "Number of instruction combining iterations performed");
+STATISTIC(NumIterationLimitReached,
+          "Number of functions stopped at the iteration limit");
 DEBUG_COUNTER(VisitCounter, "instcombine-visit",
               "Controls which instructions are visited");
 
@@ -88,6 +94,23 @@ static cl::opt<bool>
 EnableExpensiveCombines("expensive-combines",
                         cl::desc("Enable expensive instruction combines"));
 
+static cl::opt<unsigned>
+MaxIterations("instcombine-max-iterations", cl::init(0), cl::Hidden,
+              cl::desc("Maximum number of iterations over a function, each "
+                       "visiting all its instructions (0 = no limit)"));
+
+static cl::opt<bool>
+SingleIterationMode("instcombine-single-iteration", cl::init(false),
+                    cl::Hidden,
+                    cl::desc("Revisit the instructions each change may enable "
+                             "folds for, and iterate over a function once"));
+
+static cl::opt<bool>
+VerifyFixpoint("instcombine-verify-fixpoint", cl::init(false), cl::Hidden,
+               cl::desc("Iterate over a function once, as "
+                        "-instcombine-single-iteration does, and abort if a "
+                        "second iteration would still change it"));
+
 static cl::opt<unsigned>
 MaxArraySize("instcombine-maxarray-size", cl::init(1024),
              cl::desc("Maximum array size considered when doing a combine"));
@@ -2998,6 +3021,12 @@ bool InstCombiner::run() {
     DEBUG(raw_string_ostream SS(OrigI); I->print(SS); OrigI = SS.str(););
     DEBUG(dbgs() << "IC: Visiting: " << OrigI << '\n');
 
+    VisitedOperands.clear();
+    if (RequeueDecrementedOperands && I->getNumOperands() < 8)
+      for (Use &U : I->operands())
+        if (Instruction *OpI = dyn_cast<Instruction>(U.get()))
+          VisitedOperands.push_back(OpI);
+
     if (Instruction *Result = visit(*I)) {
       ++NumCombined;
       // Should we replace the old instruction with a new one?
@@ -3040,6 +3069,11 @@ bool InstCombiner::run() {
         } else {
           Worklist.AddUsersToWorkList(*I);
           Worklist.Add(I);
+          // The operands replaced in place have lost a use. Those erased
+          // during the visit have been nulled out.
+          for (Instruction *OpI : VisitedOperands)
+            if (OpI && !is_contained(I->operands(), OpI))
+              Worklist.AddUseCountDecremented(OpI);
         }
       }
       MadeIRChange = true;
@@ -3219,24 +3253,57 @@ static bool combineInstructionsOverFunction(
   if (ShouldLowerDbgDeclare)
     MadeIRChange = LowerDbgDeclare(F);
 
+  // In single iteration mode, the worklist gets the instructions each change
+  // may enable new folds for, so that one iteration reaches the fixpoint.
+  bool SingleIteration = SingleIterationMode || VerifyFixpoint;
+  unsigned Limit = SingleIteration ? 1 : MaxIterations;
+
   // Iterate while there is work to do.
-  int Iteration = 0;
+  unsigned Iteration = 0;
   for (;;) {
+    bool Verifying = false;
+    if (Limit != 0 && Iteration == Limit) {
+      if (VerifyFixpoint) {
+        // One more iteration checks that it changes nothing.
+        Verifying = true;
+      } else {
+        if (!SingleIteration) {
+          ++NumIterationLimitReached;
+          F.getContext().diagnose(DiagnosticInfoOptimizationFailure(
+              F, F.getSubprogram(),
+              "instruction combining stopped after " + Twine(Limit) +
+                  " iterations without reaching a fixpoint"));
+        }
+        break;
+      }
+    }
+
     ++Iteration;
+    ++NumWorklistIterations;
     DEBUG(dbgs() << "\n\nINSTCOMBINE ITERATION #" << Iteration << " on "
                  << F.getName() << "\n");
 
-    MadeIRChange |= prepareICWorklistFromFunction(F, DL, &TLI, Worklist);
+    bool Prepared = prepareICWorklistFromFunction(F, DL, &TLI, Worklist);
+    MadeIRChange |= Prepared;
 
     InstCombiner IC(Worklist, Builder, F.optForMinSize(), ExpensiveCombines, AA,
                     AC, TLI, DT, ORE, DL, LI);
     IC.MaxArraySizeForCombine = MaxArraySize;
-
-    if (!IC.run())
+    IC.RequeueDecrementedOperands = SingleIteration;
+
+    bool Combined = IC.run();
+    MadeIRChange |= Combined;
+    if (Verifying) {
+      if (Prepared || Combined)
+        report_fatal_error("Instruction Combining did not reach a fixpoint "
+                           "in one iteration on " + F.getName());
+      break;
+    }
+    if (!Combined)
       break;
   }
 
-  return MadeIRChange || Iteration > 1;
+  return MadeIRChange;
 }
 
 PreservedAnalyses InstCombinePass::run(Function &F,
@@ -35,9 +35,12 @@
 #include "llvm/Analysis/LoopInfo.h"
 #include "llvm/Analysis/MemoryBuiltins.h"
 #include "llvm/Analysis/MemoryDependenceAnalysis.h"
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/Analysis/MemorySSAUpdater.h"
 #include "llvm/Analysis/OptimizationDiagnosticInfo.h"
 #include "llvm/Analysis/PHITransAddr.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/Attributes.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/CallSite.h"
@@ -95,6 +98,11 @@ STATISTIC(NumPRELoad,   "Number of loads PRE'd");
 static cl::opt<bool> EnablePRE("enable-pre",
                                cl::init(true), cl::Hidden);
 static cl::opt<bool> EnableLoadPRE("enable-load-pre", cl::init(true));
+static cl::opt<bool> EnableMemorySSA(
+    "enable-gvn-memoryssa", cl::init(false), cl::Hidden,
+    cl::desc("Find the dependencies of loads with MemorySSA, which has no "
+             "block scan limits and looks across blocks, rather than with "
+             "MemoryDependenceAnalysis"));
 
 // Maximum allowed recursion depth.
 static cl::opt<uint32_t>
@@ -1455,7 +1463,7 @@ bool GVN::processLoad(LoadInst *L) {
   }
 
   // ... to a pointer that has been loaded from before...
-  MemDepResult Dep = MD->getDependency(L);
+  MemDepResult Dep = MSSA ? getMemorySSADependency(L) : MD->getDependency(L);
 
   // If it is defined in another block, try harder.
   if (Dep.isNonLocal())
@@ -1492,6 +1500,55 @@ bool GVN::processLoad(LoadInst *L) {
   return false;
 }
 
+MemDepResult GVN::getMemorySSADependency(LoadInst *L) {
+  // Loads inserted by load PRE have no memory access.
+  if (!MSSA->getMemoryAccess(L))
+    return MD->getDependency(L);
+
+  MemorySSAWalker *Walker = MSSA->getWalker();
+  MemoryAccess *Clobber = Walker->getClobberingMemoryAccess(L);
+
+  // An earlier load of the same pointer which sees the same memory makes L
+  // fully redundant. Loads GVN deletes drop out of the list by themselves.
+  Value *Ptr = L->getPointerOperand();
+  SmallVectorImpl<WeakVH> &Loads = MemorySSALoads[{Ptr, Clobber}];
+  for (WeakVH &VH : Loads)
+    if (auto *Other = cast_or_null<LoadInst>(VH))
+      if (DT->dominates(Other, L))
+        return MemDepResult::getDef(Other);
+  Loads.push_back(L);
+
+  const DataLayout &DL = L->getModule()->getDataLayout();
+  if (MSSA->isLiveOnEntryDef(Clobber)) {
+    // Nothing in the function writes the memory before L. Loads from a fresh
+    // alloca are undefined.
+    auto *AI = dyn_cast<AllocaInst>(GetUnderlyingObject(Ptr, DL));
+    if (AI && DT->dominates(AI, L))
+      return MemDepResult::getDef(AI);
+    return MemDepResult::getNonFuncLocal();
+  }
+
+  auto *Def = dyn_cast<MemoryDef>(Clobber);
+  if (!Def)
+    return MemDepResult::getNonLocal();
+  Instruction *DefInst = Def->getMemoryInst();
+  if (!DT->dominates(DefInst, L))
+    return MemDepResult::getNonLocal();
+
+  // A store to the same location, or the allocation of the memory, defines
+  // the value, as with MemoryDependenceAnalysis. Anything else clobbers it.
+  if (auto *SI = dyn_cast<StoreInst>(DefInst)) {
+    AliasAnalysis *AA = VN.getAliasAnalysis();
+    if (AA->alias(MemoryLocation::get(SI), MemoryLocation::get(L)) ==
+        MustAlias)
+      return MemDepResult::getDef(SI);
+  } else if (isNoAliasFn(DefInst, TLI) &&
+             GetUnderlyingObject(Ptr, DL) == DefInst) {
+    return MemDepResult::getDef(DefInst);
+  }
+  return MemDepResult::getClobber(DefInst);
+}
+
 /// Return a pair the first field showing the value number of \p Exp and the
 /// second field showing whether it is a value number newly created.
 std::pair<uint32_t, bool>
@@ -1992,6 +2049,19 @@ bool GVN::runImpl(Function &F, AssumptionCache &RunAC, DominatorTree &RunDT,
     Changed |= removedBlock;
   }
 
+  std::unique_ptr<MemorySSA> RunMSSA;
+  std::unique_ptr<MemorySSAUpdater> RunMSSAU;
+  if (EnableMemorySSA && MD) {
+    {
+      // Building MemorySSA queries AA for every pair of nearby accesses.
+      BatchAAScope BatchAA(RunAA);
+      RunMSSA = llvm::make_unique<MemorySSA>(F, &RunAA, DT);
+    }
+    RunMSSAU = llvm::make_unique<MemorySSAUpdater>(RunMSSA.get());
+    MSSA = RunMSSA.get();
+    MSSAU = RunMSSAU.get();
+  }
+
   unsigned Iteration = 0;
   while (ShouldContinue) {
     DEBUG(dbgs() << "GVN iteration: " << Iteration << "\n");
@@ -2000,6 +2070,10 @@ bool GVN::runImpl(Function &F, AssumptionCache &RunAC, DominatorTree &RunDT,
     ++Iteration;
   }
 
+  // Only load elimination uses MemorySSA.
+  MSSA = nullptr;
+  MSSAU = nullptr;
+
   if (EnablePRE) {
     // Fabricate val-num for dead-code in order to suppress assertion in
     // performPRE().
@@ -2060,6 +2134,9 @@ bool GVN::processBlock(BasicBlock *BB) {
          E = InstrsToErase.end(); I != E; ++I) {
       DEBUG(dbgs() << "GVN removed: " << **I << '\n');
       if (MD) MD->removeInstruction(*I);
+      if (MSSAU)
+        if (MemoryAccess *MA = MSSA->getMemoryAccess(*I))
+          MSSAU->removeMemoryAccess(MA);
       DEBUG(verifyRemoved(*I));
       (*I)->eraseFromParent();
     }
@@ -2332,6 +2409,7 @@ bool GVN::iterateOnFunction(Function &F) {
 
 void GVN::cleanupGlobalSets() {
   VN.clear();
+  MemorySSALoads.clear();
   LeaderTable.clear();
   BlockRPONumber.clear();
   TableAllocator.Reset();
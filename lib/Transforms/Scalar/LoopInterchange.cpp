@@ -565,6 +565,8 @@ struct LoopInterchange : public FunctionPass {
       // Update the DependencyMatrix
       interChangeDependencies(DependencyMatrix, i, i - 1);
       DT->recalculate(F);
+      // The accesses of the nest are now on other loops.
+      DI->forgetCachedResults();
 #ifdef DUMP_DEP_MATRICIES
       DEBUG(dbgs() << "Dependence after interchange\n");
       printDepMatrix(DependencyMatrix);
@@ -112,6 +112,7 @@ STATISTIC(NumPromoted, "Number of allocas promoted to SSA values");
 STATISTIC(NumLoadsSpeculated, "Number of loads speculated to allow promotion");
 STATISTIC(NumDeleted, "Number of instructions deleted");
 STATISTIC(NumVectorized, "Number of vectorized aggregates");
+STATISTIC(NumAllocasTooManySlices, "Number of allocas with too many slices");
 
 /// Hidden option to enable randomly shuffling the slices to help uncover
 /// instability in their order.
@@ -123,6 +124,19 @@ static cl::opt<bool> SROARandomShuffleSlices("sroa-random-shuffle-slices",
 static cl::opt<bool> SROAStrictInbounds("sroa-strict-inbounds", cl::init(false),
                                         cl::Hidden);
 
+/// Hidden option to bound the rewriting work on very large aggregates. Every
+/// splittable slice is rewritten once per partition it spans, so the work grows
+/// with the product of the numbers of partitions and of wide slices, such as
+/// the memcpys of a whole struct with thousands of fields. The bound applies to
+/// the alloca as a whole: past it, none of its partitions is rewritten, even
+/// those with few slices.
+static cl::opt<unsigned> SROAMaxAllocaSlices(
+    "sroa-max-alloca-slices", cl::init(0), cl::Hidden,
+    cl::desc("Leave the allocas whose splitting would rewrite more slices "
+             "than this, counting a slice once per partition it spans, "
+             "entirely unsplit, small partitions included (0 means no "
+             "limit)"));
+
 namespace {
 
 /// \brief A custom IRBuilder inserter which prefixes all names, but only in
@@ -4034,6 +4048,26 @@ AllocaInst *SROA::rewritePartition(AllocaInst &AI, AllocaSlices &AS,
   return NewAI;
 }
 
+/// \brief Returns true if splitting the alloca would rewrite more slices than
+/// -sroa-max-alloca-slices allows.
+///
+/// A splittable slice is rewritten once for every partition it spans. An
+/// alloca forming a single partition is rewritten as a whole and then
+/// promoted, however many loads and stores it has, so it is never too large.
+static bool tooManySlicesToSplit(AllocaSlices &AS) {
+  unsigned NumPartitions = 0;
+  unsigned NumRewrites = 0;
+  for (auto &P : AS.partitions()) {
+    ++NumPartitions;
+    NumRewrites += (P.end() - P.begin()) + P.splitSliceTails().size();
+  }
+  if (NumPartitions < 2 || NumRewrites <= SROAMaxAllocaSlices)
+    return false;
+  DEBUG(dbgs() << "  Too many slices to split: " << NumRewrites << " in "
+               << NumPartitions << " partitions\n");
+  return true;
+}
+
 /// \brief Walks the slices of an alloca and form partitions based on them,
 /// rewriting each of their uses.
 bool SROA::splitAlloca(AllocaInst &AI, AllocaSlices &AS) {
@@ -4071,6 +4105,11 @@ bool SROA::splitAlloca(AllocaInst &AI, AllocaSlices &AS) {
   if (!IsSorted)
     std::sort(AS.begin(), AS.end());
 
+  if (SROAMaxAllocaSlices && tooManySlicesToSplit(AS)) {
+    ++NumAllocasTooManySlices;
+    return Changed;
+  }
+
   /// Describes the allocas introduced by rewritePartition in order to migrate
   /// the debug info.
   struct Fragment {
@@ -15,6 +15,7 @@
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/CFG.h"
+#include "llvm/Analysis/DomTreeUpdater.h"
 #include "llvm/Analysis/LoopInfo.h"
 #include "llvm/Analysis/MemoryDependenceAnalysis.h"
 #include "llvm/IR/Constant.h"
@@ -31,16 +32,29 @@
 #include <algorithm>
 using namespace llvm;
 
-void llvm::DeleteDeadBlock(BasicBlock *BB) {
+void llvm::DeleteDeadBlock(BasicBlock *BB, DomTreeUpdater *DTU) {
   assert((pred_begin(BB) == pred_end(BB) ||
          // Can delete self loop.
          BB->getSinglePredecessor() == BB) && "Block is not dead!");
   TerminatorInst *BBTerm = BB->getTerminator();
+  SmallVector<DominatorTree::UpdateType, 4> Updates;
 
   // Loop through all of our successors and make sure they know that one
   // of their predecessors is going away.
-  for (BasicBlock *Succ : BBTerm->successors())
+  for (BasicBlock *Succ : BBTerm->successors()) {
     Succ->removePredecessor(BB);
+    if (DTU)
+      Updates.push_back({DominatorTree::Delete, BB, Succ});
+  }
+
+  if (DTU) {
+    // The updater empties the block itself, once it has no successors.
+    BBTerm->eraseFromParent();
+    new UnreachableInst(BB->getContext(), BB);
+    DTU->applyUpdates(Updates);
+    DTU->deleteBB(BB);
+    return;
+  }
 
   // Zap all the instructions in the block.
   while (!BB->empty()) {
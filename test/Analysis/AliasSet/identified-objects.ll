@@ -0,0 +1,32 @@
+; Pointers based on different identified objects are kept in different alias
+; sets from their summaries alone, without alias analysis telling them apart.
+; RUN: opt -disable-basicaa -print-alias-sets -S -o - < %s 2>&1 | FileCheck %s
+
+; CHECK-LABEL: Alias sets for function 'distinct':
+; CHECK: AliasSet[{{.*}}, 2] may alias, Mod Pointers: (i32* %a, 4), (i32* %a1, 4)
+; CHECK: AliasSet[{{.*}}, 1] must alias, Mod Pointers: (i32* %b, 4)
+; CHECK: AliasSet[{{.*}}, 1] must alias, Mod Pointers: (i32* @g, 4)
+define void @distinct(i32 %k) {
+  %a = alloca i32, i32 2
+  %b = alloca i32
+  store i32 1, i32* %a
+  %a1 = getelementptr i32, i32* %a, i32 %k
+  store i32 2, i32* %a1
+  store i32 3, i32* %b
+  store i32 4, i32* @g
+  ret void
+}
+
+; A pointer not based on an identified object may alias any set.
+; CHECK-LABEL: Alias sets for function 'unknown':
+; CHECK: AliasSet[{{.*}}, 3] may alias, Mod Pointers: (i32* %a, 4), (i32* %p, 4), (i32* %b, 4)
+define void @unknown(i32* %p) {
+  %a = alloca i32
+  %b = alloca i32
+  store i32 1, i32* %a
+  store i32 2, i32* %p
+  store i32 3, i32* %b
+  ret void
+}
+
+@g = global i32 0
@@ -1,5 +1,6 @@
 ; RUN: opt -basicaa -print-alias-sets -alias-set-saturation-threshold=2 -S -o - < %s 2>&1 | FileCheck %s --check-prefix=CHECK --check-prefix=NOSAT
-; RUN: opt -basicaa -print-alias-sets -alias-set-saturation-threshold=1 -S -o - < %s 2>&1 | FileCheck %s --check-prefix=CHECK --check-prefix=SAT
+; RUN: opt -basicaa -print-alias-sets -alias-set-saturation-threshold=1 -alias-set-saturate-by-object=false -S -o - < %s 2>&1 | FileCheck %s --check-prefix=CHECK --check-prefix=SAT
+; RUN: opt -basicaa -print-alias-sets -alias-set-saturation-threshold=1 -S -o - < %s 2>&1 | FileCheck %s --check-prefix=CHECK --check-prefix=OBJ
 
 ; CHECK-LABEL: 'allmust'
 ; CHECK: AliasSet[{{.*}}, 1] must alias, Mod Pointers: (i32* %a, 4)
@@ -24,6 +25,8 @@ define void @allmust() {
 ; SAT: AliasSet[{{.*}}, 2] may alias, Mod forwarding to 0x[[FWD:[0-9a-f]*]]
 ; SAT: AliasSet[{{.*}}, 1] must alias, Mod forwarding to 0x[[FWD]]
 ; SAT: AliasSet[0x[[FWD]], 2] may alias, Mod/Ref Pointers: (i32* %a, 4), (i32* %a1, 4), (i32* %b, 4)
+; OBJ: AliasSet[{{.*}}, 2] may alias, Mod Pointers: (i32* %a, 4), (i32* %a1, 4)
+; OBJ: AliasSet[{{.*}}, 1] must alias, Mod Pointers: (i32* %b, 4)
 define void @mergemay(i32 %k) {
   %a = alloca i32
   %b = alloca i32
@@ -42,6 +45,10 @@ define void @mergemay(i32 %k) {
 ; SAT: AliasSet[{{.*}}, 1] must alias, Mod forwarding to 0x[[FWD]]
 ; SAT: AliasSet[{{.*}}, 2] may alias,  Mod forwarding to 0x[[FWD]]
 ; SAT: AliasSet[0x[[FWD]], 3] may alias, Mod/Ref Pointers: (i32* %a, 4), (i32* %b, 4), (i32* %c, 4), (i32* %d, 4)
+; OBJ: AliasSet[{{.*}}, 1] must alias, Mod forwarding to 0x[[FWD:[0-9a-f]*]]
+; OBJ: AliasSet[{{.*}}, 1] must alias, Mod forwarding to 0x[[FWD]]
+; OBJ: AliasSet[{{.*}}, 2] may alias,  Mod forwarding to 0x[[FWD]]
+; OBJ: AliasSet[0x[[FWD]], 3] may alias, Mod/Ref Pointers: (i32* %a, 4), (i32* %b, 4), (i32* %c, 4), (i32* %d, 4)
 define void @mergemust(i32* %c, i32* %d) {
   %a = alloca i32
   %b = alloca i32
@@ -51,3 +58,38 @@ define void @mergemust(i32* %c, i32* %d) {
   store i32 4, i32* %d
   ret void
 }
+
+; Once saturated by object, pointers join the set of their object and an
+; unknown instruction lumps everything together.
+; CHECK-LABEL: 'byobject'
+; NOSAT: AliasSet[{{.*}}, 2] may alias, Mod Pointers: (i32* %a, 4), (i32* %a1, 4)
+; NOSAT: AliasSet[{{.*}}, 2] may alias, Mod Pointers: (i32* %b, 4), (i32* %b1, 4)
+; OBJ: AliasSet[{{.*}}, 2] may alias, Mod Pointers: (i32* %a, 4), (i32* %a1, 4)
+; OBJ: AliasSet[{{.*}}, 2] may alias, Mod Pointers: (i32* %b, 4), (i32* %b1, 4)
+; OBJ-LABEL: 'byobjectunknown'
+; OBJ: AliasSet[{{.*}}, 3] may alias, Mod/Ref Pointers: (i32* %a, 4), (i32* %a1, 4), (i32* %b, 4)
+; OBJ-NEXT: 1 Unknown instructions:
+define void @byobject(i32 %k) {
+  %a = alloca i32
+  %b = alloca i32
+  store i32 1, i32* %a
+  %a1 = getelementptr i32, i32 *%a, i32 %k
+  store i32 2, i32* %a1
+  store i32 3, i32* %b
+  %b1 = getelementptr i32, i32 *%b, i32 %k
+  store i32 4, i32* %b1
+  ret void
+}
+
+declare void @f()
+
+define void @byobjectunknown(i32 %k) {
+  %a = alloca i32
+  %b = alloca i32
+  store i32 1, i32* %a
+  %a1 = getelementptr i32, i32 *%a, i32 %k
+  store i32 2, i32* %a1
+  store i32 3, i32* %b
+  call void @f()
+  ret void
+}
@@ -0,0 +1,74 @@
+; RUN: opt -disable-output -passes='print<captures>' < %s 2>&1 | FileCheck %s
+; RUN: opt -disable-output -aa-pipeline=basic-aa -passes=aa-eval \
+; RUN:     -print-all-alias-modref-info \
+; RUN:     < %s 2>&1 | FileCheck %s --check-prefix=NOCI
+; RUN: opt -disable-output -aa-pipeline=basic-aa \
+; RUN:     -passes='require<captures>,aa-eval' \
+; RUN:     -print-all-alias-modref-info < %s 2>&1 | FileCheck %s --check-prefix=CI
+
+@g = global i8* null
+
+declare void @use(i8*)
+declare void @nocap(i8* nocapture)
+
+; CHECK-LABEL: Capture info for function 'f':
+; CHECK-NEXT: %arg: not captured
+; CHECK-NEXT: %a: not captured
+; CHECK-NEXT: %b: captured, earliest: br i1 %c, label %left, label %right
+; CHECK-NEXT: %r: captured by returns only, earliest: ret i8* %r
+define i8* @f(i1 %c, i8* noalias %arg) {
+entry:
+  %a = alloca i8
+  %b = alloca i8
+  %r = alloca i8
+  call void @nocap(i8* %a)
+  call void @nocap(i8* %arg)
+  br i1 %c, label %left, label %right
+
+left:
+  store i8* %b, i8** @g
+  br label %exit
+
+right:
+  call void @use(i8* %b)
+  br label %exit
+
+exit:
+  ret i8* %r
+}
+
+; An alloca with more uses than capture tracking looks at without a cache.
+; NOCI-LABEL: Function: many_uses
+; NOCI: MayAlias: i8* %a.many, i8* %p
+; CI-LABEL: Function: many_uses
+; CI: NoAlias: i8* %a.many, i8* %p
+define void @many_uses(i8** %pp) {
+  %a.many = alloca i8
+  %p = load i8*, i8** %pp
+  store i8 0, i8* %p
+  %v0 = load i8, i8* %a.many
+  %v1 = load i8, i8* %a.many
+  %v2 = load i8, i8* %a.many
+  %v3 = load i8, i8* %a.many
+  %v4 = load i8, i8* %a.many
+  %v5 = load i8, i8* %a.many
+  %v6 = load i8, i8* %a.many
+  %v7 = load i8, i8* %a.many
+  %v8 = load i8, i8* %a.many
+  %v9 = load i8, i8* %a.many
+  %v10 = load i8, i8* %a.many
+  %v11 = load i8, i8* %a.many
+  %v12 = load i8, i8* %a.many
+  %v13 = load i8, i8* %a.many
+  %v14 = load i8, i8* %a.many
+  %v15 = load i8, i8* %a.many
+  %v16 = load i8, i8* %a.many
+  %v17 = load i8, i8* %a.many
+  %v18 = load i8, i8* %a.many
+  %v19 = load i8, i8* %a.many
+  %v20 = load i8, i8* %a.many
+  %v21 = load i8, i8* %a.many
+  %v22 = load i8, i8* %a.many
+  %v23 = load i8, i8* %a.many
+  ret void
+}
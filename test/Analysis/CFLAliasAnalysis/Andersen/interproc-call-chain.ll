@@ -0,0 +1,47 @@
+; This testcase ensures that CFL AA builds the summaries of callees before
+; their callers, through call chains and recursion, once per function, and
+; that building them on several threads gives the same results.
+
+; RUN: opt < %s -disable-basicaa -cfl-anders-aa -aa-eval -print-all-alias-modref-info -disable-output 2>&1 | FileCheck %s
+; RUN: opt < %s -aa-pipeline=cfl-anders-aa -passes=aa-eval -print-all-alias-modref-info -disable-output 2>&1 | FileCheck %s
+; RUN: opt < %s -disable-basicaa -cfl-anders-aa -cfl-summary-threads=4 -aa-eval -print-all-alias-modref-info -disable-output 2>&1 | FileCheck %s
+; RUN: opt < %s -disable-basicaa -cfl-anders-aa -aa-eval -stats -disable-output 2>&1 | FileCheck %s --check-prefix=STATS
+; RUN: opt < %s -disable-basicaa -cfl-anders-aa -cfl-summary-threads=4 -aa-eval -stats -disable-output 2>&1 | FileCheck %s --check-prefix=STATS
+; REQUIRES: asserts
+
+; STATS: 4 cfl-anders-aa - Number of functions analyzed
+
+define i32* @return_arg_callee(i32* %arg1, i32* %arg2) {
+  ret i32* %arg1
+}
+
+define i32* @forward_callee(i32* %arg1, i32* %arg2) {
+  %ret = call i32* @return_arg_callee(i32* %arg1, i32* %arg2)
+  ret i32* %ret
+}
+
+define i32* @recursive_callee(i32* %arg1, i32* %arg2, i1 %c) {
+entry:
+  br i1 %c, label %recurse, label %exit
+
+recurse:
+  %r = call i32* @recursive_callee(i32* %arg2, i32* %arg1, i1 false)
+  br label %exit
+
+exit:
+  %ret = phi i32* [ %arg1, %entry ], [ %r, %recurse ]
+  ret i32* %ret
+}
+
+; CHECK-LABEL: Function: test_call_chain
+; CHECK: NoAlias: i32* %a, i32* %b
+; CHECK: MayAlias: i32* %a, i32* %c
+; CHECK: NoAlias: i32* %b, i32* %c
+define void @test_call_chain() {
+  %a = alloca i32, align 4
+  %b = alloca i32, align 4
+
+  %c = call i32* @forward_callee(i32* %a, i32* %b)
+
+  ret void
+}
@@ -0,0 +1,49 @@
+; RUN: opt < %s -analyze -basicaa -da -da-delinearize -stats 2>&1 | FileCheck %s
+; REQUIRES: asserts
+
+; The delinearization of each access is computed once, and reused for all the
+; pairs it is tested in.
+
+; void f(long n, long m, float *A) {
+;   for (long i = 0; i < n; i++)
+;     for (long j = 1; j < m; j++)
+;       A[i*m + j] = A[i*m + j - 1];
+; }
+
+; CHECK: da analyze - none!
+; CHECK: da analyze - consistent anti [0 -1]!
+; CHECK: da analyze - none!
+; CHECK: 4 da - Delinearizations reused
+
+define void @f(i64 %n, i64 %m, float* %A) {
+entry:
+  %cmp.i = icmp sgt i64 %n, 0
+  %cmp.j = icmp sgt i64 %m, 1
+  %guard = and i1 %cmp.i, %cmp.j
+  br i1 %guard, label %for.i, label %exit
+
+for.i:
+  %i = phi i64 [ 0, %entry ], [ %i.inc, %for.i.latch ]
+  %row = mul nsw i64 %i, %m
+  br label %for.j
+
+for.j:
+  %j = phi i64 [ 1, %for.i ], [ %j.inc, %for.j ]
+  %idx = add nsw i64 %row, %j
+  %idx.prev = add nsw i64 %idx, -1
+  %src = getelementptr inbounds float, float* %A, i64 %idx.prev
+  %v = load float, float* %src, align 4
+  %dst = getelementptr inbounds float, float* %A, i64 %idx
+  store float %v, float* %dst, align 4
+  %j.inc = add nsw i64 %j, 1
+  %cmp = icmp slt i64 %j.inc, %m
+  br i1 %cmp, label %for.j, label %for.i.latch
+
+for.i.latch:
+  %i.inc = add nsw i64 %i, 1
+  %cmp2 = icmp slt i64 %i.inc, %n
+  br i1 %cmp2, label %for.i, label %exit
+
+exit:
+  ret void
+}
@@ -0,0 +1,40 @@
+; Check that a bounded LazyValueInfo cache evicts entries without changing
+; the results.
+; REQUIRES: asserts
+; RUN: opt -S -correlated-propagation < %s -o %t.ref.ll
+; RUN: opt -S -correlated-propagation -lvi-cache-max-entries=4 -stats < %s \
+; RUN:     -o %t.bounded.ll 2>&1 | FileCheck %s
+; RUN: diff %t.ref.ll %t.bounded.ll
+
+; CHECK: lazy-value-info - Number of times the cache went over budget
+; CHECK: lazy-value-info - Number of values evicted from the cache
+
+define i32 @chain(i32 %a, i32 %b) {
+entry:
+  %c0 = icmp ult i32 %a, 10
+  br i1 %c0, label %bb1, label %exit
+
+bb1:
+  %c1 = icmp ult i32 %b, 20
+  br i1 %c1, label %bb2, label %exit
+
+bb2:
+  %s = add i32 %a, %b
+  %c2 = icmp ult i32 %a, 10
+  br i1 %c2, label %bb3, label %exit
+
+bb3:
+  %c3 = icmp ult i32 %b, 20
+  br i1 %c3, label %bb4, label %exit
+
+bb4:
+  %c4 = icmp ult i32 %s, 30
+  %r = select i1 %c4, i32 %a, i32 %b
+  br label %exit
+
+exit:
+  %p = phi i32 [ 0, %entry ], [ 1, %bb1 ], [ 2, %bb2 ], [ 3, %bb3 ], [ %r, %bb4 ]
+  %c5 = icmp ult i32 %p, 100
+  %z = zext i1 %c5 to i32
+  ret i32 %z
+}
@@ -0,0 +1,29 @@
+; RUN: opt -disable-output -passes='print<scalar-evolution>' -stats < %s 2>&1 \
+; RUN:     | FileCheck %s
+; REQUIRES: asserts
+
+; The printer asks again for the expressions and counts computed along the
+; way, so every kind of query is answered from the caches at least once.
+
+; CHECK-DAG: {{[0-9]+}} scalar-evolution - Number of backedge-taken count queries answered by the cache
+; CHECK-DAG: {{[0-9]+}} scalar-evolution - Number of backedge-taken count queries which computed the count
+; CHECK-DAG: {{[0-9]+}} scalar-evolution - Number of getSCEV queries answered by the cache
+; CHECK-DAG: {{[0-9]+}} scalar-evolution - Number of getSCEV queries which created an expression
+; CHECK-DAG: {{[0-9]+}} scalar-evolution - Number of range queries answered by the cache
+; CHECK-DAG: {{[0-9]+}} scalar-evolution - Number of range queries which computed the range
+
+define void @f(i32* %p, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %gep = getelementptr i32, i32* %p, i32 %i
+  store i32 %i, i32* %gep
+  %i.next = add nuw nsw i32 %i, 1
+  %cmp = icmp slt i32 %i.next, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret void
+}
@@ -0,0 +1,15 @@
+; RUN: opt -disable-output -passes='print<known-bits>' < %s 2>&1 | FileCheck %s
+
+; CHECK-LABEL: Known bits for function 'masks':
+; CHECK-NEXT: %x: Zero=0xFFFFFFF0 One=0x0 SignBits=28 NonZero=0
+; CHECK-NEXT: %y: Zero=0xFFFFFF0F One=0x0 SignBits=24 NonZero=0
+; CHECK-NEXT: %z: Zero=0xFFFFFF0E One=0x1 SignBits=24 NonZero=1
+; CHECK-NEXT: %s: Zero=0xFFFFFFFFFFFFFF0E One=0x1 SignBits=56 NonZero=1
+define i32 @masks(i32 %a) {
+  %x = and i32 %a, 15
+  %y = shl i32 %x, 4
+  %z = or i32 %y, 1
+  %s = sext i32 %z to i64
+  ret i32 %z
+}
+
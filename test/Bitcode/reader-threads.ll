@@ -0,0 +1,34 @@
+; Decoding the function bodies on several threads must not change the module.
+; RUN: llvm-as < %S/compatibility.ll > %t.bc
+; RUN: llvm-dis < %t.bc > %t.serial.ll
+; RUN: llvm-dis -bitcode-reader-threads=2 < %t.bc > %t.parallel.ll
+; RUN: diff %t.serial.ll %t.parallel.ll
+
+; RUN: llvm-as -preserve-bc-uselistorder < %s > %t.uselist.bc
+; RUN: llvm-dis -bitcode-reader-threads=2 < %t.uselist.bc | FileCheck %s
+
+; The body of @fwd is parsed early, when @user forward references its block.
+; CHECK: define i8* @user()
+; CHECK-NEXT: ret i8* blockaddress(@fwd, %bb)
+; CHECK: define void @fwd()
+; CHECK: bb:
+; CHECK: define i32 @uselist(i32 %x)
+; CHECK-NEXT: %a = add i32 %x, 1
+; CHECK-NEXT: %b = mul i32 %a, %x
+
+define i8* @user() {
+  ret i8* blockaddress(@fwd, %bb)
+}
+
+define void @fwd() {
+  br label %bb
+bb:
+  ret void
+}
+
+define i32 @uselist(i32 %x) {
+  %a = add i32 %x, 1
+  %b = mul i32 %a, %x
+  %c = sub i32 %b, %x
+  ret i32 %c
+}
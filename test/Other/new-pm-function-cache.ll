@@ -0,0 +1,99 @@
+; Check that -function-cache-dir reuses the result of earlier runs of the same
+; function pipeline and produces the same module as running the pipeline.
+; REQUIRES: asserts
+; RUN: rm -rf %t.cache
+; RUN: opt -S -passes='function(instcombine,simplify-cfg)' %s -o %t.ref.ll
+; RUN: opt -S -passes='function(instcombine,simplify-cfg)' -stats \
+; RUN:     -function-cache-dir=%t.cache %s -o %t.cold.ll 2>&1 \
+; RUN:     | FileCheck %s --check-prefix=COLD
+; RUN: opt -S -passes='function(instcombine,simplify-cfg)' -stats \
+; RUN:     -function-cache-dir=%t.cache %s -o %t.warm.ll 2>&1 \
+; RUN:     | FileCheck %s --check-prefix=WARM
+; RUN: diff %t.ref.ll %t.cold.ll
+; RUN: diff %t.ref.ll %t.warm.ll
+;
+; A different pipeline does not reuse the entries.
+; RUN: opt -S -passes='function(instcombine)' -stats \
+; RUN:     -function-cache-dir=%t.cache %s -o /dev/null 2>&1 \
+; RUN:     | FileCheck %s --check-prefix=COLD
+;
+; RUN: not opt -S -passes='cgscc(function-attrs)' -function-cache-dir=%t.cache \
+; RUN:     %s -o /dev/null 2>&1 | FileCheck %s --check-prefix=ERR
+
+; COLD-NOT: function-cache - Number of functions read
+; COLD: 3 function-cache - Number of functions added to the function cache
+; COLD: 1 function-cache - Number of functions which cannot be cached
+
+; WARM: 3 function-cache - Number of functions read from the function cache
+; WARM-NOT: function-cache - Number of functions added
+; WARM: 1 function-cache - Number of functions which cannot be cached
+
+; ERR: -function-cache-dir requires a function pass pipeline
+
+%struct.pair = type { i32, i32 }
+
+@counter = internal global i32 0
+
+declare i32 @external(%struct.pair*)
+
+define i32 @sum(%struct.pair* %p) {
+entry:
+  %a.addr = getelementptr %struct.pair, %struct.pair* %p, i32 0, i32 0
+  %b.addr = getelementptr %struct.pair, %struct.pair* %p, i32 0, i32 1
+  %a = load i32, i32* %a.addr, !tbaa !0
+  %b = load i32, i32* %b.addr, !tbaa !0
+  %s = add i32 %a, %b
+  %t = add i32 %s, 0
+  ret i32 %t
+}
+
+define i32 @count(%struct.pair* %p) {
+entry:
+  %c = load i32, i32* @counter
+  %c1 = add i32 %c, 1
+  store i32 %c1, i32* @counter
+  %cmp = icmp eq %struct.pair* %p, null
+  br i1 %cmp, label %exit, label %call
+
+call:
+  %r = call i32 @external(%struct.pair* %p)
+  br label %exit
+
+exit:
+  %res = phi i32 [ %r, %call ], [ 0, %entry ]
+  ret i32 %res
+}
+
+define i32 @fact(i32 %n) {
+entry:
+  %cmp = icmp ult i32 %n, 2
+  br i1 %cmp, label %done, label %rec
+
+rec:
+  %m = sub i32 %n, 1
+  %f = call i32 @fact(i32 %m)
+  %r = mul i32 %f, %n
+  ret i32 %r
+
+done:
+  ret i32 1
+}
+
+define i32 @with_debug_info(i32 %x) !dbg !5 {
+  %y = xor i32 %x, 0, !dbg !8
+  ret i32 %y, !dbg !8
+}
+
+!llvm.dbg.cu = !{!3}
+!llvm.module.flags = !{!10}
+
+!0 = !{!1, !1, i64 0}
+!1 = !{!"int", !2, i64 0}
+!2 = !{!"tbaa root"}
+!3 = distinct !DICompileUnit(language: DW_LANG_C99, file: !4, emissionKind: FullDebug)
+!4 = !DIFile(filename: "t.c", directory: "/")
+!5 = distinct !DISubprogram(name: "with_debug_info", scope: !4, file: !4, line: 1, type: !6, isLocal: false, isDefinition: true, unit: !3)
+!6 = !DISubroutineType(types: !7)
+!7 = !{}
+!8 = !DILocation(line: 1, scope: !5)
+!10 = !{i32 2, !"Debug Info Version", i32 3}
@@ -0,0 +1,165 @@
+; Check that running a function pipeline over module partitions in parallel
+; produces the same module as running it sequentially.
+;
+; RUN: opt -disable-output -debug-pass-manager -function-pipeline-threads=3 \
+; RUN:     -passes='function(instcombine)' %s 2>&1 \
+; RUN:     | FileCheck %s --check-prefix=CHECK-PM
+; RUN: opt -S -passes='function(instcombine)' %s | FileCheck %s
+; RUN: opt -S -function-pipeline-threads=3 -passes='function(instcombine)' %s \
+; RUN:     | FileCheck %s
+; RUN: opt -S -function-pipeline-threads=2 -passes='instcombine,simplify-cfg' %s \
+; RUN:     | FileCheck %s --check-prefix=CHECK-SIMPLIFY
+; RUN: not opt -S -function-pipeline-threads=2 -passes='globaldce' %s 2>&1 \
+; RUN:     | FileCheck %s --check-prefix=CHECK-ERR
+
+; CHECK-PM: Running pass: {{.*}}ParallelFunctionPipelinePass
+; CHECK-ERR: -function-pipeline-threads requires a function pass pipeline
+
+; CHECK: module asm "nop"
+; CHECK: @llvm.global_ctors = appending global [1 x { i32, void ()*, i8* }] [{ i32, void ()*, i8* } { i32 65535, void ()* @ctor, i8* null }]
+; CHECK: @counter = internal global i32 0
+; CHECK: @str = private unnamed_addr constant [4 x i8] c"abc\00"
+; CHECK: @g = global i32 1
+; CHECK: @k0 = internal constant i32 10
+; CHECK: @k1 = internal constant i32 11
+; CHECK: @k2 = internal constant i32 12
+; CHECK: @k3 = internal constant i32 13
+; CHECK: @k4 = internal constant i32 14
+; CHECK: @k5 = internal constant i32 15
+; CHECK: @ktab = internal constant i32* @k1
+; CHECK: @a = alias i32, i32* @g
+
+module asm "nop"
+
+@llvm.global_ctors = appending global [1 x { i32, void ()*, i8* }] [{ i32, void ()*, i8* } { i32 65535, void ()* @ctor, i8* null }]
+@counter = internal global i32 0
+@str = private unnamed_addr constant [4 x i8] c"abc\00"
+@g = global i32 1
+@a = alias i32, i32* @g
+@k0 = internal constant i32 10
+@k1 = internal constant i32 11
+@k2 = internal constant i32 12
+@k3 = internal constant i32 13
+@k4 = internal constant i32 14
+@k5 = internal constant i32 15
+@ktab = internal constant i32* @k1
+
+; CHECK-LABEL: define internal void @ctor()
+; CHECK-NEXT: store i32 1, i32* @counter
+define internal void @ctor() {
+  store i32 1, i32* @counter
+  ret void
+}
+
+; CHECK-LABEL: define internal i32 @helper(i32 %x)
+; CHECK-NEXT: %r = shl i32 %x, 1
+define internal i32 @helper(i32 %x) {
+  %r = mul i32 %x, 2
+  ret i32 %r
+}
+
+; CHECK-LABEL: define i32 @f1(i32 %x)
+; CHECK-NEXT: %c = call i32 @helper(i32 %x)
+; CHECK-NEXT: ret i32 %c
+define i32 @f1(i32 %x) {
+  %y = add i32 %x, 0
+  %c = call i32 @helper(i32 %y)
+  ret i32 %c
+}
+
+; CHECK-LABEL: define i8* @f2()
+; CHECK-NEXT: ret i8* getelementptr inbounds ([4 x i8], [4 x i8]* @str, i64 0, i64 0)
+define i8* @f2() {
+  %p = getelementptr [4 x i8], [4 x i8]* @str, i64 0, i64 0
+  ret i8* %p
+}
+
+; CHECK-LABEL: define linkonce_odr i32 @f3(i32 %x)
+; CHECK-NEXT: ret i32 %x
+define linkonce_odr i32 @f3(i32 %x) {
+  %y = xor i32 %x, 0
+  ret i32 %y
+}
+
+; CHECK-LABEL: define i32 @f4()
+; CHECK-NEXT: %v = load i32, i32* @counter
+; CHECK-NEXT: %w = load i32, i32* @a
+; CHECK-NEXT: %s = add i32 %v, %w
+define i32 @f4() {
+  %v = load i32, i32* @counter
+  %w = load i32, i32* @a
+  %s = add i32 %v, %w
+  ret i32 %s
+}
+
+; CHECK-SIMPLIFY-LABEL: define i32 @f5(i1 %c)
+; CHECK-SIMPLIFY-NEXT: entry:
+; CHECK-SIMPLIFY-NEXT: ret i32 0
+define i32 @f5(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+a:
+  br label %b
+b:
+  ret i32 0
+}
+
+; Constants placed in another partition are still folded.
+; CHECK-LABEL: define i32 @load0()
+; CHECK-NEXT: ret i32 10
+define i32 @load0() {
+  %v = load i32, i32* @k0
+  ret i32 %v
+}
+
+; CHECK-LABEL: define i32 @load1()
+; CHECK-NEXT: ret i32 11
+define i32 @load1() {
+  %v = load i32, i32* @k1
+  ret i32 %v
+}
+
+; CHECK-LABEL: define i32 @load2()
+; CHECK-NEXT: ret i32 12
+define i32 @load2() {
+  %v = load i32, i32* @k2
+  ret i32 %v
+}
+
+; CHECK-LABEL: define i32 @load3()
+; CHECK-NEXT: ret i32 13
+define i32 @load3() {
+  %v = load i32, i32* @k3
+  ret i32 %v
+}
+
+; CHECK-LABEL: define i32 @load4()
+; CHECK-NEXT: ret i32 14
+define i32 @load4() {
+  %v = load i32, i32* @k4
+  ret i32 %v
+}
+
+; CHECK-LABEL: define i32 @load5()
+; CHECK-NEXT: ret i32 15
+define i32 @load5() {
+  %v = load i32, i32* @k5
+  ret i32 %v
+}
+
+; So are the constants their initializers refer to.
+; CHECK-LABEL: define i32 @load_indirect()
+; CHECK-NEXT: ret i32 11
+define i32 @load_indirect() {
+  %p = load i32*, i32** @ktab
+  %v = load i32, i32* %p
+  ret i32 %v
+}
+
+declare void @ext()
+
+; CHECK: declare void @ext()
+; CHECK: !llvm.ident = !{!0}
+; CHECK: !0 = !{!"clang"}
+!llvm.ident = !{!0}
+!0 = !{!"clang"}
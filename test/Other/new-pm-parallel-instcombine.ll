@@ -0,0 +1,109 @@
+; Check that InstCombine run over module partitions in parallel produces
+; exactly the module it produces sequentially, including the folds which need
+; the initializers of constants placed in other partitions.
+;
+; RUN: opt -S -passes=instcombine %s -o %t.seq
+; RUN: FileCheck %s < %t.seq
+; RUN: opt -S -function-pipeline-threads=2 -passes=instcombine %s -o %t.par2
+; RUN: diff %t.seq %t.par2
+; RUN: opt -S -function-pipeline-threads=3 -passes=instcombine %s -o %t.par3
+; RUN: diff %t.seq %t.par3
+; RUN: opt -S -function-pipeline-threads=4 -passes=instcombine %s -o %t.par4
+; RUN: diff %t.seq %t.par4
+; RUN: opt -S -function-pipeline-threads=8 -passes=instcombine %s -o %t.par8
+; RUN: diff %t.seq %t.par8
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+@str = private unnamed_addr constant [6 x i8] c"hello\00"
+@fmt = private unnamed_addr constant [7 x i8] c"hello\0A\00"
+@tab = internal constant [4 x i32] [i32 1, i32 2, i32 4, i32 8]
+@ptrs = internal constant [2 x i32*] [i32* getelementptr inbounds ([4 x i32], [4 x i32]* @tab, i64 0, i64 1), i32* getelementptr inbounds ([4 x i32], [4 x i32]* @tab, i64 0, i64 3)]
+@k = internal constant i32 7
+@counter = global i32 0
+
+declare i64 @strlen(i8*)
+declare i32 @printf(i8*, ...)
+declare void @llvm.memcpy.p0i8.p0i8.i64(i8*, i8*, i64, i32, i1)
+
+; CHECK-LABEL: define i64 @len(
+; CHECK-NEXT: ret i64 5
+define i64 @len() {
+  %n = call i64 @strlen(i8* getelementptr inbounds ([6 x i8], [6 x i8]* @str, i64 0, i64 0))
+  ret i64 %n
+}
+
+; CHECK-LABEL: define void @greet(
+; CHECK-NEXT: %puts = call i32 @puts(
+define void @greet() {
+  %r = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([7 x i8], [7 x i8]* @fmt, i64 0, i64 0))
+  ret void
+}
+
+; CHECK-LABEL: define i32 @elt2(
+; CHECK-NEXT: ret i32 4
+define i32 @elt2() {
+  %p = getelementptr [4 x i32], [4 x i32]* @tab, i64 0, i64 2
+  %v = load i32, i32* %p
+  ret i32 %v
+}
+
+; CHECK-LABEL: define i32 @indirect(
+; CHECK-NEXT: ret i32 8
+define i32 @indirect() {
+  %pp = getelementptr [2 x i32*], [2 x i32*]* @ptrs, i64 0, i64 1
+  %p = load i32*, i32** %pp
+  %v = load i32, i32* %p
+  ret i32 %v
+}
+
+; CHECK-LABEL: define i32 @copy(
+; CHECK-NEXT: ret i32 8
+define i32 @copy() {
+  %a = alloca [4 x i32]
+  %d = bitcast [4 x i32]* %a to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %d, i8* bitcast ([4 x i32]* @tab to i8*), i64 16, i32 4, i1 false)
+  %p = getelementptr [4 x i32], [4 x i32]* %a, i64 0, i64 3
+  %v = load i32, i32* %p
+  ret i32 %v
+}
+
+define internal i32 @twice(i32 %x) {
+  %r = mul i32 %x, 2
+  ret i32 %r
+}
+
+; CHECK-LABEL: define i32 @caller(
+; CHECK-NEXT: %r = call i32 @twice(i32 %x)
+define i32 @caller(i32 %x) {
+  %k = load i32, i32* @k
+  %y = add i32 %x, %k
+  %z = sub i32 %y, %k
+  %r = call i32 @twice(i32 %z)
+  ret i32 %r
+}
+
+; CHECK-LABEL: define i1 @cmp(
+; CHECK-NEXT: ret i1 false
+define i1 @cmp(i32 %x) {
+  %a = and i32 %x, 12
+  %b = or i32 %a, 1
+  %c = icmp eq i32 %b, 0
+  ret i1 %c
+}
+
+; CHECK-LABEL: define i32 @sel(
+; CHECK-NEXT: %r = add i32 %x, 7
+define i32 @sel(i1 %c, i32 %x) {
+  %k = load i32, i32* @k
+  %s = select i1 %c, i32 %k, i32 7
+  %r = add i32 %s, %x
+  ret i32 %r
+}
+
+define i32 @bump() {
+  %v = load i32, i32* @counter
+  %w = add i32 %v, 1
+  store i32 %w, i32* @counter
+  ret i32 %w
+}
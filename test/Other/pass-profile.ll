@@ -0,0 +1,35 @@
+; RUN: opt < %s -o /dev/null -instsimplify -pass-profile-output=%t.json
+; RUN: FileCheck %s --check-prefix=LEGACY < %t.json
+; RUN: opt < %s -o /dev/null -passes=instsimplify -pass-profile-output=%t.json
+; RUN: FileCheck %s --check-prefix=NEWPM < %t.json
+; RUN: opt < %s -o /dev/null -instsimplify -pass-profile-output=%t.trace \
+; RUN:     -pass-profile-format=chrome-trace
+; RUN: FileCheck %s --check-prefix=TRACE < %t.trace
+
+; Analyses are function passes in the legacy pass manager, so they are profiled
+; as well.
+; LEGACY:      [
+; LEGACY:        {"pass": "Dominator Tree Construction", "function": "foo",
+; LEGACY:        {"pass": "Remove redundant instructions", "function": "foo", "start_us": {{[0-9]+}}, "wall_us": {{[0-9]+}}, "instructions_before": 2, "instructions_after": 1, "malloc_before": {{[0-9]+}}, "malloc_after": {{[0-9]+}}}
+; LEGACY:        {"pass": "Remove redundant instructions", "function": "bar", "start_us": {{[0-9]+}}, "wall_us": {{[0-9]+}}, "instructions_before": 1, "instructions_after": 1,
+; LEGACY:      ]
+
+; NEWPM:      [
+; NEWPM-NEXT:   {"pass": "InstSimplifierPass", "function": "foo", {{.*}} "instructions_before": 2, "instructions_after": 1,
+; NEWPM-NEXT:   {"pass": "InstSimplifierPass", "function": "bar", {{.*}} "instructions_before": 1, "instructions_after": 1,
+; NEWPM-NEXT: ]
+
+; The events carry the id of the thread which ran the pass.
+; TRACE:      {"traceEvents": [
+; TRACE:        {"name": "Remove redundant instructions", "cat": "pass", "ph": "X", "pid": 1, "tid": [[TID:[0-9]+]], "ts": {{[0-9]+}}, "dur": {{[0-9]+}}, "args": {"function": "foo", "instructions_before": 2, "instructions_after": 1,
+; TRACE:        {"name": "Remove redundant instructions", {{.*}} "tid": [[TID]], {{.*}} "args": {"function": "bar",
+; TRACE:      ]}
+
+define i32 @foo() {
+  %res = add i32 5, 4
+  ret i32 %res
+}
+
+define void @bar() {
+  ret void
+}
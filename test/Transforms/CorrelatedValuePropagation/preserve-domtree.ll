@@ -0,0 +1,64 @@
+; Removing switch cases keeps the dominator tree up to date.
+; RUN: opt < %s -passes='require<domtree>,correlated-propagation,verify<domtree>' \
+; RUN:     -debug-pass-manager -S 2>&1 | FileCheck %s
+
+; CHECK: Running analysis: DominatorTreeAnalysis on dead_case
+; CHECK: Running pass: CorrelatedValuePropagationPass on dead_case
+; CHECK-NOT: Running analysis: DominatorTreeAnalysis
+; CHECK: Running pass: DominatorTreeVerifierPass on dead_case
+; CHECK: Running analysis: DominatorTreeAnalysis on folded_switch
+; CHECK: Running pass: CorrelatedValuePropagationPass on folded_switch
+; CHECK-NOT: Running analysis: DominatorTreeAnalysis
+; CHECK: Running pass: DominatorTreeVerifierPass on folded_switch
+
+; The switch is left with a single case, and becomes a conditional branch.
+; CHECK-LABEL: define i32 @dead_case(
+; CHECK: sw:
+; CHECK-NEXT: %cond = icmp eq i32 %x, 0
+; CHECK-NEXT: br i1 %cond, label %a, label %exit
+define i32 @dead_case(i32 %x) {
+entry:
+  %c = icmp ult i32 %x, 2
+  br i1 %c, label %sw, label %exit
+
+sw:
+  switch i32 %x, label %exit [
+    i32 0, label %a
+    i32 5, label %b
+  ]
+
+a:
+  br label %exit
+
+b:
+  br label %exit
+
+exit:
+  %r = phi i32 [ 0, %entry ], [ 1, %sw ], [ 2, %a ], [ 3, %b ]
+  ret i32 %r
+}
+
+; CHECK-LABEL: define i32 @folded_switch(
+; CHECK: sw:
+; CHECK-NEXT: br label %a
+define i32 @folded_switch(i32 %x) {
+entry:
+  %c = icmp eq i32 %x, 7
+  br i1 %c, label %sw, label %exit
+
+sw:
+  switch i32 %x, label %b [
+    i32 7, label %a
+    i32 8, label %b
+  ]
+
+a:
+  br label %exit
+
+b:
+  br label %exit
+
+exit:
+  %r = phi i32 [ 0, %entry ], [ 2, %a ], [ 3, %b ]
+  ret i32 %r
+}
@@ -0,0 +1,82 @@
+; RUN: opt -S -gvn -memdep-block-scan-limit=2 < %s \
+; RUN:     | FileCheck %s --check-prefix=MEMDEP-LIMIT
+; RUN: opt -S -gvn -enable-gvn-memoryssa -memdep-block-scan-limit=2 < %s \
+; RUN:     | FileCheck %s --check-prefix=MSSA-LIMIT
+; RUN: opt -S -gvn < %s | FileCheck %s
+; RUN: opt -S -gvn -enable-gvn-memoryssa < %s | FileCheck %s
+; RUN: opt -S -aa-pipeline=basic-aa -passes=gvn -enable-gvn-memoryssa < %s \
+; RUN:     | FileCheck %s
+
+; MemorySSA is not limited by the number of instructions between the load and
+; the store.
+; MEMDEP-LIMIT-LABEL: @scan_limit(
+; MEMDEP-LIMIT: %l = load i32, i32* %p
+; MEMDEP-LIMIT: ret i32 %l
+; MSSA-LIMIT-LABEL: @scan_limit(
+; MSSA-LIMIT-NOT: load
+; MSSA-LIMIT: ret i32 %v
+; CHECK-LABEL: @scan_limit(
+; CHECK-NOT: load
+; CHECK: ret i32 %v
+define i32 @scan_limit(i32* noalias %p, i32* noalias %q, i32 %v) {
+  store i32 %v, i32* %p
+  store i32 1, i32* %q
+  store i32 2, i32* %q
+  store i32 3, i32* %q
+  %l = load i32, i32* %p
+  ret i32 %l
+}
+
+; A load is fully redundant with a dominating load that sees the same memory,
+; in another block.
+; CHECK-LABEL: @load_load(
+; CHECK: %a = load i32, i32* %p
+; CHECK-NOT: load
+; CHECK: ret i32 %a
+define i32 @load_load(i32* %p, i1 %c) {
+entry:
+  %a = load i32, i32* %p
+  br i1 %c, label %then, label %exit
+
+then:
+  %b = load i32, i32* %p
+  ret i32 %b
+
+exit:
+  ret i32 %a
+}
+
+; A store between the loads, which may alias, keeps the second one.
+; CHECK-LABEL: @clobbered(
+; CHECK: %a = load i32, i32* %p
+; CHECK: store i32 0, i32* %q
+; CHECK: %b = load i32, i32* %p
+define i32 @clobbered(i32* %p, i32* %q) {
+  %a = load i32, i32* %p
+  store i32 0, i32* %q
+  %b = load i32, i32* %p
+  %s = add i32 %a, %b
+  ret i32 %s
+}
+
+; Loads which see different stores on different paths are left to load PRE.
+; CHECK-LABEL: @phi(
+; CHECK: exit:
+; CHECK-NEXT: [[L:%.*]] = phi i32 [ 1, %else ], [ 0, %then ]
+; CHECK-NEXT: ret i32 [[L]]
+define i32 @phi(i32* %p, i1 %c) {
+entry:
+  br i1 %c, label %then, label %else
+
+then:
+  store i32 0, i32* %p
+  br label %exit
+
+else:
+  store i32 1, i32* %p
+  br label %exit
+
+exit:
+  %l = load i32, i32* %p
+  ret i32 %l
+}
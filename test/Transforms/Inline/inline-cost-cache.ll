@@ -0,0 +1,168 @@
+; RUN: opt < %s -inline -stats -disable-output 2>&1 | FileCheck %s
+; RUN: opt < %s -passes='cgscc(inline)' -stats -disable-output 2>&1 | FileCheck %s
+; REQUIRES: asserts
+
+; Inlining @c1 or @c2 into @b would keep @b from being inlined into its
+; callers, so both are deferred. Deciding that needs the costs of the calls to
+; @b; @b does not change in between, so they are computed once.
+
+; CHECK: 4 inline - Number of caller-callers analyzed
+; CHECK: 2 inline - Number of inline costs reused
+
+@g = global i32 0
+
+define void @c1(i32 %x) {
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  ret void
+}
+
+define void @c2(i32 %x) {
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  ret void
+}
+
+define internal void @b(i32 %x) {
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  store volatile i32 %x, i32* @g, align 4
+  call void @c1(i32 %x)
+  call void @c2(i32 %x)
+  ret void
+}
+
+define void @main1(i32 %x) {
+  call void @b(i32 %x)
+  ret void
+}
+
+define void @main2(i32 %x) {
+  call void @b(i32 %x)
+  ret void
+}
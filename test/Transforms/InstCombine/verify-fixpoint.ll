@@ -0,0 +1,29 @@
+; RUN: opt < %s -instcombine -instcombine-verify-fixpoint -S -stats 2>&1 | FileCheck %s --check-prefixes=CHECK,VERIFY
+; RUN: opt < %s -instcombine -instcombine-single-iteration -S -stats 2>&1 | FileCheck %s --check-prefixes=CHECK,SINGLE
+; RUN: opt < %s -instcombine -instcombine-max-iterations=1 -S -stats 2>&1 | FileCheck %s --check-prefixes=CHECK,LIMIT
+; REQUIRES: asserts
+
+; A chain of folds reaches the fixpoint in one iteration in single iteration
+; mode: the second one, run to verify it, changes nothing. Without the mode,
+; a limit of one iteration stops InstCombine short of the fixpoint, with a
+; dead instruction left behind, and this is reported.
+
+; LIMIT: warning: {{.*}}instruction combining stopped after 1 iterations without reaching a fixpoint
+
+define i32 @chain(i32 %x) {
+; CHECK-LABEL: @chain(
+; LIMIT-NEXT:    [[A:%.*]] = add i32 %x, 1
+; CHECK-NEXT:    [[B:%.*]] = shl i32 %x, 2
+; CHECK-NEXT:    [[C:%.*]] = add i32 [[B]], 12
+; CHECK-NEXT:    ret i32 [[C]]
+;
+  %a = add i32 %x, 1
+  %b = add i32 %a, 2
+  %c = mul i32 %b, 4
+  ret i32 %c
+}
+
+; VERIFY: 2 instcombine - Number of instruction combining iterations performed
+; SINGLE: 1 instcombine - Number of instruction combining iterations performed
+; LIMIT-DAG: 1 instcombine - Number of functions stopped at the iteration limit
+; LIMIT-DAG: 1 instcombine - Number of instruction combining iterations performed
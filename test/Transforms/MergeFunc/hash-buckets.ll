@@ -0,0 +1,30 @@
+; REQUIRES: asserts
+; RUN: opt -mergefunc -stats -disable-output < %s 2>&1 | FileCheck %s
+; RUN: opt -mergefunc -mergefunc-parallel-hash -stats -disable-output < %s 2>&1 | FileCheck %s
+
+; Only the functions sharing a hash are compared: @g has a structure of its
+; own, and inserting @f2 next to @f1 compares them both ways.
+
+; CHECK: 2 mergefunc - Number of function comparisons
+; CHECK: 1 mergefunc - Number of functions merged
+; CHECK: 1 mergefunc - Number of functions with a unique hash
+
+define i32 @f1(i32 %x, i32 %y) {
+  %a = add i32 %x, %y
+  %b = mul i32 %a, %x
+  %c = sub i32 %b, %y
+  ret i32 %c
+}
+
+define i32 @f2(i32 %x, i32 %y) {
+  %a = add i32 %x, %y
+  %b = mul i32 %a, %x
+  %c = sub i32 %b, %y
+  ret i32 %c
+}
+
+define i32 @g(i32 %x, i32 %y) {
+  %a = xor i32 %x, %y
+  %b = xor i32 %a, %x
+  ret i32 %b
+}
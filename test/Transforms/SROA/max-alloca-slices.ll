@@ -0,0 +1,116 @@
+; RUN: opt < %s -sroa -S | FileCheck %s --check-prefixes=CHECK,TEST-SPLIT,MEMSET-SPLIT,UNEVEN-SPLIT
+; RUN: opt < %s -sroa -sroa-max-alloca-slices=6 -S | FileCheck %s --check-prefixes=CHECK,TEST-SPLIT,MEMSET-SPLIT,UNEVEN-SPLIT
+; RUN: opt < %s -sroa -sroa-max-alloca-slices=4 -S | FileCheck %s --check-prefixes=CHECK,TEST-SPLIT,MEMSET-BOUND,UNEVEN-BOUND
+; RUN: opt < %s -sroa -sroa-max-alloca-slices=3 -S | FileCheck %s --check-prefixes=CHECK,TEST-BOUND,MEMSET-BOUND,UNEVEN-BOUND
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:32:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-n8:16:32:64"
+
+declare void @llvm.memset.p0i8.i64(i8* nocapture, i8, i64, i32, i1)
+
+; The alloca has four slices in two partitions: two stores and two loads.
+
+define i32 @test(i32 %x, i32 %y) {
+; TEST-SPLIT-LABEL: @test(
+; TEST-SPLIT-NOT:     alloca
+; TEST-SPLIT:         [[S:%.*]] = add i32 %x, %y
+; TEST-SPLIT-NEXT:    ret i32 [[S]]
+;
+; TEST-BOUND-LABEL: @test(
+; TEST-BOUND:         alloca { i32, i32 }
+; TEST-BOUND:         store i32 %x
+; TEST-BOUND:         store i32 %y
+; TEST-BOUND:         load i32
+; TEST-BOUND:         load i32
+;
+entry:
+  %a = alloca { i32, i32 }
+  %p0 = getelementptr { i32, i32 }, { i32, i32 }* %a, i64 0, i32 0
+  %p1 = getelementptr { i32, i32 }, { i32, i32 }* %a, i64 0, i32 1
+  store i32 %x, i32* %p0
+  store i32 %y, i32* %p1
+  %v0 = load i32, i32* %p0
+  %v1 = load i32, i32* %p1
+  %s = add i32 %v0, %v1
+  ret i32 %s
+}
+
+; The alloca has four slices in a single partition, and is promoted whatever
+; the bound.
+
+define i32 @scalar(i32 %x) {
+; CHECK-LABEL: @scalar(
+; CHECK-NOT:     alloca
+; CHECK:         [[S:%.*]] = add i32 %x, %x
+; CHECK-NEXT:    [[T:%.*]] = add i32 [[S]], %x
+; CHECK-NEXT:    ret i32 [[T]]
+;
+entry:
+  %a = alloca i32
+  store i32 %x, i32* %a
+  %v0 = load i32, i32* %a
+  %v1 = load i32, i32* %a
+  %v2 = load i32, i32* %a
+  %s = add i32 %v0, %v1
+  %t = add i32 %s, %v2
+  ret i32 %t
+}
+
+; The alloca has four slices in three partitions, but the memset spans all
+; three and is rewritten for each of them: six rewrites.
+
+define i32 @memset() {
+; MEMSET-SPLIT-LABEL: @memset(
+; MEMSET-SPLIT-NOT:     alloca
+; MEMSET-SPLIT:         [[S:%.*]] = add i32 0, 0
+; MEMSET-SPLIT-NEXT:    [[T:%.*]] = add i32 [[S]], 0
+; MEMSET-SPLIT-NEXT:    ret i32 [[T]]
+;
+; MEMSET-BOUND-LABEL: @memset(
+; MEMSET-BOUND:         alloca { i32, i32, i32 }
+; MEMSET-BOUND:         call void @llvm.memset
+;
+entry:
+  %a = alloca { i32, i32, i32 }
+  %b = bitcast { i32, i32, i32 }* %a to i8*
+  call void @llvm.memset.p0i8.i64(i8* %b, i8 0, i64 12, i32 4, i1 false)
+  %p0 = getelementptr { i32, i32, i32 }, { i32, i32, i32 }* %a, i64 0, i32 0
+  %p1 = getelementptr { i32, i32, i32 }, { i32, i32, i32 }* %a, i64 0, i32 1
+  %p2 = getelementptr { i32, i32, i32 }, { i32, i32, i32 }* %a, i64 0, i32 2
+  %v0 = load i32, i32* %p0
+  %v1 = load i32, i32* %p1
+  %v2 = load i32, i32* %p2
+  %s = add i32 %v0, %v1
+  %t = add i32 %s, %v2
+  ret i32 %t
+}
+
+; The alloca has six slices: two on the first field and four on the second.
+; Past the bound the first field is left in memory too, although its own
+; partition has only two slices.
+
+define i32 @uneven(i32 %x, i32 %y) {
+; UNEVEN-SPLIT-LABEL: @uneven(
+; UNEVEN-SPLIT-NOT:     alloca
+; UNEVEN-SPLIT:         ret i32
+;
+; UNEVEN-BOUND-LABEL: @uneven(
+; UNEVEN-BOUND:         alloca { i32, i32 }
+; UNEVEN-BOUND:         store i32 %x
+; UNEVEN-BOUND:         store i32 %y
+; UNEVEN-BOUND:         load i32
+;
+entry:
+  %a = alloca { i32, i32 }
+  %p0 = getelementptr { i32, i32 }, { i32, i32 }* %a, i64 0, i32 0
+  %p1 = getelementptr { i32, i32 }, { i32, i32 }* %a, i64 0, i32 1
+  store i32 %x, i32* %p0
+  store i32 %y, i32* %p1
+  %v0 = load i32, i32* %p0
+  %v1 = load i32, i32* %p1
+  %v2 = load i32, i32* %p1
+  %v3 = load i32, i32* %p1
+  %s = add i32 %v0, %v1
+  %t = add i32 %s, %v2
+  %u = add i32 %t, %v3
+  ret i32 %u
+}
@@ -0,0 +1,49 @@
+; RUN: llvm-opt-bench %s -repeat=2 -pipelines=legacy-O1,newpm-Os \
+; RUN:     -json=%t.json | FileCheck %s --check-prefix=TABLE
+; RUN: FileCheck %s --check-prefix=JSON < %t.json
+; RUN: not llvm-opt-bench %s -pipelines=legacy-O4 2>&1 \
+; RUN:     | FileCheck %s --check-prefix=ERROR
+
+; TABLE:      {{.*}}basic.ll, legacy-O1 (2 runs)
+; TABLE:      wall time (s)
+; TABLE:      user time (s)
+; TABLE:      peak RSS (MB)
+; TABLE:      Function pass wall time per run:
+; TABLE:      {{.*}}basic.ll, newpm-Os (2 runs)
+; TABLE:      Function pass wall time per run:
+; TABLE-DAG:  InstCombinePass
+; TABLE-DAG:  SimplifyCFGPass
+
+; JSON:      {"results": [
+; JSON-NEXT:   {"file": "{{.*}}basic.ll", "pipeline": "legacy-O1", "runs": 2,
+; JSON-NEXT:    "wall_seconds": {"min": {{.*}}, "median": {{.*}}, "mean": {{.*}}, "stddev": {{.*}}},
+; JSON-NEXT:    "user_seconds": {"min":
+; JSON-NEXT:    "peak_rss_bytes": {"min":
+; JSON:         "passes": [
+; JSON:           {"name": "Combine redundant instructions", "wall_seconds": {{.*}}, "runs": {{[0-9]+}}}
+; JSON:        {"file": "{{.*}}basic.ll", "pipeline": "newpm-Os", "runs": 2,
+; JSON:      ]}
+
+; ERROR: unknown pipeline 'legacy-O4'
+
+define internal i32 @square(i32 %x) {
+  %r = mul i32 %x, %x
+  ret i32 %r
+}
+
+define i32 @sum(i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %acc = phi i32 [ 0, %entry ], [ %acc.next, %loop ]
+  %sq = call i32 @square(i32 %i)
+  %acc.next = add i32 %acc, %sq
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 %acc.next
+}
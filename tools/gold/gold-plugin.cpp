@@ -62,6 +62,9 @@ struct claimed_file {
   void *handle;
   void *leader_handle;
   std::vector<ld_plugin_symbol> syms;
+  // The NUL-terminated names and comdat keys that syms point to, in a single
+  // allocation rather than one per symbol.
+  std::unique_ptr<char[]> sym_names;
   off_t filesize;
   std::string name;
 };
@@ -504,12 +507,32 @@ static ld_plugin_status claim_file_hook(const ld_plugin_input_file *file,
     cf.name += ".llvm." + std::to_string(file->offset) + "." +
                sys::path::filename(Obj->getSourceFileName()).str();
 
+  // The names in the symbol table are not NUL-terminated, so copy them, and
+  // the comdat keys, into one buffer for the whole file.
+  size_t NamesSize = 0;
+  for (auto &Sym : Obj->symbols()) {
+    NamesSize += Sym.getName().size() + 1;
+    int CI = Sym.getComdatIndex();
+    if (CI != -1)
+      NamesSize += Obj->getComdatTable()[CI].size() + 1;
+  }
+  cf.sym_names.reset(new char[NamesSize]);
+  char *NextName = cf.sym_names.get();
+  auto copyName = [&](StringRef Name) {
+    char *Result = NextName;
+    memcpy(NextName, Name.data(), Name.size());
+    NextName[Name.size()] = '\0';
+    NextName += Name.size() + 1;
+    return Result;
+  };
+
+  cf.syms.reserve(Obj->symbols().size());
   for (auto &Sym : Obj->symbols()) {
     cf.syms.push_back(ld_plugin_symbol());
     ld_plugin_symbol &sym = cf.syms.back();
     sym.version = nullptr;
     StringRef Name = Sym.getName();
-    sym.name = strdup(Name.str().c_str());
+    sym.name = copyName(Name);
 
     ResolutionInfo &Res = ResInfo[Name];
 
@@ -545,8 +568,7 @@ static ld_plugin_status claim_file_hook(const ld_plugin_input_file *file,
     sym.comdat_key = nullptr;
     int CI = Sym.getComdatIndex();
     if (CI != -1) {
-      StringRef C = Obj->getComdatTable()[CI];
-      sym.comdat_key = strdup(C.str().c_str());
+      sym.comdat_key = copyName(Obj->getComdatTable()[CI]);
     }
 
     sym.resolution = LDPR_UNKNOWN;
@@ -562,13 +584,6 @@ static ld_plugin_status claim_file_hook(const ld_plugin_input_file *file,
   return LDPS_OK;
 }
 
-static void freeSymName(ld_plugin_symbol &Sym) {
-  free(Sym.name);
-  free(Sym.comdat_key);
-  Sym.name = nullptr;
-  Sym.comdat_key = nullptr;
-}
-
 /// Helper to get a file's symbols and a view into it via gold callbacks.
 static const void *getSymbolsAndView(claimed_file &F) {
   ld_plugin_status status = get_symbols(F.handle, F.syms.size(), F.syms.data());
@@ -642,7 +657,7 @@ static void addModule(LTO &Lto, claimed_file &F, const void *View,
     ld_plugin_symbol_resolution Resolution =
         (ld_plugin_symbol_resolution)Sym.resolution;
 
-    ResolutionInfo &Res = ResInfo[Sym.name];
+    ResolutionInfo &Res = ResInfo[InpSym.getName()];
 
     switch (Resolution) {
     case LDPR_UNKNOWN:
@@ -683,8 +698,10 @@ static void addModule(LTO &Lto, claimed_file &F, const void *View,
         (IsExecutable || !Res.DefaultVisibility))
       R.FinalDefinitionInLinkageUnit = true;
 
-    freeSymName(Sym);
+    Sym.name = nullptr;
+    Sym.comdat_key = nullptr;
   }
+  F.sym_names.reset();
 
   check(Lto.add(std::move(Input), Resols),
         std::string("Failed to link module ") + F.name);
@@ -0,0 +1,615 @@
+//===- llvm-opt-bench.cpp - Compile-time benchmark for the opt pipelines --===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This program runs the standard optimization pipelines of both pass managers
+// over a corpus of IR files and reports how long they take, so that compile
+// time regressions can be caught and attributed to a pipeline or a pass.
+//
+// Every (file, pipeline) pair is run -repeat times, each time on a freshly
+// parsed module in a fresh context; parsing is not part of the measurement.
+// For every run the wall and user time, the peak resident set size and, where
+// the host supports it, the number of instructions retired are recorded, and
+// the minimum, median, mean and standard deviation over the runs are reported.
+// The time spent in every function pass is collected through the pass
+// profiler and reported per pass as well.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Config/config.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/PassProfiler.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/IPO/AlwaysInliner.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+
+using namespace llvm;
+
+static cl::list<std::string> InputFilenames(cl::Positional, cl::OneOrMore,
+                                            cl::desc("<input files>"));
+
+static cl::list<std::string> Pipelines(
+    "pipelines", cl::CommaSeparated,
+    cl::desc("Pipelines to run: legacy-O1, legacy-O2, legacy-O3, legacy-Os, "
+             "legacy-Oz, newpm-O1, newpm-O2, newpm-O3, newpm-Os, newpm-Oz "
+             "(default: the O1, O2, O3 and Os pipelines of both pass "
+             "managers)"));
+
+static cl::opt<unsigned> Repeat("repeat", cl::init(5),
+                                cl::desc("Number of runs per file and "
+                                         "pipeline"));
+
+static cl::opt<std::string>
+    JSONFilename("json", cl::value_desc("filename"),
+                 cl::desc("Also write the results as JSON to this file"));
+
+static cl::opt<bool>
+    NoPassTimes("no-pass-times",
+                cl::desc("Do not collect per pass times; this keeps the "
+                         "profiling overhead out of the pipeline times"));
+
+namespace {
+/// One of the standard pipelines of either pass manager.
+struct PipelineInfo {
+  std::string Name;
+  bool NewPM;
+  unsigned OptLevel;
+  unsigned SizeLevel;
+};
+
+/// The measurements of a single run of a pipeline.
+struct Sample {
+  double WallSeconds;
+  double UserSeconds;
+  uint64_t PeakRSS;
+  /// Zero if the instruction counter is not available.
+  uint64_t Instructions;
+};
+
+/// The time spent in one pass over all the runs of a pipeline.
+struct PassTime {
+  double WallSeconds = 0;
+  uint64_t Runs = 0;
+};
+
+/// The results for one (file, pipeline) pair.
+struct Result {
+  std::string File;
+  std::string Pipeline;
+  std::vector<Sample> Samples;
+  StringMap<PassTime> PassTimes;
+};
+
+/// Summary statistics over the samples of one counter.
+struct Stats {
+  double Min, Median, Mean, StdDev;
+};
+} // end anonymous namespace
+
+static bool parsePipelineName(StringRef Name, PipelineInfo &P) {
+  P.Name = Name;
+  if (Name.consume_front("legacy-"))
+    P.NewPM = false;
+  else if (Name.consume_front("newpm-"))
+    P.NewPM = true;
+  else
+    return false;
+  P.SizeLevel = 0;
+  if (Name == "O1")
+    P.OptLevel = 1;
+  else if (Name == "O2")
+    P.OptLevel = 2;
+  else if (Name == "O3")
+    P.OptLevel = 3;
+  else if (Name == "Os" || Name == "Oz") {
+    P.OptLevel = 2;
+    P.SizeLevel = Name == "Os" ? 1 : 2;
+  } else
+    return false;
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Host counters.
+//
+
+#ifdef __linux__
+/// Reads a "<Key>: <value> kB" line of /proc/self/status, in bytes.
+static uint64_t readProcStatus(StringRef Key) {
+  auto BufOrErr = MemoryBuffer::getFileAsStream("/proc/self/status");
+  if (!BufOrErr)
+    return 0;
+  SmallVector<StringRef, 64> Lines;
+  (*BufOrErr)->getBuffer().split(Lines, '\n');
+  for (StringRef Line : Lines) {
+    if (!Line.consume_front(Key) || !Line.consume_front(":"))
+      continue;
+    uint64_t KB;
+    if (Line.trim().rtrim(" kB").getAsInteger(10, KB))
+      return 0;
+    return KB * 1024;
+  }
+  return 0;
+}
+#endif
+
+/// Resets the peak resident set size of the process, where the host allows it,
+/// so that the next getPeakRSS() covers just the run which follows.
+static void resetPeakRSS() {
+#ifdef __linux__
+  std::error_code EC;
+  raw_fd_ostream OS("/proc/self/clear_refs", EC, sys::fs::F_None);
+  if (!EC)
+    OS << "5";
+#endif
+}
+
+/// Returns the peak resident set size of the process in bytes.
+static uint64_t getPeakRSS() {
+#ifdef __linux__
+  if (uint64_t HWM = readProcStatus("VmHWM"))
+    return HWM;
+#endif
+#ifdef HAVE_GETRUSAGE
+  struct rusage RU;
+  if (::getrusage(RUSAGE_SELF, &RU) == 0) {
+#if defined(__APPLE__)
+    return RU.ru_maxrss;
+#else
+    return uint64_t(RU.ru_maxrss) * 1024;
+#endif
+  }
+#endif
+  return 0;
+}
+
+namespace {
+/// Counts the user space instructions retired by this thread, if the host
+/// provides a hardware counter for it.
+class InstructionCounter {
+public:
+  InstructionCounter() {
+#ifdef __linux__
+    struct perf_event_attr Attr;
+    memset(&Attr, 0, sizeof(Attr));
+    Attr.type = PERF_TYPE_HARDWARE;
+    Attr.size = sizeof(Attr);
+    Attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    Attr.disabled = 1;
+    Attr.exclude_kernel = 1;
+    Attr.exclude_hv = 1;
+    FD = ::syscall(__NR_perf_event_open, &Attr, 0, -1, -1, 0);
+#endif
+  }
+
+  ~InstructionCounter() {
+#ifdef __linux__
+    if (FD >= 0)
+      ::close(FD);
+#endif
+  }
+
+  bool isAvailable() const { return FD >= 0; }
+
+  void start() {
+#ifdef __linux__
+    if (FD < 0)
+      return;
+    ::ioctl(FD, PERF_EVENT_IOC_RESET, 0);
+    ::ioctl(FD, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+  }
+
+  uint64_t stop() {
+    uint64_t Count = 0;
+#ifdef __linux__
+    if (FD < 0)
+      return 0;
+    ::ioctl(FD, PERF_EVENT_IOC_DISABLE, 0);
+    if (::read(FD, &Count, sizeof(Count)) != sizeof(Count))
+      Count = 0;
+#endif
+    return Count;
+  }
+
+private:
+  int FD = -1;
+};
+} // end anonymous namespace
+
+//===----------------------------------------------------------------------===//
+// Running the pipelines.
+//
+
+static std::unique_ptr<TargetMachine> createTargetMachine(Module &M,
+                                                          unsigned OptLevel) {
+  Triple TheTriple(M.getTargetTriple());
+  if (TheTriple.getTriple().empty())
+    TheTriple.setTriple(sys::getDefaultTargetTriple());
+  std::string Error;
+  const Target *TheTarget =
+      TargetRegistry::lookupTarget(TheTriple.getTriple(), Error);
+  // Without a target the pipelines run with the default TTI, like in opt.
+  if (!TheTarget)
+    return nullptr;
+  CodeGenOpt::Level CGOptLevel =
+      OptLevel > 2 ? CodeGenOpt::Aggressive : CodeGenOpt::Default;
+  return std::unique_ptr<TargetMachine>(TheTarget->createTargetMachine(
+      TheTriple.getTriple(), "", "", TargetOptions(), None, None,
+      CGOptLevel));
+}
+
+static void runLegacyPipeline(Module &M, TargetMachine *TM,
+                              const PipelineInfo &P) {
+  legacy::PassManager MPM;
+  legacy::FunctionPassManager FPM(&M);
+  TargetLibraryInfoImpl TLII(Triple(M.getTargetTriple()));
+  MPM.add(new TargetLibraryInfoWrapperPass(TLII));
+  MPM.add(createTargetTransformInfoWrapperPass(
+      TM ? TM->getTargetIRAnalysis() : TargetIRAnalysis()));
+  FPM.add(createTargetTransformInfoWrapperPass(
+      TM ? TM->getTargetIRAnalysis() : TargetIRAnalysis()));
+
+  // This mirrors AddOptimizationPasses in opt.
+  PassManagerBuilder Builder;
+  Builder.OptLevel = P.OptLevel;
+  Builder.SizeLevel = P.SizeLevel;
+  if (P.OptLevel > 1)
+    Builder.Inliner = createFunctionInliningPass(P.OptLevel, P.SizeLevel,
+                                                 false);
+  else
+    Builder.Inliner = createAlwaysInlinerLegacyPass();
+  Builder.DisableUnrollLoops = P.OptLevel == 0;
+  Builder.LoopVectorize = P.OptLevel > 1 && P.SizeLevel < 2;
+  Builder.SLPVectorize = P.OptLevel > 1 && P.SizeLevel < 2;
+  if (TM)
+    TM->adjustPassManager(Builder);
+  Builder.populateFunctionPassManager(FPM);
+  Builder.populateModulePassManager(MPM);
+
+  FPM.doInitialization();
+  for (Function &F : M)
+    FPM.run(F);
+  FPM.doFinalization();
+  MPM.run(M);
+}
+
+static void runNewPMPipeline(Module &M, TargetMachine *TM,
+                             const PipelineInfo &P) {
+  PassBuilder PB(TM);
+  AAManager AA = PB.buildDefaultAAPipeline();
+  LoopAnalysisManager LAM;
+  FunctionAnalysisManager FAM;
+  CGSCCAnalysisManager CGAM;
+  ModuleAnalysisManager MAM;
+  FAM.registerPass([&] { return std::move(AA); });
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+  PassBuilder::OptimizationLevel Level;
+  if (P.SizeLevel)
+    Level = P.SizeLevel == 1 ? PassBuilder::Os : PassBuilder::Oz;
+  else
+    Level = P.OptLevel == 1 ? PassBuilder::O1
+                            : P.OptLevel == 2 ? PassBuilder::O2
+                                              : PassBuilder::O3;
+  ModulePassManager MPM = PB.buildPerModuleDefaultPipeline(Level);
+  MPM.run(M, MAM);
+}
+
+/// Parses \p Buffer into a fresh context and runs \p P over it once.
+static bool runOnce(MemoryBufferRef Buffer, const PipelineInfo &P,
+                    InstructionCounter &Counter, Sample &S,
+                    StringMap<PassTime> &PassTimes) {
+  LLVMContext Context;
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M = parseIR(Buffer, Err, Context);
+  if (!M) {
+    Err.print("llvm-opt-bench", errs());
+    return false;
+  }
+  std::unique_ptr<TargetMachine> TM = createTargetMachine(*M, P.OptLevel);
+  if (TM)
+    M->setDataLayout(TM->createDataLayout());
+
+  resetPeakRSS();
+  if (PassProfiler *Profiler = PassProfiler::get())
+    Profiler->takeRecords();
+  sys::TimePoint<> Elapsed;
+  std::chrono::nanoseconds UserStart, UserEnd, Sys;
+  sys::Process::GetTimeUsage(Elapsed, UserStart, Sys);
+  auto WallStart = std::chrono::steady_clock::now();
+  Counter.start();
+
+  if (P.NewPM)
+    runNewPMPipeline(*M, TM.get(), P);
+  else
+    runLegacyPipeline(*M, TM.get(), P);
+
+  S.Instructions = Counter.stop();
+  auto WallEnd = std::chrono::steady_clock::now();
+  sys::Process::GetTimeUsage(Elapsed, UserEnd, Sys);
+  S.WallSeconds = std::chrono::duration<double>(WallEnd - WallStart).count();
+  S.UserSeconds = std::chrono::duration<double>(UserEnd - UserStart).count();
+  S.PeakRSS = getPeakRSS();
+
+  if (PassProfiler *Profiler = PassProfiler::get()) {
+    for (const PassProfiler::Record &R : Profiler->takeRecords()) {
+      PassTime &T = PassTimes[R.PassName];
+      T.WallSeconds += R.WallMicros / 1e6;
+      ++T.Runs;
+    }
+  }
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Reporting.
+//
+
+static Stats computeStats(const std::vector<Sample> &Samples,
+                          function_ref<double(const Sample &)> Get) {
+  std::vector<double> Values;
+  for (const Sample &S : Samples)
+    Values.push_back(Get(S));
+  std::sort(Values.begin(), Values.end());
+  Stats St;
+  St.Min = Values.front();
+  size_t Mid = Values.size() / 2;
+  St.Median =
+      Values.size() % 2 ? Values[Mid] : (Values[Mid - 1] + Values[Mid]) / 2;
+  double Sum = 0;
+  for (double V : Values)
+    Sum += V;
+  St.Mean = Sum / Values.size();
+  double SquareSum = 0;
+  for (double V : Values)
+    SquareSum += (V - St.Mean) * (V - St.Mean);
+  St.StdDev =
+      Values.size() > 1 ? std::sqrt(SquareSum / (Values.size() - 1)) : 0.0;
+  return St;
+}
+
+/// Returns the passes of \p R sorted by decreasing total time.
+static std::vector<StringMapEntry<PassTime> *> sortedPasses(Result &R) {
+  std::vector<StringMapEntry<PassTime> *> Passes;
+  for (auto &Entry : R.PassTimes)
+    Passes.push_back(&Entry);
+  std::sort(Passes.begin(), Passes.end(), [](StringMapEntry<PassTime> *A,
+                                             StringMapEntry<PassTime> *B) {
+    if (A->getValue().WallSeconds != B->getValue().WallSeconds)
+      return A->getValue().WallSeconds > B->getValue().WallSeconds;
+    return A->getKey() < B->getKey();
+  });
+  return Passes;
+}
+
+static void printTable(raw_ostream &OS, std::vector<Result> &Results,
+                       bool HaveInstructions) {
+  for (Result &R : Results) {
+    OS << "===" << std::string(73, '-') << "===\n"
+       << R.File << ", " << R.Pipeline << " (" << R.Samples.size()
+       << " runs)\n"
+       << "===" << std::string(73, '-') << "===\n";
+    OS << left_justify("", 18) << right_justify("min", 14)
+       << right_justify("median", 14) << right_justify("mean", 14)
+       << right_justify("stddev", 14) << "\n";
+    auto PrintRow = [&](StringRef Name, Stats St, double Scale,
+                        const char *Fmt) {
+      OS << left_justify(Name, 18) << format(Fmt, St.Min * Scale)
+         << format(Fmt, St.Median * Scale) << format(Fmt, St.Mean * Scale)
+         << format(Fmt, St.StdDev * Scale) << "\n";
+    };
+    PrintRow("wall time (s)",
+             computeStats(R.Samples, [](const Sample &S) {
+               return S.WallSeconds;
+             }),
+             1, "%14.4f");
+    PrintRow("user time (s)",
+             computeStats(R.Samples, [](const Sample &S) {
+               return S.UserSeconds;
+             }),
+             1, "%14.4f");
+    PrintRow("peak RSS (MB)", computeStats(R.Samples, [](const Sample &S) {
+               return double(S.PeakRSS);
+             }),
+             1.0 / (1 << 20), "%14.1f");
+    if (HaveInstructions)
+      PrintRow("instructions (M)",
+               computeStats(R.Samples, [](const Sample &S) {
+                 return double(S.Instructions);
+               }),
+               1e-6, "%14.1f");
+
+    if (R.PassTimes.empty()) {
+      OS << "\n";
+      continue;
+    }
+    OS << "\n  Function pass wall time per run:\n";
+    for (StringMapEntry<PassTime> *Entry : sortedPasses(R))
+      OS << format("  %10.4fs ", Entry->getValue().WallSeconds /
+                                      R.Samples.size())
+         << Entry->getKey() << "\n";
+    OS << "\n";
+  }
+}
+
+static void printStatsJSON(raw_ostream &OS, StringRef Name, Stats St) {
+  OS << "\"" << Name << "\": {\"min\": " << format("%.6g", St.Min)
+     << ", \"median\": " << format("%.6g", St.Median)
+     << ", \"mean\": " << format("%.6g", St.Mean)
+     << ", \"stddev\": " << format("%.6g", St.StdDev) << "}";
+}
+
+static void printJSON(raw_ostream &OS, std::vector<Result> &Results,
+                      bool HaveInstructions) {
+  OS << "{\"results\": [";
+  for (size_t I = 0, E = Results.size(); I != E; ++I) {
+    Result &R = Results[I];
+    OS << (I ? ",\n  " : "\n  ") << "{\"file\": \"";
+    OS.write_escaped(R.File);
+    OS << "\", \"pipeline\": \"" << R.Pipeline
+       << "\", \"runs\": " << R.Samples.size() << ",\n   ";
+    printStatsJSON(OS, "wall_seconds", computeStats(R.Samples,
+                                                    [](const Sample &S) {
+                                                      return S.WallSeconds;
+                                                    }));
+    OS << ",\n   ";
+    printStatsJSON(OS, "user_seconds", computeStats(R.Samples,
+                                                    [](const Sample &S) {
+                                                      return S.UserSeconds;
+                                                    }));
+    OS << ",\n   ";
+    printStatsJSON(OS, "peak_rss_bytes",
+                   computeStats(R.Samples, [](const Sample &S) {
+                     return double(S.PeakRSS);
+                   }));
+    if (HaveInstructions) {
+      OS << ",\n   ";
+      printStatsJSON(OS, "instructions",
+                     computeStats(R.Samples, [](const Sample &S) {
+                       return double(S.Instructions);
+                     }));
+    }
+    OS << ",\n   \"passes\": [";
+    bool First = true;
+    for (StringMapEntry<PassTime> *Entry : sortedPasses(R)) {
+      OS << (First ? "\n    " : ",\n    ") << "{\"name\": \"";
+      OS.write_escaped(Entry->getKey());
+      OS << "\", \"wall_seconds\": "
+         << format("%.6g", Entry->getValue().WallSeconds / R.Samples.size())
+         << ", \"runs\": " << Entry->getValue().Runs / R.Samples.size()
+         << "}";
+      First = false;
+    }
+    OS << (First ? "]}" : "\n   ]}");
+  }
+  OS << "\n]}\n";
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal(argv[0]);
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y;
+
+  InitializeAllTargets();
+  InitializeAllTargetMCs();
+
+  PassRegistry &Registry = *PassRegistry::getPassRegistry();
+  initializeCore(Registry);
+  initializeScalarOpts(Registry);
+  initializeVectorization(Registry);
+  initializeIPO(Registry);
+  initializeAnalysis(Registry);
+  initializeTransformUtils(Registry);
+  initializeInstCombine(Registry);
+  initializeTarget(Registry);
+
+  cl::ParseCommandLineOptions(argc, argv,
+                              "compile-time benchmark for the optimization "
+                              "pipelines\n");
+
+  std::vector<PipelineInfo> Infos;
+  std::vector<std::string> Names(Pipelines.begin(), Pipelines.end());
+  if (Names.empty())
+    Names = {"legacy-O1", "legacy-O2", "legacy-O3", "legacy-Os",
+             "newpm-O1",  "newpm-O2",  "newpm-O3",  "newpm-Os"};
+  for (const std::string &Name : Names) {
+    PipelineInfo P;
+    if (!parsePipelineName(Name, P)) {
+      errs() << argv[0] << ": unknown pipeline '" << Name << "'\n";
+      return 1;
+    }
+    Infos.push_back(P);
+  }
+
+  if (!NoPassTimes)
+    PassProfiler::enable();
+
+  InstructionCounter Counter;
+  std::vector<Result> Results;
+  for (const std::string &File : InputFilenames) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+        MemoryBuffer::getFileOrSTDIN(File);
+    if (std::error_code EC = BufOrErr.getError()) {
+      errs() << argv[0] << ": " << File << ": " << EC.message() << "\n";
+      return 1;
+    }
+    for (const PipelineInfo &P : Infos) {
+      Result R;
+      R.File = File;
+      R.Pipeline = P.Name;
+      for (unsigned I = 0; I < std::max(1u, unsigned(Repeat)); ++I) {
+        Sample S;
+        if (!runOnce((*BufOrErr)->getMemBufferRef(), P, Counter, S,
+                     R.PassTimes))
+          return 1;
+        R.Samples.push_back(S);
+      }
+      Results.push_back(std::move(R));
+    }
+  }
+
+  printTable(outs(), Results, Counter.isAvailable());
+
+  if (!JSONFilename.empty()) {
+    std::error_code EC;
+    raw_fd_ostream OS(JSONFilename, EC, sys::fs::F_Text);
+    if (EC) {
+      errs() << argv[0] << ": " << JSONFilename << ": " << EC.message()
+             << "\n";
+      return 1;
+    }
+    printJSON(OS, Results, Counter.isAvailable());
+  }
+  return 0;
+}
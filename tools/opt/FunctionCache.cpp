@@ -0,0 +1,538 @@
+//===- FunctionCache.cpp - On-disk cache of optimized functions -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Both the key and the cached value of a function are bitcode modules which
+// hold a copy of the function and of the globals it refers to. The value is
+// read back into the context of the module being optimized, its globals are
+// matched up with those of the module by name, and the blocks of the cached
+// function replace the body of the original one.
+//
+//===----------------------------------------------------------------------===//
+
+#include "FunctionCache.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/TypeFinder.h"
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "function-cache"
+
+STATISTIC(NumCacheHits, "Number of functions read from the function cache");
+STATISTIC(NumCacheMisses, "Number of functions added to the function cache");
+STATISTIC(NumUncacheable, "Number of functions which cannot be cached");
+
+/// Named metadata of a cached module listing the names of its identified
+/// struct types, in the order TypeFinder visits them.
+static const char *const TypeNamesMD = "llvm.function.cache.types";
+
+/// Named metadata of a cached module listing the local globals the pipeline
+/// created, which must not be matched up with globals of the same name.
+static const char *const NewGlobalsMD = "llvm.function.cache.new";
+
+namespace {
+/// Collects the globals a function refers to, directly or through constant
+/// expressions, metadata and the initializers of global variables.
+class GlobalCollector {
+public:
+  /// Returns false if \p F cannot be cached.
+  bool collect(const Function &F);
+
+  /// The globals \p F refers to, in a deterministic order, not including
+  /// \p F itself.
+  ArrayRef<const GlobalValue *> getGlobals() const {
+    return Globals.getArrayRef();
+  }
+
+private:
+  bool addConstant(const Constant *C);
+  bool addMetadata(const Metadata *MD);
+
+  SetVector<const GlobalValue *> Globals;
+  SmallPtrSet<const Constant *, 32> VisitedConstants;
+  SmallPtrSet<const Metadata *, 16> VisitedMetadata;
+};
+
+/// Maps the struct types the bitcode reader created for a cached module to
+/// the types they stand for in the context they were read into.
+class CachedTypeRemapper : public ValueMapTypeRemapper {
+public:
+  void addMapping(StructType *From, StructType *To) { MappedTypes[From] = To; }
+  Type *remapType(Type *Ty) override;
+
+private:
+  DenseMap<Type *, Type *> MappedTypes;
+};
+} // end anonymous namespace
+
+bool GlobalCollector::collect(const Function &F) {
+  // Debug info would have to be merged with the compile units of the module
+  // the function is restored into, prefix and prologue data are not remapped
+  // by CloneFunctionInto, and deleting a block whose address is taken
+  // elsewhere would break that reference.
+  if (F.getSubprogram() || F.hasPrefixData() || F.hasPrologueData())
+    return false;
+  if (F.hasPersonalityFn() && !addConstant(F.getPersonalityFn()))
+    return false;
+
+  SmallVector<std::pair<unsigned, MDNode *>, 4> MDs;
+  F.getAllMetadata(MDs);
+  for (const auto &MD : MDs)
+    if (!addMetadata(MD.second))
+      return false;
+
+  for (const BasicBlock &BB : F) {
+    if (BB.hasAddressTaken())
+      return false;
+    for (const Instruction &I : BB) {
+      if (I.getDebugLoc())
+        return false;
+      for (const Use &Op : I.operands()) {
+        if (auto *C = dyn_cast<Constant>(Op)) {
+          if (!addConstant(C))
+            return false;
+        } else if (auto *MAV = dyn_cast<MetadataAsValue>(Op)) {
+          if (!addMetadata(MAV->getMetadata()))
+            return false;
+        }
+      }
+      MDs.clear();
+      I.getAllMetadataOtherThanDebugLoc(MDs);
+      for (const auto &MD : MDs)
+        if (!addMetadata(MD.second))
+          return false;
+    }
+  }
+  Globals.remove(&F);
+  return true;
+}
+
+bool GlobalCollector::addConstant(const Constant *C) {
+  if (!VisitedConstants.insert(C).second)
+    return true;
+  if (isa<BlockAddress>(C))
+    return false;
+  if (auto *GV = dyn_cast<GlobalValue>(C)) {
+    // Globals are matched up by name when a function is restored.
+    if (!GV->hasName() || isa<GlobalIFunc>(GV))
+      return false;
+    Globals.insert(GV);
+    if (auto *Var = dyn_cast<GlobalVariable>(GV))
+      return !Var->hasInitializer() || addConstant(Var->getInitializer());
+    if (auto *GA = dyn_cast<GlobalAlias>(GV))
+      return addConstant(GA->getAliasee());
+    return true;
+  }
+  for (const Use &Op : C->operands())
+    if (!addConstant(cast<Constant>(Op)))
+      return false;
+  return true;
+}
+
+bool GlobalCollector::addMetadata(const Metadata *MD) {
+  if (!VisitedMetadata.insert(MD).second)
+    return true;
+  if (auto *CMD = dyn_cast<ConstantAsMetadata>(MD))
+    return addConstant(CMD->getValue());
+  if (auto *N = dyn_cast<MDNode>(MD)) {
+    // Specialized nodes are debug info.
+    if (!isa<MDTuple>(N))
+      return false;
+    for (const MDOperand &Op : N->operands())
+      if (Op && !addMetadata(Op))
+        return false;
+  }
+  return true;
+}
+
+Type *CachedTypeRemapper::remapType(Type *Ty) {
+  auto It = MappedTypes.find(Ty);
+  if (It != MappedTypes.end())
+    return It->second;
+
+  // Identified structs are only ever mapped by addMapping(); everything else
+  // is rebuilt if one of the types it is made of changes.
+  Type *Result = Ty;
+  auto *STy = dyn_cast<StructType>(Ty);
+  if (!STy || STy->isLiteral()) {
+    SmallVector<Type *, 4> Elements;
+    bool Changed = false;
+    for (Type *Element : Ty->subtypes()) {
+      Elements.push_back(remapType(Element));
+      Changed |= Elements.back() != Element;
+    }
+    if (Changed) {
+      switch (Ty->getTypeID()) {
+      case Type::PointerTyID:
+        Result = PointerType::get(Elements[0], Ty->getPointerAddressSpace());
+        break;
+      case Type::ArrayTyID:
+        Result = ArrayType::get(Elements[0], Ty->getArrayNumElements());
+        break;
+      case Type::VectorTyID:
+        Result = VectorType::get(Elements[0], Ty->getVectorNumElements());
+        break;
+      case Type::FunctionTyID:
+        Result = FunctionType::get(Elements[0], makeArrayRef(Elements).slice(1),
+                                   cast<FunctionType>(Ty)->isVarArg());
+        break;
+      case Type::StructTyID:
+        Result =
+            StructType::get(Ty->getContext(), Elements, STy->isPacked());
+        break;
+      default:
+        llvm_unreachable("Type without subtypes changed");
+      }
+    }
+  }
+  MappedTypes[Ty] = Result;
+  return Result;
+}
+
+/// Copies \p F and \p Globals, the globals collected for it, into a new
+/// module in the same context. Referenced functions become declarations;
+/// global variables and aliases keep their definitions. If \p OldGlobals is
+/// given, local globals which are not in it are recorded as new. Returns null
+/// if the function uses types which cannot be matched up by name.
+static std::unique_ptr<Module>
+extractFunction(const Function &F, ArrayRef<const GlobalValue *> Globals,
+                const SmallPtrSetImpl<const GlobalValue *> *OldGlobals) {
+  const Module &Src = *F.getParent();
+  LLVMContext &Ctx = F.getContext();
+  auto M = llvm::make_unique<Module>("llvm-function-cache", Ctx);
+  M->setSourceFileName("");
+  M->setTargetTriple(Src.getTargetTriple());
+  M->setDataLayout(Src.getDataLayout());
+
+  ValueToValueMapTy VMap;
+  for (const GlobalValue *GV : Globals) {
+    GlobalValue *NewGV;
+    if (auto *Fn = dyn_cast<Function>(GV)) {
+      Function *NewFn =
+          Function::Create(Fn->getFunctionType(), GlobalValue::ExternalLinkage,
+                           Fn->getName(), M.get());
+      NewFn->setAttributes(Fn->getAttributes());
+      NewFn->setCallingConv(Fn->getCallingConv());
+      NewGV = NewFn;
+    } else if (auto *Var = dyn_cast<GlobalVariable>(GV)) {
+      auto *NewVar = new GlobalVariable(
+          *M, Var->getValueType(), Var->isConstant(), Var->getLinkage(),
+          nullptr, Var->getName(), nullptr, Var->getThreadLocalMode(),
+          Var->getType()->getAddressSpace());
+      NewVar->copyAttributesFrom(Var);
+      NewGV = NewVar;
+    } else {
+      auto *GA = cast<GlobalAlias>(GV);
+      NewGV = GlobalAlias::create(GA->getValueType(),
+                                  GA->getType()->getAddressSpace(),
+                                  GA->getLinkage(), GA->getName(), M.get());
+    }
+    VMap[GV] = NewGV;
+  }
+
+  Function *NewF = Function::Create(F.getFunctionType(), F.getLinkage(),
+                                    F.getName(), M.get());
+  VMap[&F] = NewF;
+  auto NewArg = NewF->arg_begin();
+  for (const Argument &Arg : F.args()) {
+    NewArg->setName(Arg.getName());
+    VMap[&Arg] = &*NewArg++;
+  }
+  SmallVector<ReturnInst *, 8> Returns;
+  CloneFunctionInto(NewF, &F, VMap, /*ModuleLevelChanges=*/true, Returns);
+
+  // Initializers and aliasees may refer to each other, so they can only be
+  // mapped once every global has been created.
+  for (const GlobalValue *GV : Globals) {
+    if (auto *Var = dyn_cast<GlobalVariable>(GV)) {
+      if (Var->hasInitializer())
+        cast<GlobalVariable>(VMap[Var])->setInitializer(
+            MapValue(Var->getInitializer(), VMap));
+    } else if (auto *GA = dyn_cast<GlobalAlias>(GV)) {
+      cast<GlobalAlias>(VMap[GA])->setAliasee(MapValue(GA->getAliasee(), VMap));
+    }
+  }
+
+  if (NamedMDNode *Flags = Src.getModuleFlagsMetadata()) {
+    NamedMDNode *NewFlags = M->getOrInsertModuleFlagsMetadata();
+    for (const MDNode *Flag : Flags->operands())
+      NewFlags->addOperand(MapMetadata(Flag, VMap));
+  }
+
+  // The bitcode reader renames struct types whose name is already taken in
+  // the context it reads into, so remember the original names.
+  TypeFinder StructTypes;
+  StructTypes.run(*M, /*onlyNamed=*/false);
+  NamedMDNode *TypeNames = M->getOrInsertNamedMetadata(TypeNamesMD);
+  for (StructType *STy : StructTypes) {
+    if (!STy->hasName())
+      return nullptr;
+    TypeNames->addOperand(
+        MDNode::get(Ctx, MDString::get(Ctx, STy->getName())));
+  }
+
+  if (OldGlobals) {
+    NamedMDNode *NewGlobals = M->getOrInsertNamedMetadata(NewGlobalsMD);
+    for (const GlobalValue *GV : Globals)
+      if (GV->hasLocalLinkage() && !OldGlobals->count(GV))
+        NewGlobals->addOperand(
+            MDNode::get(Ctx, MDString::get(Ctx, GV->getName())));
+  }
+  return M;
+}
+
+/// Replaces the body of \p F with that of the function of the same name in
+/// \p Cached, a module read from the cache into the context of \p F. Returns
+/// false without changing \p F if the cached module does not fit.
+static bool restoreFunction(Function &F, Module &Cached) {
+  Module &M = *F.getParent();
+  Function *CachedF = Cached.getFunction(F.getName());
+  if (!CachedF || CachedF->isDeclaration())
+    return false;
+
+  // Map the struct types which were renamed when reading the module back to
+  // the ones they were copies of.
+  CachedTypeRemapper TypeMapper;
+  TypeFinder StructTypes;
+  StructTypes.run(Cached, /*onlyNamed=*/false);
+  NamedMDNode *TypeNames = Cached.getNamedMetadata(TypeNamesMD);
+  if (!TypeNames || TypeNames->getNumOperands() != StructTypes.size())
+    return false;
+  SmallVector<std::pair<StructType *, StructType *>, 8> RenamedTypes;
+  for (unsigned I = 0, E = StructTypes.size(); I != E; ++I) {
+    StructType *STy = StructTypes[I];
+    StringRef Name =
+        cast<MDString>(TypeNames->getOperand(I)->getOperand(0))->getString();
+    if (STy->getName() == Name)
+      continue;
+    StructType *Original = M.getTypeByName(Name);
+    if (!Original || !STy->getName().startswith(Name))
+      return false;
+    TypeMapper.addMapping(STy, Original);
+    RenamedTypes.push_back({STy, Original});
+  }
+  for (const auto &Types : RenamedTypes) {
+    StructType *STy = Types.first, *Original = Types.second;
+    if (STy->isOpaque() != Original->isOpaque() ||
+        STy->isPacked() != Original->isPacked() ||
+        STy->getNumElements() != Original->getNumElements())
+      return false;
+    for (unsigned I = 0, E = STy->getNumElements(); I != E; ++I)
+      if (TypeMapper.remapType(STy->getElementType(I)) !=
+          Original->getElementType(I))
+        return false;
+  }
+
+  // Match up the globals of the cached module with those of M. Globals the
+  // pipeline created, and declarations M does not have yet, are added to M.
+  StringSet<> NewGlobals;
+  if (NamedMDNode *New = Cached.getNamedMetadata(NewGlobalsMD))
+    for (const MDNode *Name : New->operands())
+      NewGlobals.insert(cast<MDString>(Name->getOperand(0))->getString());
+  ValueToValueMapTy VMap;
+  SmallVector<GlobalValue *, 4> MissingGlobals;
+  for (GlobalValue &GV : Cached.global_values()) {
+    if (&GV == CachedF)
+      continue;
+    GlobalValue *Existing =
+        NewGlobals.count(GV.getName()) ? nullptr : M.getNamedValue(GV.getName());
+    if (Existing) {
+      if (Existing->getType() != TypeMapper.remapType(GV.getType()))
+        return false;
+      VMap[&GV] = Existing;
+      continue;
+    }
+    if (isa<GlobalAlias>(GV) ||
+        (!GV.isDeclaration() && !NewGlobals.count(GV.getName())))
+      return false;
+    MissingGlobals.push_back(&GV);
+  }
+
+  // Nothing has been changed up to here.
+  for (GlobalValue *GV : MissingGlobals) {
+    if (auto *Fn = dyn_cast<Function>(GV)) {
+      Function *NewFn = Function::Create(
+          cast<FunctionType>(TypeMapper.remapType(Fn->getFunctionType())),
+          Fn->getLinkage(), Fn->getName(), &M);
+      NewFn->setAttributes(Fn->getAttributes());
+      NewFn->setCallingConv(Fn->getCallingConv());
+      VMap[Fn] = NewFn;
+      continue;
+    }
+    auto *Var = cast<GlobalVariable>(GV);
+    auto *NewVar = new GlobalVariable(
+        M, TypeMapper.remapType(Var->getValueType()), Var->isConstant(),
+        Var->getLinkage(), nullptr, Var->getName(), nullptr,
+        Var->getThreadLocalMode(), Var->getType()->getAddressSpace());
+    NewVar->copyAttributesFrom(Var);
+    VMap[Var] = NewVar;
+  }
+  for (GlobalValue *GV : MissingGlobals)
+    if (auto *Var = dyn_cast<GlobalVariable>(GV))
+      if (Var->hasInitializer())
+        cast<GlobalVariable>(VMap[Var])->setInitializer(
+            MapValue(Var->getInitializer(), VMap, RF_None, &TypeMapper));
+
+  VMap[CachedF] = &F;
+  auto Arg = F.arg_begin();
+  for (Argument &CachedArg : CachedF->args())
+    VMap[&CachedArg] = &*Arg++;
+  for (BasicBlock &BB : *CachedF)
+    for (Instruction &I : BB)
+      RemapInstruction(&I, VMap, RF_IgnoreMissingLocals, &TypeMapper);
+
+  F.dropAllReferences();
+  F.getBasicBlockList().splice(F.end(), CachedF->getBasicBlockList());
+  F.setAttributes(CachedF->getAttributes());
+  if (CachedF->hasPersonalityFn())
+    F.setPersonalityFn(
+        MapValue(CachedF->getPersonalityFn(), VMap, RF_None, &TypeMapper));
+  SmallVector<std::pair<unsigned, MDNode *>, 4> MDs;
+  CachedF->getAllMetadata(MDs);
+  for (const auto &MD : MDs)
+    F.addMetadata(MD.first,
+                  *MapMetadata(MD.second, VMap, RF_None, &TypeMapper));
+  return true;
+}
+
+static std::string computeKey(StringRef PipelineKey, const Module &M) {
+  SmallString<0> Bitcode;
+  raw_svector_ostream OS(Bitcode);
+  // Passes may visit uses in use list order, so it is part of the input.
+  WriteBitcodeToFile(&M, OS, /*ShouldPreserveUseListOrder=*/true);
+
+  SHA1 Hasher;
+  Hasher.update(PipelineKey);
+  Hasher.update(Bitcode);
+  return toHex(Hasher.result());
+}
+
+/// Writes \p M to the cache entry \p EntryPath. The cache only ever makes
+/// things faster, so failing to write it is not an error.
+static void writeCacheEntry(StringRef CacheDir, StringRef EntryPath,
+                            const Module &M) {
+  // Write to a temporary file and rename it, so that concurrent runs never
+  // see a partial entry.
+  int TempFD;
+  SmallString<64> TempModel, TempPath;
+  sys::path::append(TempModel, CacheDir, "Function-%%%%%%.tmp.bc");
+  if (sys::fs::createUniqueFile(TempModel, TempFD, TempPath,
+                                sys::fs::owner_read | sys::fs::owner_write))
+    return;
+  {
+    raw_fd_ostream OS(TempFD, /*shouldClose=*/true);
+    WriteBitcodeToFile(&M, OS, /*ShouldPreserveUseListOrder=*/true);
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(TempPath);
+      return;
+    }
+  }
+  if (sys::fs::rename(TempPath, EntryPath))
+    sys::fs::remove(TempPath);
+}
+
+PreservedAnalyses FunctionCachePass::run(Module &M,
+                                         ModuleAnalysisManager &MAM) {
+  FunctionAnalysisManager &FAM =
+      MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+  bool CanWrite = !sys::fs::create_directories(CacheDir);
+
+  // The pipeline may add declarations to the module.
+  std::vector<Function *> Functions;
+  for (Function &F : M)
+    if (!F.isDeclaration())
+      Functions.push_back(&F);
+
+  for (Function *F : Functions) {
+    GlobalCollector Inputs;
+    if (!Inputs.collect(*F)) {
+      ++NumUncacheable;
+      FAM.invalidate(*F, FPM.run(*F, FAM));
+      continue;
+    }
+    std::unique_ptr<Module> Key =
+        extractFunction(*F, Inputs.getGlobals(), nullptr);
+    if (!Key) {
+      ++NumUncacheable;
+      FAM.invalidate(*F, FPM.run(*F, FAM));
+      continue;
+    }
+    SmallString<64> EntryPath;
+    sys::path::append(EntryPath, CacheDir,
+                      "llvmcache-" + computeKey(PipelineKey, *Key));
+    Key.reset();
+
+    if (ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer =
+            MemoryBuffer::getFile(EntryPath)) {
+      Expected<std::unique_ptr<Module>> Cached =
+          parseBitcodeFile((*Buffer)->getMemBufferRef(), M.getContext());
+      if (!Cached) {
+        consumeError(Cached.takeError());
+      } else if (restoreFunction(*F, **Cached)) {
+        DEBUG(dbgs() << "Restored " << F->getName() << " from " << EntryPath
+                     << "\n");
+        ++NumCacheHits;
+        FAM.invalidate(*F, PreservedAnalyses::none());
+        continue;
+      }
+    }
+
+    ++NumCacheMisses;
+    FAM.invalidate(*F, FPM.run(*F, FAM));
+    if (!CanWrite)
+      continue;
+    GlobalCollector Outputs;
+    if (!Outputs.collect(*F))
+      continue;
+    SmallPtrSet<const GlobalValue *, 16> OldGlobals(
+        Inputs.getGlobals().begin(), Inputs.getGlobals().end());
+    if (std::unique_ptr<Module> Value =
+            extractFunction(*F, Outputs.getGlobals(), &OldGlobals))
+      writeCacheEntry(CacheDir, EntryPath, *Value);
+  }
+
+  if (CanWrite) {
+    Expected<CachePruningPolicy> Policy = parseCachePruningPolicy(CachePolicy);
+    if (Policy)
+      pruneCache(CacheDir, *Policy);
+    else
+      consumeError(Policy.takeError());
+  }
+
+  // Every function has been invalidated on its own above.
+  PreservedAnalyses PA;
+  PA.preserveSet<AllAnalysesOn<Function>>();
+  PA.preserve<FunctionAnalysisManagerModuleProxy>();
+  return PA;
+}
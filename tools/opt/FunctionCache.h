@@ -0,0 +1,57 @@
+//===- FunctionCache.h - On-disk cache of optimized functions ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+///
+/// A module pass which runs a function pass pipeline over every function of a
+/// module, but takes the optimized body of a function from an on-disk cache
+/// if an earlier run already optimized an identical function with the same
+/// pipeline.
+///
+/// The key of a function is the SHA-1 of the pipeline description and of a
+/// bitcode module holding the function and everything in its module it refers
+/// to: the globals it uses (global variables with their initializers), the
+/// types of the callees and their attributes, the metadata attached to its
+/// instructions and the module flags. Functions that carry debug info, whose
+/// blocks have their address taken or which refer to unnamed globals are not
+/// cached. As with the ThinLTO cache, command line options that change how a
+/// pass behaves are not part of the key.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TOOLS_OPT_FUNCTIONCACHE_H
+#define LLVM_TOOLS_OPT_FUNCTIONCACHE_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/PassManager.h"
+#include <string>
+
+namespace llvm {
+
+class FunctionCachePass : public PassInfoMixin<FunctionCachePass> {
+public:
+  /// Creates a pass which caches the results of \p FPM in \p CacheDir,
+  /// pruning it according to \p CachePolicy (see parseCachePruningPolicy).
+  /// \p PipelineKey must identify the pipeline and the target it runs for.
+  FunctionCachePass(StringRef CacheDir, StringRef CachePolicy,
+                    StringRef PipelineKey, FunctionPassManager FPM)
+      : CacheDir(CacheDir), CachePolicy(CachePolicy),
+        PipelineKey(PipelineKey), FPM(std::move(FPM)) {}
+
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM);
+
+private:
+  std::string CacheDir;
+  std::string CachePolicy;
+  std::string PipelineKey;
+  FunctionPassManager FPM;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_TOOLS_OPT_FUNCTIONCACHE_H
@@ -14,24 +14,37 @@
 //===----------------------------------------------------------------------===//
 
 #include "NewPMDriver.h"
+#include "FunctionCache.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/CGSCCPassManager.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/Bitcode/BitcodeWriterPass.h"
 #include "llvm/Config/config.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/IR/Dominators.h"
 #include "llvm/IR/IRPrintingPasses.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Linker/Linker.h"
 #include "llvm/Passes/PassBuilder.h"
+#include "llvm/Support/CachePruning.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/IPO/ThinLTOBitcodeWriter.h"
 #include "llvm/Transforms/Scalar/LoopPassManager.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
 
 using namespace llvm;
 using namespace opt_tool;
@@ -49,6 +62,23 @@ static cl::opt<std::string>
                         "pipeline for handling managed aliasing queries"),
                cl::Hidden);
 
+static cl::opt<unsigned> FunctionPipelineThreads(
+    "function-pipeline-threads", cl::init(1), cl::Hidden,
+    cl::desc("Split the module into this many partitions and run a function "
+             "pass pipeline over them in parallel, each partition in its own "
+             "LLVMContext"));
+
+static cl::opt<std::string> FunctionCacheDir(
+    "function-cache-dir", cl::Hidden, cl::value_desc("directory"),
+    cl::desc("Keep the result of running a function pass pipeline over each "
+             "function in this directory, and reuse it instead of running the "
+             "pipeline when an identical function is optimized again"));
+
+static cl::opt<std::string> FunctionCachePolicy(
+    "function-cache-policy", cl::Hidden,
+    cl::desc("Pruning policy for -function-cache-dir, in the same format as "
+             "the ThinLTO cache policy"));
+
 /// {{@ These options accept textual pipeline descriptions which will be
 /// inserted into default pipelines at the respective extension points
 static cl::opt<std::string> PeepholeEPPipeline(
@@ -161,6 +191,332 @@ static void registerEPCallbacks(PassBuilder &PB, bool VerifyEachPass,
     });
 }
 
+namespace {
+/// A module pass which runs a function pass pipeline over the partitions of a
+/// module in parallel.
+///
+/// Nothing about an LLVMContext is thread safe, so the module is split with
+/// llvm::SplitModule and every partition is serialized to bitcode on the main
+/// thread and then optimized in a fresh context on a worker thread with its own
+/// PassBuilder and analysis managers, much like llvm::splitCodeGen does for
+/// code generation. A partition also gets available_externally copies of the
+/// constant global variables its functions use but SplitModule has placed in
+/// another partition, so that the pipeline can still fold loads from them. The
+/// optimized partitions are finally linked back into the original module,
+/// dropping those copies again and restoring the linkage of local symbols
+/// (which SplitModule externalizes) and the original order of the globals.
+class ParallelFunctionPipelinePass
+    : public PassInfoMixin<ParallelFunctionPipelinePass> {
+public:
+  ParallelFunctionPipelinePass(unsigned ThreadCount, TargetMachine *TM,
+                               StringRef PassPipeline, StringRef AAPipeline,
+                               bool VerifyEachPass, bool DebugLogging)
+      : ThreadCount(ThreadCount), TM(TM), PassPipeline(PassPipeline),
+        AAPipeline(AAPipeline), VerifyEachPass(VerifyEachPass),
+        DebugLogging(DebugLogging) {}
+
+  /// \brief Returns true if \p M can be optimized in partitions without
+  /// changing the result.
+  ///
+  /// Debug info compile units would be duplicated by linking the partitions
+  /// back together, and unnamed local symbols cannot be matched up again once
+  /// SplitModule has externalized them.
+  static bool canSplit(const Module &M) {
+    if (M.getNamedMetadata("llvm.dbg.cu"))
+      return false;
+    for (const GlobalValue &GV : M.global_values())
+      if (GV.hasLocalLinkage() && !GV.hasName())
+        return false;
+    return true;
+  }
+
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &);
+
+private:
+  SmallString<0> optimizePartition(StringRef BC, TargetMachine *PartTM) const;
+
+  unsigned ThreadCount;
+  TargetMachine *TM;
+  std::string PassPipeline;
+  std::string AAPipeline;
+  bool VerifyEachPass;
+  bool DebugLogging;
+};
+} // end anonymous namespace
+
+SmallString<0>
+ParallelFunctionPipelinePass::optimizePartition(StringRef BC,
+                                                TargetMachine *PartTM) const {
+  LLVMContext Ctx;
+  Expected<std::unique_ptr<Module>> MOrErr =
+      parseBitcodeFile(MemoryBufferRef(BC, "<function-pipeline-partition>"),
+                       Ctx);
+  if (!MOrErr)
+    report_fatal_error("Failed to read partition bitcode");
+  std::unique_ptr<Module> MPart = std::move(*MOrErr);
+
+  PassBuilder PB(PartTM);
+  AAManager AA;
+  if (!PB.parseAAPipeline(AA, AAPipeline))
+    report_fatal_error("Failed to parse AA pipeline");
+
+  LoopAnalysisManager LAM(DebugLogging);
+  FunctionAnalysisManager FAM(DebugLogging);
+  CGSCCAnalysisManager CGAM(DebugLogging);
+  ModuleAnalysisManager MAM(DebugLogging);
+  FAM.registerPass([&] { return std::move(AA); });
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+  FunctionPassManager FPM(DebugLogging);
+  if (!PB.parsePassPipeline(FPM, PassPipeline, VerifyEachPass, DebugLogging))
+    report_fatal_error("Failed to parse function pass pipeline");
+  ModulePassManager MPM(DebugLogging);
+  MPM.addPass(createModuleToFunctionPassAdaptor(std::move(FPM)));
+  MPM.run(*MPart, MAM);
+
+  SmallString<0> Result;
+  raw_svector_ostream OS(Result);
+  WriteBitcodeToFile(MPart.get(), OS, /*ShouldPreserveUseListOrder=*/true);
+  return Result;
+}
+
+/// Moves every global value named in \p Order to the end of \p List in that
+/// order, followed by the values the pipeline created.
+template <typename ListT>
+static void restoreOrder(Module &M, ListT &List,
+                         const std::vector<std::string> &Order) {
+  typedef typename ListT::value_type ValueT;
+  StringSet<> Known;
+  for (const std::string &Name : Order)
+    Known.insert(Name);
+  std::vector<ValueT *> Created;
+  for (ValueT &V : List)
+    if (!Known.count(V.getName()))
+      Created.push_back(&V);
+
+  for (const std::string &Name : Order)
+    if (auto *V = dyn_cast_or_null<ValueT>(M.getNamedValue(Name)))
+      List.splice(List.end(), List, V->getIterator());
+  for (ValueT *V : Created)
+    List.splice(List.end(), List, V->getIterator());
+}
+
+/// Deletes all global definitions, named metadata and module inline asm from
+/// \p M. Declarations are kept: the linker would drop the ones no partition
+/// refers to any more, while a function pipeline never deletes them.
+static void clearModule(Module &M) {
+  while (!M.named_metadata_empty())
+    M.eraseNamedMetadata(&*M.named_metadata_begin());
+  M.setModuleInlineAsm("");
+
+  // Dropping the references turns every definition into a declaration.
+  std::vector<GlobalObject *> Definitions;
+  for (Function &F : M)
+    if (!F.isDeclaration())
+      Definitions.push_back(&F);
+  for (GlobalVariable &GV : M.globals())
+    if (!GV.isDeclaration())
+      Definitions.push_back(&GV);
+
+  M.dropAllReferences();
+  for (GlobalValue &GV : M.global_values())
+    GV.removeDeadConstantUsers();
+  while (!M.ifunc_empty())
+    M.ifunc_begin()->eraseFromParent();
+  while (!M.alias_empty())
+    M.alias_begin()->eraseFromParent();
+  for (GlobalObject *GO : Definitions)
+    GO->eraseFromParent();
+}
+
+namespace {
+/// Maps the global values an initializer of the original module refers to onto
+/// the ones of the same name in a partition, declaring those the partition
+/// does not have yet. New global variable declarations are appended to
+/// \p Declarations.
+class PartitionMaterializer final : public ValueMaterializer {
+  Module &MPart;
+  std::vector<GlobalVariable *> &Declarations;
+
+public:
+  PartitionMaterializer(Module &MPart,
+                        std::vector<GlobalVariable *> &Declarations)
+      : MPart(MPart), Declarations(Declarations) {}
+
+  Value *materialize(Value *V) override {
+    auto *GV = dyn_cast<GlobalValue>(V);
+    if (!GV)
+      return nullptr;
+    if (GlobalValue *Existing = MPart.getNamedValue(GV->getName()))
+      return Existing;
+    if (auto *FTy = dyn_cast<FunctionType>(GV->getValueType()))
+      return Function::Create(FTy, GlobalValue::ExternalLinkage, GV->getName(),
+                              &MPart);
+    auto *Decl = new GlobalVariable(
+        MPart, GV->getValueType(), /*isConstant=*/false,
+        GlobalValue::ExternalLinkage, nullptr, GV->getName(), nullptr,
+        GV->getThreadLocalMode(), GV->getType()->getAddressSpace());
+    Declarations.push_back(Decl);
+    return Decl;
+  }
+};
+} // end anonymous namespace
+
+/// Turns the declarations in \p MPart of constant global variables defined in
+/// \p M into available_externally definitions with the same initializer, and
+/// returns their names. The globals those initializers refer to are declared
+/// and imported in turn.
+static std::vector<std::string> importConstants(const Module &M,
+                                                Module &MPart) {
+  std::vector<GlobalVariable *> Declarations;
+  for (GlobalVariable &GV : MPart.globals())
+    if (GV.isDeclaration())
+      Declarations.push_back(&GV);
+
+  std::vector<std::string> Imported;
+  ValueToValueMapTy VMap;
+  PartitionMaterializer Materializer(MPart, Declarations);
+  for (unsigned I = 0; I != Declarations.size(); ++I) {
+    GlobalVariable *GV = Declarations[I];
+    const GlobalVariable *Def =
+        M.getGlobalVariable(GV->getName(), /*AllowInternal=*/true);
+    if (!Def || !Def->isConstant() || !Def->hasDefinitiveInitializer() ||
+        Def->hasAppendingLinkage())
+      continue;
+    GV->setInitializer(cast<Constant>(MapValue(
+        Def->getInitializer(), VMap, RF_None, nullptr, &Materializer)));
+    GV->setLinkage(GlobalValue::AvailableExternallyLinkage);
+    GV->setConstant(true);
+    Imported.push_back(GV->getName());
+  }
+  return Imported;
+}
+
+/// Turns the copies made by importConstants back into declarations, leaving
+/// the partition which defines each of them as the only one to do so.
+static void dropImportedConstants(Module &MPart,
+                                  const std::vector<std::string> &Imported) {
+  for (const std::string &Name : Imported)
+    if (GlobalVariable *GV =
+            MPart.getGlobalVariable(Name, /*AllowInternal=*/true)) {
+      GV->setInitializer(nullptr);
+      GV->setLinkage(GlobalValue::ExternalLinkage);
+    }
+}
+
+PreservedAnalyses ParallelFunctionPipelinePass::run(Module &M,
+                                                    ModuleAnalysisManager &) {
+  StringMap<GlobalValue::LinkageTypes> LocalLinkage;
+  StringSet<> AppendingNames;
+  std::vector<std::string> FunctionOrder, GlobalOrder, AliasOrder, IFuncOrder;
+  for (GlobalValue &GV : M.global_values()) {
+    if (GV.hasLocalLinkage())
+      LocalLinkage[GV.getName()] = GV.getLinkage();
+    if (GV.hasAppendingLinkage())
+      AppendingNames.insert(GV.getName());
+  }
+  for (Function &F : M)
+    FunctionOrder.push_back(F.getName());
+  for (GlobalVariable &GV : M.globals())
+    GlobalOrder.push_back(GV.getName());
+  for (GlobalAlias &GA : M.aliases())
+    AliasOrder.push_back(GA.getName());
+  for (GlobalIFunc &GI : M.ifuncs())
+    IFuncOrder.push_back(GI.getName());
+
+  std::vector<SmallString<0>> Results(ThreadCount);
+  std::vector<std::vector<std::string>> Imported(ThreadCount);
+  std::vector<std::unique_ptr<TargetMachine>> PartTMs;
+  // Create ThreadPool in nested scope so that threads will be joined
+  // on destruction.
+  {
+    ThreadPool Pool(ThreadCount);
+    unsigned PartIdx = 0;
+    SplitModule(CloneModule(&M), ThreadCount,
+                [&](std::unique_ptr<Module> MPart) {
+                  // Only the partition that keeps the llvm.global_ctors style
+                  // definitions may mention them; a leftover declaration
+                  // cannot be linked with the appending definition.
+                  for (auto I = MPart->global_begin(),
+                            E = MPart->global_end();
+                       I != E;) {
+                    GlobalVariable &GV = *I++;
+                    if (GV.isDeclaration() && GV.use_empty() &&
+                        AppendingNames.count(GV.getName()))
+                      GV.eraseFromParent();
+                  }
+                  Imported[PartIdx] = importConstants(M, *MPart);
+
+                  SmallString<0> BC;
+                  raw_svector_ostream BCOS(BC);
+                  WriteBitcodeToFile(MPart.get(), BCOS,
+                                     /*ShouldPreserveUseListOrder=*/true);
+
+                  // Target machines cache subtargets and are not safe to
+                  // share between threads.
+                  TargetMachine *PartTM = nullptr;
+                  if (TM) {
+                    PartTMs.emplace_back(TM->getTarget().createTargetMachine(
+                        TM->getTargetTriple().str(), TM->getTargetCPU(),
+                        TM->getTargetFeatureString(), TM->Options,
+                        TM->getRelocationModel(), TM->getCodeModel(),
+                        TM->getOptLevel()));
+                    PartTM = PartTMs.back().get();
+                  }
+
+                  SmallString<0> *Result = &Results[PartIdx++];
+                  Pool.async(
+                      [this, PartTM, Result](const SmallString<0> &BC) {
+                        *Result = optimizePartition(BC, PartTM);
+                      },
+                      // Pass BC using std::move to ensure that it gets moved
+                      // rather than copied into the thread's context.
+                      std::move(BC));
+                },
+                /*PreserveLocals=*/false);
+  }
+
+  clearModule(M);
+  Linker L(M);
+  for (unsigned I = 0; I != ThreadCount; ++I) {
+    Expected<std::unique_ptr<Module>> MOrErr = parseBitcodeFile(
+        MemoryBufferRef(Results[I], "<function-pipeline-partition>"),
+        M.getContext());
+    if (!MOrErr)
+      report_fatal_error("Failed to read optimized partition bitcode");
+    std::unique_ptr<Module> MPart = std::move(*MOrErr);
+    dropImportedConstants(*MPart, Imported[I]);
+
+    // Every partition carries a copy of the module-level named metadata; keep
+    // the one from the first partition.
+    if (I != 0)
+      while (!MPart->named_metadata_empty())
+        MPart->eraseNamedMetadata(&*MPart->named_metadata_begin());
+
+    // Each definition lives in exactly one partition, so always take it.
+    // Otherwise unreferenced linkonce definitions would be dropped.
+    if (L.linkInModule(std::move(MPart), Linker::OverrideFromSrc))
+      report_fatal_error("Failed to link optimized partitions");
+  }
+
+  for (const auto &Entry : LocalLinkage)
+    if (GlobalValue *GV = M.getNamedValue(Entry.getKey())) {
+      GV->setVisibility(GlobalValue::DefaultVisibility);
+      GV->setLinkage(Entry.getValue());
+    }
+
+  restoreOrder(M, M.getFunctionList(), FunctionOrder);
+  restoreOrder(M, M.getGlobalList(), GlobalOrder);
+  restoreOrder(M, M.getAliasList(), AliasOrder);
+  restoreOrder(M, M.getIFuncList(), IFuncOrder);
+
+  return PreservedAnalyses::none();
+}
+
 #ifdef LINK_POLLY_INTO_TOOLS
 namespace polly {
 void RegisterPollyPasses(PassBuilder &);
@@ -229,7 +585,42 @@ bool llvm::runPassPipeline(StringRef Arg0, Module &M, TargetMachine *TM,
   if (VK > VK_NoVerifier)
     MPM.addPass(VerifierPass());
 
-  if (!PB.parsePassPipeline(MPM, PassPipeline, VerifyEachPass, DebugPM)) {
+  if (!FunctionCacheDir.empty()) {
+    FunctionPassManager FPM(DebugPM);
+    if (!PB.parsePassPipeline(FPM, PassPipeline, VerifyEachPass, DebugPM)) {
+      errs() << Arg0 << ": -function-cache-dir requires a function pass "
+                        "pipeline.\n";
+      return false;
+    }
+    if (Error E = parseCachePruningPolicy(FunctionCachePolicy).takeError()) {
+      errs() << Arg0 << ": " << toString(std::move(E)) << "\n";
+      return false;
+    }
+    // Cached functions are only valid for the same pipeline, target and
+    // compiler.
+    std::string PipelineKey =
+        (Twine(LLVM_VERSION_STRING) + "\n" + PassPipeline + "\n" + AAPipeline)
+            .str();
+    if (TM)
+      PipelineKey += (Twine("\n") + TM->getTargetTriple().str() + "\n" +
+                      TM->getTargetCPU() + "\n" +
+                      TM->getTargetFeatureString())
+                         .str();
+    MPM.addPass(FunctionCachePass(FunctionCacheDir, FunctionCachePolicy,
+                                  PipelineKey, std::move(FPM)));
+  } else if (FunctionPipelineThreads > 1 && !OptRemarkFile &&
+      ParallelFunctionPipelinePass::canSplit(M)) {
+    FunctionPassManager FPM;
+    if (!PB.parsePassPipeline(FPM, PassPipeline)) {
+      errs() << Arg0 << ": -function-pipeline-threads requires a function "
+                        "pass pipeline.\n";
+      return false;
+    }
+    MPM.addPass(ParallelFunctionPipelinePass(FunctionPipelineThreads, TM,
+                                             PassPipeline, AAPipeline,
+                                             VerifyEachPass, DebugPM));
+  } else if (!PB.parsePassPipeline(MPM, PassPipeline, VerifyEachPass,
+                                   DebugPM)) {
     errs() << Arg0 << ": unable to parse pass pipeline description.\n";
     return false;
   }
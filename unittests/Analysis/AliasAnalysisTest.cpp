@@ -11,9 +11,11 @@
 #include "llvm/ADT/SetVector.h"
 #include "llvm/Analysis/AssumptionCache.h"
 #include "llvm/Analysis/BasicAliasAnalysis.h"
+#include "llvm/Analysis/CaptureInfo.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/AsmParser/Parser.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/LLVMContext.h"
@@ -205,6 +207,97 @@ TEST_F(AliasAnalysisTest, getModRefInfo) {
   EXPECT_EQ(AA.getModRefInfo(AtomicRMW, None), MRI_ModRef);
 }
 
+TEST_F(AliasAnalysisTest, BatchAAScope) {
+  SMDiagnostic Err;
+  std::unique_ptr<Module> Mod = parseAssemblyString(R"(
+    declare void @external(i32*)
+
+    define void @f(i32* %p, i64 %i) {
+      %a = alloca [4 x i32]
+      %a0 = getelementptr [4 x i32], [4 x i32]* %a, i64 0, i64 0
+      %a1 = getelementptr [4 x i32], [4 x i32]* %a, i64 0, i64 1
+      %ai = getelementptr [4 x i32], [4 x i32]* %a, i64 0, i64 %i
+      %p1 = getelementptr i32, i32* %p, i64 1
+      call void @external(i32* %p)
+      ret void
+    }
+  )", Err, C);
+  ASSERT_TRUE(Mod);
+  Function *F = Mod->getFunction("f");
+  auto &AA = getAAResults(*F);
+
+  SmallVector<MemoryLocation, 8> Locs;
+  Instruction *Call = nullptr;
+  for (Instruction &I : instructions(*F)) {
+    if (I.getType()->isPointerTy())
+      Locs.push_back(MemoryLocation(&I, 4));
+    else if (isa<CallInst>(I))
+      Call = &I;
+  }
+  Locs.push_back(MemoryLocation(&*F->arg_begin(), 4));
+
+  SmallVector<AliasResult, 32> Unbatched;
+  SmallVector<ModRefInfo, 8> UnbatchedMR;
+  for (const MemoryLocation &A : Locs) {
+    UnbatchedMR.push_back(AA.getModRefInfo(Call, A));
+    for (const MemoryLocation &B : Locs)
+      Unbatched.push_back(AA.alias(A, B));
+  }
+
+  // Asking twice within a batch, the second time from the batch caches, gives
+  // the same results.
+  BatchAAScope Batch(AA);
+  for (int Round = 0; Round != 2; ++Round) {
+    unsigned I = 0, J = 0;
+    for (const MemoryLocation &A : Locs) {
+      EXPECT_EQ(UnbatchedMR[J++], AA.getModRefInfo(Call, A));
+      for (const MemoryLocation &B : Locs)
+        EXPECT_EQ(Unbatched[I++], AA.alias(A, B));
+    }
+  }
+}
+
+TEST_F(AliasAnalysisTest, CaptureInfo) {
+  SMDiagnostic Err;
+  std::unique_ptr<Module> Mod = parseAssemblyString(R"(
+    @g = global i32* null
+
+    define void @f(i32** %pp) {
+      %a = alloca i32
+      %p = load i32*, i32** %pp
+      ret void
+    }
+  )", Err, C);
+  ASSERT_TRUE(Mod);
+  Function *F = Mod->getFunction("f");
+  auto I = F->getEntryBlock().begin();
+  Instruction *A = &*I++;
+  Instruction *P = &*I++;
+  Instruction *Ret = &*I++;
+
+  DominatorTree DT(*F);
+  CaptureInfo CI(DT);
+  AC.reset(new AssumptionCache(*F));
+  BasicAAResult BAA(Mod->getDataLayout(), TLI, *AC, &DT, nullptr, &CI);
+  AAResults AA(TLI);
+  AA.addAAResult(BAA);
+
+  MemoryLocation LocA(A, 4), LocP(P, 4);
+  {
+    BatchAAScope Batch(AA);
+    EXPECT_EQ(NoAlias, AA.alias(LocA, LocP));
+  }
+
+  // Capture %a without telling CaptureInfo. The next batch must not trust
+  // what it remembers.
+  new StoreInst(A, Mod->getNamedGlobal("g"), Ret);
+  EXPECT_EQ(MayAlias, AA.alias(LocA, LocP));
+  {
+    BatchAAScope Batch(AA);
+    EXPECT_EQ(MayAlias, AA.alias(LocA, LocP));
+  }
+}
+
 class AAPassInfraTest : public testing::Test {
 protected:
   LLVMContext C;
@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Analysis/ValueTracking.h"
+#include "llvm/Analysis/KnownBitsCache.h"
 #include "llvm/AsmParser/Parser.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/InstIterator.h"
@@ -258,3 +259,132 @@ TEST(ValueTracking, ComputeNumSignBits_PR32045) {
       cast<ReturnInst>(F->getEntryBlock().getTerminator())->getOperand(0);
   EXPECT_EQ(ComputeNumSignBits(RVal, M->getDataLayout()), 1u);
 }
+
+TEST(ValueTracking, KnownBitsCache) {
+  StringRef Assembly = "define i32 @f(i32 %a) { "
+                       "  %x = and i32 %a, 15 "
+                       "  %y = shl i32 %x, 4 "
+                       "  %z = or i32 %y, 1 "
+                       "  %s = sext i32 %z to i64 "
+                       "  ret i32 %z "
+                       "} ";
+
+  LLVMContext Context;
+  SMDiagnostic Error;
+  auto M = parseAssemblyString(Assembly, Error, Context);
+  assert(M && "Bad assembly?");
+
+  auto *F = M->getFunction("f");
+  assert(F && "Bad assembly?");
+  auto I = F->getEntryBlock().begin();
+  Instruction *X = &*I++;
+  Instruction *Y = &*I++;
+  Instruction *Z = &*I++;
+  Instruction *S = &*I++;
+  const DataLayout &DL = M->getDataLayout();
+
+  KnownBitsCache Cache(DL);
+  KnownBits Known = Cache.computeKnownBits(Z);
+  KnownBits Expected = computeKnownBits(Z, DL);
+  EXPECT_EQ(Expected.Zero, Known.Zero);
+  EXPECT_EQ(Expected.One, Known.One);
+  EXPECT_EQ(0xffffff0eu, Known.Zero.getZExtValue());
+  EXPECT_EQ(1u, Known.One.getZExtValue());
+  EXPECT_TRUE(Cache.isKnownNonZero(Z));
+  EXPECT_EQ(ComputeNumSignBits(S, DL), Cache.ComputeNumSignBits(S));
+
+  // The operands looked at on the way are cached as well.
+  EXPECT_NE(nullptr, Cache.lookupKnownBits(X, Z, 1));
+  EXPECT_NE(nullptr, Cache.lookupKnownBits(Y, Z, 1));
+
+  // Entries of replaced and deleted values are dropped.
+  unsigned NumEntries = Cache.getNumEntries();
+  Y->replaceAllUsesWith(UndefValue::get(Y->getType()));
+  EXPECT_EQ(nullptr, Cache.lookupKnownBits(Y, Z, 1));
+  EXPECT_GT(NumEntries, Cache.getNumEntries());
+  S->eraseFromParent();
+  EXPECT_EQ(0u, Cache.lookupNumSignBits(S, S, 1));
+
+  Cache.clear();
+  EXPECT_EQ(0u, Cache.getNumEntries());
+  EXPECT_EQ(nullptr, Cache.lookupKnownBits(Z, Z, 1));
+}
+
+TEST(ValueTracking, KnownBitsCacheReplaceOperand) {
+  StringRef Assembly = "define i32 @f(i32 %a, i32 %b) { "
+                       "  %x = and i32 %a, 15 "
+                       "  %y = shl i32 %x, 4 "
+                       "  %z = or i32 %y, 1 "
+                       "  %w = and i32 %b, 255 "
+                       "  ret i32 %z "
+                       "} ";
+
+  LLVMContext Context;
+  SMDiagnostic Error;
+  auto M = parseAssemblyString(Assembly, Error, Context);
+  assert(M && "Bad assembly?");
+
+  auto *F = M->getFunction("f");
+  assert(F && "Bad assembly?");
+  auto I = F->getEntryBlock().begin();
+  Instruction *X = &*I++;
+  Instruction *Y = &*I++;
+  Instruction *Z = &*I++;
+  Instruction *W = &*I++;
+  const DataLayout &DL = M->getDataLayout();
+
+  KnownBitsCache Cache(DL);
+  EXPECT_EQ(0xffffff0eu, Cache.computeKnownBits(Z).Zero.getZExtValue());
+
+  // Replacing an operand drops what was computed from it by its users.
+  Y->replaceAllUsesWith(W);
+  KnownBits Known = Cache.computeKnownBits(Z);
+  KnownBits Expected = computeKnownBits(Z, DL);
+  EXPECT_EQ(Expected.Zero, Known.Zero);
+  EXPECT_EQ(Expected.One, Known.One);
+  EXPECT_EQ(0xffffff00u, Known.Zero.getZExtValue());
+
+  // So does forgetting one.
+  Cache.clear();
+  EXPECT_EQ(0xffffff0fu, Cache.computeKnownBits(Y).Zero.getZExtValue());
+  Cache.forgetValue(X);
+  EXPECT_EQ(nullptr, Cache.lookupKnownBits(Y, Y, 1));
+  EXPECT_EQ(0u, Cache.getNumEntries());
+}
+
+TEST(ValueTracking, KnownBitsCacheForgetManyUsers) {
+  std::string Assembly = "define i32 @f(i32 %a, i32 %b) {\n"
+                         "  %x = and i32 %a, 255\n"
+                         "  %w = and i32 %b, 7\n";
+  for (unsigned I = 0; I != 100; ++I)
+    Assembly += "  %u" + std::to_string(I) + " = or i32 %x, 1\n";
+  Assembly += "  ret i32 %w\n}\n";
+
+  LLVMContext Context;
+  SMDiagnostic Error;
+  auto M = parseAssemblyString(Assembly, Error, Context);
+  assert(M && "Bad assembly?");
+
+  auto *F = M->getFunction("f");
+  assert(F && "Bad assembly?");
+  auto I = F->getEntryBlock().begin();
+  Instruction *X = &*I++;
+  Instruction *W = &*I++;
+  Instruction *U = &*I;
+  const DataLayout &DL = M->getDataLayout();
+
+  KnownBitsCache Cache(DL);
+  for (Instruction &Inst : F->getEntryBlock())
+    if (Inst.getType()->isIntegerTy())
+      Cache.computeKnownBits(&Inst);
+  unsigned NumEntries = Cache.getNumEntries();
+
+  // Forgetting a value with few users only drops their entries.
+  Cache.forgetValue(U);
+  EXPECT_GT(NumEntries, Cache.getNumEntries());
+  EXPECT_NE(nullptr, Cache.lookupKnownBits(W, W, 1));
+
+  // One with more users than the walk looks at drops everything.
+  Cache.forgetValue(X);
+  EXPECT_EQ(0u, Cache.getNumEntries());
+}
@@ -17,6 +17,7 @@
 #include "llvm/IR/Module.h"
 #include "llvm/Support/SourceMgr.h"
 #include "gtest/gtest.h"
+#include <thread>
 
 namespace llvm {
 namespace {
@@ -477,5 +478,45 @@ TEST(ConstantsTest, BitcastToGEP) {
             Instruction::BitCast);
 }
 
+#if LLVM_ENABLE_THREADS
+TEST(ConstantsTest, ConcurrentUniquing) {
+  LLVMContext Context;
+  Context.enableConcurrentUniquing();
+  EXPECT_TRUE(Context.isConcurrentUniquingEnabled());
+  Module M("M", Context);
+  Type *Int64Ty = Type::getInt64Ty(Context);
+  auto *G = new GlobalVariable(M, Int64Ty, false, GlobalValue::ExternalLinkage,
+                               nullptr, "g");
+
+  // Every thread creates the same types and constants, in a different order.
+  const unsigned NumThreads = 4, NumConstants = 500;
+  std::vector<std::vector<const void *>> Results(NumThreads);
+  std::vector<std::thread> Threads;
+  for (unsigned T = 0; T != NumThreads; ++T)
+    Threads.emplace_back([&, T] {
+      std::vector<const void *> &R = Results[T];
+      R.resize(6 * NumConstants);
+      for (unsigned J = 0; J != NumConstants; ++J) {
+        unsigned I = (J + T * NumConstants / NumThreads) % NumConstants;
+        IntegerType *ITy = IntegerType::get(Context, 1 + I % 100);
+        ArrayType *ATy = ArrayType::get(ITy, I);
+        Constant *CI = ConstantInt::get(ITy, I);
+        R[6 * I] = ITy;
+        R[6 * I + 1] = PointerType::get(ATy, I % 4);
+        R[6 * I + 2] = CI;
+        R[6 * I + 3] = ConstantFP::get(Type::getDoubleTy(Context), I);
+        R[6 * I + 4] = ConstantArray::get(ArrayType::get(ITy, 2), {CI, CI});
+        Constant *GI = ConstantExpr::getPtrToInt(G, Int64Ty);
+        R[6 * I + 5] = ConstantExpr::getAdd(GI, ConstantInt::get(Int64Ty, I));
+      }
+    });
+  for (std::thread &T : Threads)
+    T.join();
+
+  for (unsigned T = 1; T != NumThreads; ++T)
+    EXPECT_EQ(Results[0], Results[T]);
+}
+#endif
+
 }  // end anonymous namespace
 }  // end namespace llvm
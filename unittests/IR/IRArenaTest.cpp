@@ -0,0 +1,106 @@
+//===- llvm/unittest/IR/IRArenaTest.cpp - IRArena unit tests --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/IRArena.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "gtest/gtest.h"
+#include <memory>
+
+using namespace llvm;
+
+namespace {
+
+static Function *buildFunction(Module &M) {
+  LLVMContext &Ctx = M.getContext();
+  Type *I32 = Type::getInt32Ty(Ctx);
+  Function *F = Function::Create(FunctionType::get(I32, {I32}, false),
+                                 GlobalValue::ExternalLinkage, "f", &M);
+  BasicBlock *Entry = BasicBlock::Create(Ctx, "entry", F);
+  BasicBlock *Exit = BasicBlock::Create(Ctx, "exit", F);
+  IRBuilder<> B(Entry);
+  Value *Sum = B.CreateAdd(&*F->arg_begin(), B.getInt32(42));
+  B.CreateBr(Exit);
+  B.SetInsertPoint(Exit);
+  PHINode *Phi = B.CreatePHI(I32, 1);
+  Phi->addIncoming(Sum, Entry);
+  B.CreateRet(B.CreateMul(Phi, ConstantExpr::getAdd(B.getInt32(1),
+                                                    B.getInt32(2))));
+  return F;
+}
+
+TEST(IRArenaTest, NoActiveArena) {
+  EXPECT_EQ(nullptr, IRArena::getCurrent());
+  EXPECT_EQ(nullptr, IRArena::allocate(16));
+}
+
+TEST(IRArenaTest, ScopesNest) {
+  IRArena A, B;
+  {
+    IRArena::Scope SA(&A);
+    EXPECT_EQ(&A, IRArena::getCurrent());
+    {
+      IRArena::Scope SB(&B);
+      EXPECT_EQ(&B, IRArena::getCurrent());
+      {
+        IRArena::Scope None(nullptr);
+        EXPECT_EQ(nullptr, IRArena::getCurrent());
+      }
+      EXPECT_EQ(&B, IRArena::getCurrent());
+    }
+    EXPECT_EQ(&A, IRArena::getCurrent());
+  }
+  EXPECT_EQ(nullptr, IRArena::getCurrent());
+}
+
+TEST(IRArenaTest, AllocatesInstructions) {
+  LLVMContext Ctx;
+  IRArena Arena;
+  auto M = llvm::make_unique<Module>("M", Ctx);
+  {
+    IRArena::Scope S(&Arena);
+    buildFunction(*M);
+  }
+  EXPECT_GT(Arena.getBytesAllocated(), 0u);
+  EXPECT_EQ(Arena.getBytesAllocated(), Arena.getLiveBytes());
+  EXPECT_FALSE(Arena.reset());
+
+  // Only the function, its blocks and instructions came from the arena; the
+  // constants stay alive in the context after the module is gone.
+  M.reset();
+  EXPECT_EQ(0u, Arena.getLiveBytes());
+  EXPECT_TRUE(Arena.reset());
+  EXPECT_EQ(0u, Arena.getBytesAllocated());
+}
+
+TEST(IRArenaTest, ObjectsOutliveScope) {
+  LLVMContext Ctx;
+  IRArena Arena;
+  Module M("M", Ctx);
+  Function *F;
+  {
+    IRArena::Scope S(&Arena);
+    F = buildFunction(M);
+  }
+  // Instructions created after the scope come from the heap and can be mixed
+  // freely with the arena-allocated ones.
+  IRBuilder<> B(&F->getEntryBlock(), F->getEntryBlock().begin());
+  B.CreateAdd(&*F->arg_begin(), B.getInt32(7));
+  EXPECT_EQ(3u, F->getEntryBlock().size());
+
+  size_t Live = Arena.getLiveBytes();
+  F->getEntryBlock().front().eraseFromParent();
+  EXPECT_EQ(Live, Arena.getLiveBytes());
+  F->eraseFromParent();
+  EXPECT_EQ(0u, Arena.getLiveBytes());
+}
+
+} // end anonymous namespace
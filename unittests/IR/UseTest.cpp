@@ -109,4 +109,35 @@ TEST(UseTest, reverse) {
   ASSERT_EQ(8u, I);
 }
 
+TEST(UseTest, getUserAfterGrowingOperands) {
+  LLVMContext C;
+
+  const char *ModuleString = "define i32 @f(i32 %x) {\n"
+                             "entry:\n"
+                             "  br label %exit\n"
+                             "exit:\n"
+                             "  %p = phi i32 [ %x, %entry ]\n"
+                             "  ret i32 %p\n"
+                             "}\n";
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M = parseAssemblyString(ModuleString, Err, C);
+  Function *F = M->getFunction("f");
+  ASSERT_TRUE(F);
+  Argument &X = *F->arg_begin();
+  auto *PN = cast<PHINode>(&F->back().front());
+
+  // Adding incoming values reallocates the hung-off operand list a few times.
+  for (unsigned I = 0; I != 100; ++I)
+    PN->addIncoming(&X, &F->front());
+  ASSERT_EQ(101u, PN->getNumOperands());
+  for (const Use &U : PN->operands())
+    EXPECT_EQ(PN, U.getUser());
+  unsigned NumUses = 0;
+  for (User *U : X.users()) {
+    EXPECT_EQ(PN, U);
+    ++NumUses;
+  }
+  EXPECT_EQ(101u, NumUses);
+}
+
 } // end anonymous namespace
@@ -8,10 +8,15 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Analysis/DomTreeUpdater.h"
+#include "llvm/Analysis/PostDominators.h"
+#include "llvm/AsmParser/Parser.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -95,3 +100,87 @@ TEST(Local, RemoveDuplicatePHINodes) {
   EXPECT_TRUE(EliminateDuplicatePHINodes(BB));
   EXPECT_EQ(3U, BB->size());
 }
+
+static std::unique_ptr<Module> parseIR(LLVMContext &C, const char *IR) {
+  SMDiagnostic Err;
+  std::unique_ptr<Module> Mod = parseAssemblyString(IR, Err, C);
+  if (!Mod)
+    Err.print("UtilsTests", errs());
+  return Mod;
+}
+
+static const char *DomTreeUpdaterIR = R"(
+    define i32 @f(i32 %x) {
+    entry:
+      br i1 true, label %live, label %dead
+    live:
+      switch i32 1, label %exit [
+        i32 0, label %dead2
+        i32 1, label %exit
+      ]
+    dead:
+      br label %dead2
+    dead2:
+      %p = phi i32 [ 1, %dead ], [ 2, %live ]
+      br label %exit
+    exit:
+      %r = phi i32 [ 0, %live ], [ 0, %live ], [ %p, %dead2 ]
+      ret i32 %r
+    }
+  )";
+
+TEST(Local, DomTreeUpdaterEager) {
+  LLVMContext C;
+  std::unique_ptr<Module> M = parseIR(C, DomTreeUpdaterIR);
+  ASSERT_TRUE(M);
+  Function &F = *M->getFunction("f");
+  DominatorTree DT(F);
+  PostDominatorTree PDT;
+  PDT.recalculate(F);
+  DomTreeUpdater DTU(&DT, &PDT, DomTreeUpdater::UpdateStrategy::Eager);
+
+  BasicBlock *Entry = &F.getEntryBlock();
+  EXPECT_TRUE(ConstantFoldTerminator(Entry, true, nullptr, &DTU));
+  EXPECT_TRUE(DT.verify());
+  EXPECT_TRUE(PDT.verify());
+
+  BasicBlock *Live = Entry->getSingleSuccessor();
+  ASSERT_TRUE(Live);
+  EXPECT_TRUE(ConstantFoldTerminator(Live, true, nullptr, &DTU));
+  EXPECT_TRUE(DT.verify());
+  EXPECT_TRUE(PDT.verify());
+
+  EXPECT_TRUE(removeUnreachableBlocks(F, nullptr, &DTU));
+  EXPECT_FALSE(DTU.hasPendingUpdates());
+  EXPECT_EQ(3u, F.size());
+  EXPECT_TRUE(DT.verify());
+  EXPECT_TRUE(PDT.verify());
+}
+
+TEST(Local, DomTreeUpdaterLazy) {
+  LLVMContext C;
+  std::unique_ptr<Module> M = parseIR(C, DomTreeUpdaterIR);
+  ASSERT_TRUE(M);
+  Function &F = *M->getFunction("f");
+  DominatorTree DT(F);
+  PostDominatorTree PDT;
+  PDT.recalculate(F);
+  DomTreeUpdater DTU(&DT, &PDT, DomTreeUpdater::UpdateStrategy::Lazy);
+
+  BasicBlock *Entry = &F.getEntryBlock();
+  BasicBlock *Live = Entry->getTerminator()->getSuccessor(0);
+  EXPECT_TRUE(ConstantFoldTerminator(Entry, true, nullptr, &DTU));
+  EXPECT_TRUE(ConstantFoldTerminator(Live, true, nullptr, &DTU));
+  EXPECT_TRUE(DTU.hasPendingUpdates());
+
+  // The dead blocks are kept until the trees are up to date.
+  EXPECT_TRUE(removeUnreachableBlocks(F, nullptr, &DTU));
+  EXPECT_EQ(5u, F.size());
+  EXPECT_FALSE(removeUnreachableBlocks(F, nullptr, &DTU));
+
+  EXPECT_TRUE(DTU.getDomTree().verify());
+  EXPECT_EQ(5u, F.size());
+  EXPECT_TRUE(DTU.getPostDomTree().verify());
+  EXPECT_FALSE(DTU.hasPendingUpdates());
+  EXPECT_EQ(3u, F.size());
+}